@@ -49,6 +49,11 @@ void Body::ApplyImpulseAngular(const Vec3& impulse)
 	// dw = I^-1 * ( r x J )
 	angularVelocity += GetInverseInertiaTensorWorldSpace() * impulse;
 
+	ClampAngularVelocity();
+}
+
+void Body::ClampAngularVelocity()
+{
 	// Clamp angular velocity - for performances reasons
 	// -- 30 rad per seconds, sufficient for now
 	const float maxAngularSpeed = 30.0f;
@@ -84,16 +89,14 @@ void Body::ApplyImpulse(const Vec3& impulsePoint, const Vec3& impulse)
 
 Mat3 Body::GetInverseInertiaTensorBodySpace() const
 {
-	Mat3 inertiaTensor = shape->InertiaTensor();
-	Mat3 inverseInertiaTensor = inertiaTensor.Inverse() * inverseMass;
+	Mat3 inverseInertiaTensor = shape->GetInverseInertiaTensor() * inverseMass;
 
 	return inverseInertiaTensor;
 }
 
 Mat3 Body::GetInverseInertiaTensorWorldSpace() const
 {
-	Mat3 inertiaTensor = shape->InertiaTensor();
-	Mat3 inverseInertiaTensor = inertiaTensor.Inverse() * inverseMass;
+	Mat3 inverseInertiaTensor = shape->GetInverseInertiaTensor() * inverseMass;
 	Mat3 orient = orientation.ToMat3();
 
 	inverseInertiaTensor = orient * inverseInertiaTensor * orient.Transpose();
@@ -116,11 +119,18 @@ void Body::Update(const float dt_sec)
 	// Texternal = 0 because it was applied in the collision response function
 	// T = Ia = w x I * w
 	// a = I^-1 (w x I * w)
+	// The inverse of R * I * R^T is R * I^-1 * R^T, so the cached inverse can be reused
 	Mat3 orientationMat = orientation.ToMat3();
-	Mat3 inertiaTensor = orientationMat	* shape->InertiaTensor() * orientationMat.Transpose();
-	Vec3 alpha = inertiaTensor.Inverse() * (angularVelocity.Cross(inertiaTensor * angularVelocity));
+	Mat3 orientationMatT = orientationMat.Transpose();
+	Mat3 inertiaTensor = orientationMat	* shape->GetInertiaTensor() * orientationMatT;
+	Mat3 inverseInertiaTensor = orientationMat * shape->GetInverseInertiaTensor() * orientationMatT;
+	Vec3 alpha = inverseInertiaTensor * (angularVelocity.Cross(inertiaTensor * angularVelocity));
 	angularVelocity += alpha * dt_sec;
 
+	// The explicit precession term feeds itself on long thin shapes,
+	// it gets the same clamp as impulses so it can't diverge
+	ClampAngularVelocity();
+
 	// Update orientation
 	Vec3 dAngle = angularVelocity * dt_sec;
 	Quat dq = Quat(dAngle, dAngle.GetMagnitude());
@@ -15,7 +15,7 @@ public:
 	Vec3 linearVelocity;
 	Vec3 angularVelocity;
 
-	Shape* shape;
+	const Shape* shape;
 
 	Vec3 GetCenterOfMassWorldSpace() const;
 	Vec3 GetCenterOfMassBodySpace() const;
@@ -26,6 +26,7 @@ public:
 	void ApplyImpulseLinear(const Vec3& impulse);
 	void ApplyImpulseAngular(const Vec3& impulse);
 	void ApplyImpulse(const Vec3& impulsePoint, const Vec3& impulse);
+	void ClampAngularVelocity();
 
 	Mat3 GetInverseInertiaTensorBodySpace() const;
 	Mat3 GetInverseInertiaTensorWorldSpace() const;
@@ -0,0 +1,328 @@
+#include "Intersections.h"
+#include <float.h>
+
+
+/// <summary>
+/// World space center, axes and half extents of a box body
+/// </summary>
+struct OrientedBox
+{
+	Vec3 center;
+	Vec3 axes[3];
+	float halfExtents[3];
+
+	OrientedBox(const Body& body)
+	{
+		const ShapeBox* box = static_cast<const ShapeBox*>(body.shape);
+
+		// The rows of the orientation matrix are the body axes in world space
+		const Mat3 orient = body.orientation.ToMat3();
+		center = body.GetCenterOfMassWorldSpace();
+		for (int i = 0; i < 3; ++i) {
+			axes[i] = orient.rows[i];
+			halfExtents[i] = box->halfExtents[i];
+		}
+	}
+
+	float ProjectedRadius(const Vec3& axis) const
+	{
+		return
+			halfExtents[0] * fabsf(axes[0].Dot(axis)) +
+			halfExtents[1] * fabsf(axes[1].Dot(axis)) +
+			halfExtents[2] * fabsf(axes[2].Dot(axis));
+	}
+};
+
+// Enough room for a quad clipped by four planes
+static const int MAX_CLIP_POINTS = 16;
+
+// A face axis is only given up for an edge axis (or the face of b for the face of a)
+// when it is noticeably shallower, so the manifold doesn't flicker between
+// nearly equivalent features from frame to frame
+static const float AXIS_RELATIVE_TOLERANCE = 0.95f;
+static const float AXIS_ABSOLUTE_TOLERANCE = 0.01f;
+
+static float Sign(const float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+static void FillContact(Body& a, Body& b, const Vec3& ptOnA, const Vec3& ptOnB, const Vec3& normal, const float separation, Contact& contact)
+{
+	contact.a = &a;
+	contact.b = &b;
+	contact.ptOnAWorldSpace = ptOnA;
+	contact.ptOnBWorldSpace = ptOnB;
+	contact.ptOnALocalSpace = a.WorldSpaceToBodySpace(ptOnA);
+	contact.ptOnBLocalSpace = b.WorldSpaceToBodySpace(ptOnB);
+	contact.normal = normal;
+	contact.separationDistance = separation;
+	contact.timeOfImpact = 0.0f;
+}
+
+/// <summary>
+/// Sutherland-Hodgman clip of a polygon against the half space (p - origin).dir <= offset
+/// </summary>
+static int ClipPolygon(const Vec3* in, const int numIn, const Vec3& origin, const Vec3& dir, const float offset, Vec3* out)
+{
+	int numOut = 0;
+	for (int i = 0; i < numIn; ++i)
+	{
+		const Vec3& p0 = in[i];
+		const Vec3& p1 = in[(i + 1) % numIn];
+		const float d0 = (p0 - origin).Dot(dir) - offset;
+		const float d1 = (p1 - origin).Dot(dir) - offset;
+
+		if (d0 <= 0.0f) {
+			out[numOut++] = p0;
+		}
+		if ((d0 < 0.0f && d1 > 0.0f) || (d0 > 0.0f && d1 < 0.0f)) {
+			const float t = d0 / (d0 - d1);
+			out[numOut++] = p0 + (p1 - p0) * t;
+		}
+	}
+
+	return numOut;
+}
+
+/// <summary>
+/// Clip the face of the incident box that faces the reference face against the side planes
+/// of the reference face, and keep the points below it.
+/// refNormal is the outward normal of the reference face, points go out as (on reference, on incident).
+/// </summary>
+static int ClipFaces(const OrientedBox& ref, const int refAxis, const Vec3& refNormal, const OrientedBox& inc, Vec3* ptsOnRef, Vec3* ptsOnInc, float* separations, const int maxPoints)
+{
+	const Vec3 refCenter = ref.center + refNormal * ref.halfExtents[refAxis];
+
+	// Incident face: the face of the other box most anti-parallel to the reference normal
+	int incAxis = 0;
+	float maxDot = -1.0f;
+	for (int i = 0; i < 3; ++i) {
+		const float dot = fabsf(inc.axes[i].Dot(refNormal));
+		if (dot > maxDot) {
+			maxDot = dot;
+			incAxis = i;
+		}
+	}
+	const Vec3 incNormal = inc.axes[incAxis] * -Sign(inc.axes[incAxis].Dot(refNormal));
+	const Vec3 incCenter = inc.center + incNormal * inc.halfExtents[incAxis];
+
+	const int i1 = (incAxis + 1) % 3;
+	const int i2 = (incAxis + 2) % 3;
+	const Vec3 e1 = inc.axes[i1] * inc.halfExtents[i1];
+	const Vec3 e2 = inc.axes[i2] * inc.halfExtents[i2];
+
+	Vec3 polygon[MAX_CLIP_POINTS];
+	Vec3 clipped[MAX_CLIP_POINTS];
+	polygon[0] = incCenter + e1 + e2;
+	polygon[1] = incCenter - e1 + e2;
+	polygon[2] = incCenter - e1 - e2;
+	polygon[3] = incCenter + e1 - e2;
+	int numPoints = 4;
+
+	// Side planes of the reference face
+	const int r1 = (refAxis + 1) % 3;
+	const int r2 = (refAxis + 2) % 3;
+	numPoints = ClipPolygon(polygon, numPoints, refCenter, ref.axes[r1], ref.halfExtents[r1], clipped);
+	numPoints = ClipPolygon(clipped, numPoints, refCenter, ref.axes[r1] * -1.0f, ref.halfExtents[r1], polygon);
+	numPoints = ClipPolygon(polygon, numPoints, refCenter, ref.axes[r2], ref.halfExtents[r2], clipped);
+	numPoints = ClipPolygon(clipped, numPoints, refCenter, ref.axes[r2] * -1.0f, ref.halfExtents[r2], polygon);
+
+	int numContacts = 0;
+	for (int i = 0; i < numPoints && numContacts < maxPoints; ++i)
+	{
+		const float separation = (polygon[i] - refCenter).Dot(refNormal);
+		if (separation > 0.0f) continue;
+
+		ptsOnInc[numContacts] = polygon[i];
+		ptsOnRef[numContacts] = polygon[i] - refNormal * separation;
+		separations[numContacts] = separation;
+		++numContacts;
+	}
+
+	return numContacts;
+}
+
+int Intersections::IntersectBoxBox(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	const OrientedBox boxA(a);
+	const OrientedBox boxB(b);
+	const Vec3 d = boxB.center - boxA.center;
+
+	//v Separating axis test =========================================
+	// Face axes of a (0 to 2) and b (3 to 5)
+	float bestFaceSeparation[2] = { -FLT_MAX, -FLT_MAX };
+	int bestFaceAxis[2] = { 0, 0 };
+	for (int box = 0; box < 2; ++box) {
+		const OrientedBox& owner = (box == 0) ? boxA : boxB;
+		for (int i = 0; i < 3; ++i) {
+			const Vec3& axis = owner.axes[i];
+			const float separation = fabsf(d.Dot(axis)) - boxA.ProjectedRadius(axis) - boxB.ProjectedRadius(axis);
+			if (separation > 0.0f) return IntersectSwept(context, a, b, dt, contacts, maxContacts);
+
+			if (separation > bestFaceSeparation[box]) {
+				bestFaceSeparation[box] = separation;
+				bestFaceAxis[box] = i;
+			}
+		}
+	}
+
+	// Edge axes, skipping (nearly) parallel edges whose cross product carries no direction
+	float bestEdgeSeparation = -FLT_MAX;
+	int bestEdgeA = 0;
+	int bestEdgeB = 0;
+	Vec3 bestEdgeAxis;
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			Vec3 axis = boxA.axes[i].Cross(boxB.axes[j]);
+			const float length = axis.GetMagnitude();
+			if (length < 1e-5f) continue;
+			axis *= 1.0f / length;
+
+			const float separation = fabsf(d.Dot(axis)) - boxA.ProjectedRadius(axis) - boxB.ProjectedRadius(axis);
+			if (separation > 0.0f) return IntersectSwept(context, a, b, dt, contacts, maxContacts);
+
+			if (separation > bestEdgeSeparation) {
+				bestEdgeSeparation = separation;
+				bestEdgeA = i;
+				bestEdgeB = j;
+				bestEdgeAxis = axis;
+			}
+		}
+	}
+	//^ Separating axis test =========================================
+
+	// Separations are negative here, the largest one is the shallowest penetration
+	const bool isFaceB = bestFaceSeparation[1] > AXIS_RELATIVE_TOLERANCE * bestFaceSeparation[0] + AXIS_ABSOLUTE_TOLERANCE;
+	const float faceSeparation = isFaceB ? bestFaceSeparation[1] : bestFaceSeparation[0];
+	const bool isEdge = bestEdgeSeparation > AXIS_RELATIVE_TOLERANCE * faceSeparation + AXIS_ABSOLUTE_TOLERANCE;
+
+	//v Edge-edge: a single contact between the closest points of the two edges
+	if (isEdge)
+	{
+		const Vec3 normal = bestEdgeAxis * Sign(d.Dot(bestEdgeAxis));
+
+		// Support edges, along the normal for a and against it for b
+		Vec3 edgeA = boxA.center;
+		Vec3 edgeB = boxB.center;
+		for (int k = 0; k < 3; ++k) {
+			if (k != bestEdgeA) {
+				edgeA += boxA.axes[k] * (boxA.halfExtents[k] * Sign(boxA.axes[k].Dot(normal)));
+			}
+			if (k != bestEdgeB) {
+				edgeB -= boxB.axes[k] * (boxB.halfExtents[k] * Sign(boxB.axes[k].Dot(normal)));
+			}
+		}
+
+		// Closest points between the two edge lines, clamped to the edges
+		const Vec3& dirA = boxA.axes[bestEdgeA];
+		const Vec3& dirB = boxB.axes[bestEdgeB];
+		const Vec3 r = edgeA - edgeB;
+		const float dirDot = dirA.Dot(dirB);
+		const float c = dirA.Dot(r);
+		const float f = dirB.Dot(r);
+		const float denom = 1.0f - dirDot * dirDot;
+
+		float s = (denom > 1e-6f) ? (dirDot * f - c) / denom : 0.0f;
+		const float maxS = boxA.halfExtents[bestEdgeA];
+		s = (s < -maxS) ? -maxS : ((s > maxS) ? maxS : s);
+
+		float t = dirDot * s + f;
+		const float maxT = boxB.halfExtents[bestEdgeB];
+		t = (t < -maxT) ? -maxT : ((t > maxT) ? maxT : t);
+
+		FillContact(a, b, edgeA + dirA * s, edgeB + dirB * t, normal, bestEdgeSeparation, contacts[0]);
+		return 1;
+	}
+	//^ Edge-edge
+
+	//v Face: clip the incident face against the reference face
+	const OrientedBox& ref = isFaceB ? boxB : boxA;
+	const OrientedBox& inc = isFaceB ? boxA : boxB;
+	const int refAxis = isFaceB ? bestFaceAxis[1] : bestFaceAxis[0];
+
+	const Vec3 axis = ref.axes[refAxis];
+	const Vec3 normal = axis * Sign(d.Dot(axis));
+	const Vec3 refNormal = isFaceB ? normal * -1.0f : normal;
+
+	Vec3 ptsOnRef[MAX_CONTACTS_PER_PAIR];
+	Vec3 ptsOnInc[MAX_CONTACTS_PER_PAIR];
+	float separations[MAX_CONTACTS_PER_PAIR];
+	const int maxPoints = (maxContacts < MAX_CONTACTS_PER_PAIR) ? maxContacts : MAX_CONTACTS_PER_PAIR;
+	const int numContacts = ClipFaces(ref, refAxis, refNormal, inc, ptsOnRef, ptsOnInc, separations, maxPoints);
+
+	for (int i = 0; i < numContacts; ++i) {
+		const Vec3& ptOnA = isFaceB ? ptsOnInc[i] : ptsOnRef[i];
+		const Vec3& ptOnB = isFaceB ? ptsOnRef[i] : ptsOnInc[i];
+		FillContact(a, b, ptOnA, ptOnB, normal, separations[i], contacts[i]);
+	}
+	//^ Face
+
+	return numContacts;
+}
+
+int Intersections::IntersectSphereBox(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	const float radius = static_cast<const ShapeSphere*>(a.shape)->radius;
+	const Vec3 sphereCenter = a.GetCenterOfMassWorldSpace();
+	const OrientedBox box(b);
+
+	// Sphere center in the frame of the box, and the closest point of the box to it
+	const Vec3 delta = sphereCenter - box.center;
+	float local[3];
+	float closest[3];
+	bool isInside = true;
+	for (int i = 0; i < 3; ++i) {
+		local[i] = delta.Dot(box.axes[i]);
+		closest[i] = local[i];
+		if (closest[i] > box.halfExtents[i]) {
+			closest[i] = box.halfExtents[i];
+			isInside = false;
+		}
+		else if (closest[i] < -box.halfExtents[i]) {
+			closest[i] = -box.halfExtents[i];
+			isInside = false;
+		}
+	}
+
+	Vec3 ptOnBox;
+	Vec3 boxToSphere;
+	float distance;
+	if (!isInside)
+	{
+		ptOnBox = box.center + box.axes[0] * closest[0] + box.axes[1] * closest[1] + box.axes[2] * closest[2];
+		boxToSphere = sphereCenter - ptOnBox;
+
+		const float distanceSqr = boxToSphere.GetLengthSqr();
+		if (distanceSqr > radius * radius) return IntersectSwept(context, a, b, dt, contacts, maxContacts);
+
+		distance = sqrtf(distanceSqr);
+		boxToSphere *= 1.0f / distance;
+	}
+	else
+	{
+		// Center inside the box, push out through the nearest face
+		int axis = 0;
+		float minDepth = FLT_MAX;
+		for (int i = 0; i < 3; ++i) {
+			const float depth = box.halfExtents[i] - fabsf(local[i]);
+			if (depth < minDepth) {
+				minDepth = depth;
+				axis = i;
+			}
+		}
+
+		boxToSphere = box.axes[axis] * Sign(local[axis]);
+		ptOnBox = sphereCenter + boxToSphere * minDepth;
+		distance = -minDepth;
+	}
+
+	const Vec3 ptOnSphere = sphereCenter - boxToSphere * radius;
+	FillContact(a, b, ptOnSphere, ptOnBox, boxToSphere * -1.0f, distance - radius, contacts[0]);
+
+	return 1;
+}
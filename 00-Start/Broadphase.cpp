@@ -1,17 +1,24 @@
 #include "Broadphase.h"
 #include "code/Math/Bounds.h"
 #include "Shape.h"
+#include "ShapeBatch.h"
 
 
 int CompareSAP(const void* a, const void* b) {
 	const PseudoBody* ea = (const PseudoBody*)a;
 	const PseudoBody* eb = (const PseudoBody*)b;
 
-	if (ea->value < eb->value) {
-		return -1;
+	if (ea->value != eb->value) {
+		return (ea->value < eb->value) ? -1 : 1;
 	}
 
-	return 1;
+	// Ties go to a fixed order, so the pairs come out the same whatever qsort does with equal keys.
+	// Mins first: bounds that only touch still pair up.
+	if (ea->ismin != eb->ismin) {
+		return ea->ismin ? -1 : 1;
+	}
+
+	return ea->id - eb->id;
 }
 
 void SortBodiesBounds(const Body* bodies, const size_t num,	PseudoBody* sortedArray, const float dt_sec)
@@ -19,15 +26,27 @@ void SortBodiesBounds(const Body* bodies, const size_t num,	PseudoBody* sortedAr
 	Vec3 axis = Vec3(1, 1, 1);
 	axis.Normalize();
 
+	// Gather the bounds one shape type at a time
+	ShapeBatches batches;
+	batches.Build(bodies, (int)num);
+
+	std::vector<Bounds> bodyBounds(num);
+	GetBoundsBatched(bodies, batches, bodyBounds.data());
+
 	for (int i = 0; i < num; i++)
 	{
 		const Body& body = bodies[i];
-		Bounds bounds = body.shape->GetBounds(body.position, body.orientation);
+		Bounds bounds = bodyBounds[i];
 
 		// Expand the bounds by the linear velocity
 		bounds.Expand(bounds.mins + body.linearVelocity * dt_sec);
 		bounds.Expand(bounds.maxs + body.linearVelocity * dt_sec);
 
+		// And by how far a point can travel while the body spins, so fast spinners still get paired
+		const float angularSweep = body.angularVelocity.GetMagnitude() * body.shape->GetBoundingRadius() * dt_sec;
+		bounds.Expand(bounds.mins - Vec3(angularSweep));
+		bounds.Expand(bounds.maxs + Vec3(angularSweep));
+
 		const float epsilon = 0.01f;
 		bounds.Expand(bounds.mins + Vec3(-1, -1, -1) * epsilon);
 		bounds.Expand(bounds.maxs + Vec3(1, 1, 1) * epsilon);
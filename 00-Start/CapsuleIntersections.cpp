@@ -0,0 +1,273 @@
+#include "Intersections.h"
+#include <math.h>
+
+
+// Segments closer to parallel than this, as the squared sine of their angle,
+// lie along each other and touch at both ends of their overlap
+static const float PARALLEL_SIN_SQR = 0.001f;
+
+// The sweep stops this close to the time of impact, and gives up after so many steps
+static const float SWEEP_DISTANCE_TOLERANCE = 0.001f;
+static const int SWEEP_MAX_ITERATIONS = 32;
+
+static float Clamp01(const float x)
+{
+	return fminf(fmaxf(x, 0.0f), 1.0f);
+}
+
+static void FillContact(Body& a, Body& b, const Vec3& ptOnA, const Vec3& ptOnB, const Vec3& normal, const float separation, Contact& contact)
+{
+	contact.a = &a;
+	contact.b = &b;
+	contact.ptOnAWorldSpace = ptOnA;
+	contact.ptOnBWorldSpace = ptOnB;
+	contact.ptOnALocalSpace = a.WorldSpaceToBodySpace(ptOnA);
+	contact.ptOnBLocalSpace = b.WorldSpaceToBodySpace(ptOnB);
+	contact.normal = normal;
+	contact.separationDistance = separation;
+	contact.timeOfImpact = 0.0f;
+}
+
+//v Closest points ========================================================
+/// <summary>
+/// Closest point of the segment ab to p
+/// </summary>
+static Vec3 ClosestPointOnSegment(const Vec3& p, const Vec3& a, const Vec3& b)
+{
+	const Vec3 ab = b - a;
+	const float lengthSqr = ab.GetLengthSqr();
+	if (lengthSqr < 1e-12f) return a;
+
+	return a + ab * Clamp01((p - a).Dot(ab) / lengthSqr);
+}
+
+/// <summary>
+/// Closest points of the segments p1q1 and p2q2, either of which may be a single point
+/// (Ericson, Real-Time Collision Detection 5.1.9)
+/// </summary>
+static void ClosestPointsSegmentSegment(const Vec3& p1, const Vec3& q1, const Vec3& p2, const Vec3& q2, Vec3& c1, Vec3& c2)
+{
+	const float epsilon = 1e-12f;
+
+	const Vec3 d1 = q1 - p1;
+	const Vec3 d2 = q2 - p2;
+	const Vec3 r = p1 - p2;
+	const float a = d1.Dot(d1);
+	const float e = d2.Dot(d2);
+	const float f = d2.Dot(r);
+
+	float s = 0.0f;
+	float t = 0.0f;
+	if (a <= epsilon && e <= epsilon) {
+		// Both are points
+	}
+	else if (a <= epsilon) {
+		t = Clamp01(f / e);
+	}
+	else {
+		const float c = d1.Dot(r);
+		if (e <= epsilon) {
+			s = Clamp01(-c / a);
+		}
+		else {
+			// Closest points of the infinite lines, clamped to the first segment,
+			// then the second one, then the first one again if that moved the second
+			const float b = d1.Dot(d2);
+			const float denom = a * e - b * b;
+			s = (denom > 0.0f) ? Clamp01((b * f - c * e) / denom) : 0.0f;
+			t = (b * s + f) / e;
+			if (t < 0.0f) {
+				t = 0.0f;
+				s = Clamp01(-c / a);
+			}
+			else if (t > 1.0f) {
+				t = 1.0f;
+				s = Clamp01((b - c) / a);
+			}
+		}
+	}
+
+	c1 = p1 + d1 * s;
+	c2 = p2 + d2 * t;
+}
+//^ Closest points ========================================================
+
+/// <summary>
+/// Segment at the core of a sphere or a capsule, in world space, and the radius around it
+/// </summary>
+static float GetCore(const Body& body, Vec3& p0, Vec3& p1)
+{
+	if (body.shape->GetType() == Shape::ShapeType::SHAPE_CAPSULE) {
+		const ShapeCapsule* capsule = static_cast<const ShapeCapsule*>(body.shape);
+		capsule->GetSegment(body.position, body.orientation, p0, p1);
+		return capsule->radius;
+	}
+
+	p0 = body.GetCenterOfMassWorldSpace();
+	p1 = p0;
+	return static_cast<const ShapeSphere*>(body.shape)->radius;
+}
+
+/// <summary>
+/// Contact between the closest points of two cores. When the cores cross the direction
+/// between them is meaningless, fallback goes from a to b instead.
+/// </summary>
+static void FillCoreContact(Body& a, Body& b, const Vec3& ptOnCoreA, const Vec3& ptOnCoreB, const float radiusA, const float radiusB, const Vec3& fallback, Contact& contact)
+{
+	const Vec3 delta = ptOnCoreB - ptOnCoreA;
+	const float distance = delta.GetMagnitude();
+	const Vec3 normal = (distance > 1e-6f) ? delta / distance : fallback;
+
+	FillContact(a, b, ptOnCoreA + normal * radiusA, ptOnCoreB - normal * radiusB, normal, distance - radiusA - radiusB, contact);
+}
+
+static Vec3 CrossingNormal(const Body& a, const Body& b, const Vec3& axisA, const Vec3& axisB)
+{
+	Vec3 normal = axisA.Cross(axisB);
+	if (normal.GetLengthSqr() < 1e-12f) {
+		Vec3 u, v;
+		(axisA.GetLengthSqr() > 1e-12f ? axisA : Vec3(0.0f, 0.0f, 1.0f)).GetOrtho(u, v);
+		normal = u;
+	}
+	normal.Normalize();
+
+	if (normal.Dot(b.position - a.position) < 0.0f) {
+		normal *= -1.0f;
+	}
+	return normal;
+}
+
+/// <summary>
+/// Time of impact of two spheres or capsules, by conservative advancement as in
+/// Intersections::ConservativeAdvance but on the closed form distance of their cores,
+/// so each step costs a few dot products instead of a GJK run.
+/// The cores only move at |w| times their half length on top of the linear velocity.
+/// </summary>
+static int SweepCores(Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+	if (!Intersections::NeedsContinuous(a, dt) && !Intersections::NeedsContinuous(b, dt)) return 0;
+
+	Body bodyA = a;
+	Body bodyB = b;
+
+	Vec3 p0, p1;
+	GetCore(a, p0, p1);
+	const float angularSpeedA = a.angularVelocity.GetMagnitude() * (p1 - p0).GetMagnitude() * 0.5f;
+	GetCore(b, p0, p1);
+	const float angularSpeedB = b.angularVelocity.GetMagnitude() * (p1 - p0).GetMagnitude() * 0.5f;
+
+	float toi = 0.0f;
+	for (int i = 0; i < SWEEP_MAX_ITERATIONS; ++i) {
+		Vec3 pA0, pA1, pB0, pB1;
+		const float radiusA = GetCore(bodyA, pA0, pA1);
+		const float radiusB = GetCore(bodyB, pB0, pB1);
+
+		Vec3 ptOnCoreA, ptOnCoreB;
+		ClosestPointsSegmentSegment(pA0, pA1, pB0, pB1, ptOnCoreA, ptOnCoreB);
+
+		const Vec3 delta = ptOnCoreB - ptOnCoreA;
+		const float coreDistance = delta.GetMagnitude();
+		const float distance = coreDistance - radiusA - radiusB;
+
+		if (distance < SWEEP_DISTANCE_TOLERANCE) {
+			// Overlapping from the start is the discrete kernels' business
+			if (i == 0) return 0;
+
+			Contact& contact = contacts[0];
+			FillCoreContact(bodyA, bodyB, ptOnCoreA, ptOnCoreB, radiusA, radiusB, CrossingNormal(bodyA, bodyB, pA1 - pA0, pB1 - pB0), contact);
+			contact.a = &a;
+			contact.b = &b;
+			contact.timeOfImpact = toi;
+			return 1;
+		}
+
+		const Vec3 normal = delta / coreDistance;
+		const float closingSpeed = (bodyA.linearVelocity - bodyB.linearVelocity).Dot(normal) + angularSpeedA + angularSpeedB;
+		if (closingSpeed <= 0.0f) return 0;
+
+		const float step = distance / closingSpeed;
+		if (toi + step > dt) return 0;
+
+		toi += step;
+		bodyA.Update(step);
+		bodyB.Update(step);
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Closest point of the capsule's segment to the sphere's center
+/// </summary>
+int Intersections::IntersectSphereCapsule(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	const float radiusA = static_cast<const ShapeSphere*>(a.shape)->radius;
+	const Vec3 center = a.GetCenterOfMassWorldSpace();
+
+	Vec3 p0, p1;
+	const float radiusB = GetCore(b, p0, p1);
+	const Vec3 ptOnSegment = ClosestPointOnSegment(center, p0, p1);
+
+	const float radii = radiusA + radiusB;
+	if ((ptOnSegment - center).GetLengthSqr() > radii * radii) {
+		return SweepCores(a, b, dt, contacts, maxContacts);
+	}
+
+	FillCoreContact(a, b, center, ptOnSegment, radiusA, radiusB, CrossingNormal(a, b, p1 - p0, Vec3(0.0f)), contacts[0]);
+	return 1;
+}
+
+/// <summary>
+/// Closest points of the two segments. Capsules lying along each other get a contact
+/// at each end of the overlap of their segments, a single one would let them roll.
+/// </summary>
+int Intersections::IntersectCapsuleCapsule(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	Vec3 pA0, pA1, pB0, pB1;
+	const float radiusA = GetCore(a, pA0, pA1);
+	const float radiusB = GetCore(b, pB0, pB1);
+
+	Vec3 ptOnCoreA, ptOnCoreB;
+	ClosestPointsSegmentSegment(pA0, pA1, pB0, pB1, ptOnCoreA, ptOnCoreB);
+
+	const float radii = radiusA + radiusB;
+	if ((ptOnCoreB - ptOnCoreA).GetLengthSqr() > radii * radii) {
+		return SweepCores(a, b, dt, contacts, maxContacts);
+	}
+
+	const Vec3 axisA = pA1 - pA0;
+	const Vec3 axisB = pB1 - pB0;
+	const Vec3 fallback = CrossingNormal(a, b, axisA, axisB);
+
+	const float lengthSqrA = axisA.GetLengthSqr();
+	const float lengthSqrB = axisB.GetLengthSqr();
+	const bool isParallel = axisA.Cross(axisB).GetLengthSqr() <= PARALLEL_SIN_SQR * lengthSqrA * lengthSqrB;
+	if (isParallel && maxContacts >= 2 && lengthSqrA > 1e-12f && lengthSqrB > 1e-12f) {
+		// Overlap of the segments, as parameters along a
+		const float t0 = Clamp01((pB0 - pA0).Dot(axisA) / lengthSqrA);
+		const float t1 = Clamp01((pB1 - pA0).Dot(axisA) / lengthSqrA);
+
+		int numContacts = 0;
+		if (fabsf(t1 - t0) * sqrtf(lengthSqrA) > SWEEP_DISTANCE_TOLERANCE) {
+			const float ends[2] = { t0, t1 };
+			for (int i = 0; i < 2; ++i) {
+				const Vec3 endOnA = pA0 + axisA * ends[i];
+				const Vec3 endOnB = ClosestPointOnSegment(endOnA, pB0, pB1);
+
+				FillCoreContact(a, b, endOnA, endOnB, radiusA, radiusB, fallback, contacts[numContacts]);
+				if (contacts[numContacts].separationDistance <= 0.0f) {
+					++numContacts;
+				}
+			}
+		}
+		if (numContacts > 0) return numContacts;
+	}
+
+	FillCoreContact(a, b, ptOnCoreA, ptOnCoreB, radiusA, radiusB, fallback, contacts[0]);
+	return 1;
+}
@@ -0,0 +1,84 @@
+#include "CompoundBVH.h"
+#include <algorithm>
+
+
+// Median splits keep the tree balanced, so this is enough for millions of children
+static const int MAX_STACK_DEPTH = 64;
+
+//v Build =================================================================
+void CompoundBVH::Build(const std::vector<Bounds>& childBounds)
+{
+	nodes.clear();
+	if (childBounds.empty()) return;
+
+	std::vector<BuildChild> buildChildren(childBounds.size());
+	for (int i = 0; i < childBounds.size(); ++i) {
+		buildChildren[i].bounds = childBounds[i];
+		buildChildren[i].centroid = (childBounds[i].mins + childBounds[i].maxs) * 0.5f;
+		buildChildren[i].index = i;
+	}
+
+	// A binary tree over n leaves has 2n - 1 nodes
+	nodes.reserve(2 * buildChildren.size() - 1);
+	BuildNode(buildChildren, 0, (int)buildChildren.size());
+}
+
+void CompoundBVH::BuildNode(std::vector<BuildChild>& buildChildren, const int begin, const int end)
+{
+	const int nodeIdx = (int)nodes.size();
+	nodes.push_back(Node());
+
+	Bounds nodeBounds;
+	Bounds centroidBounds;
+	for (int i = begin; i < end; ++i) {
+		nodeBounds.Expand(buildChildren[i].bounds);
+		centroidBounds.Expand(buildChildren[i].centroid);
+	}
+	nodes[nodeIdx].bounds = nodeBounds;
+
+	if (end - begin == 1) {
+		nodes[nodeIdx].data = -buildChildren[begin].index - 1;
+		return;
+	}
+
+	const Vec3 extent = centroidBounds.maxs - centroidBounds.mins;
+	const int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : ((extent.y >= extent.z) ? 1 : 2);
+	const int mid = begin + (end - begin) / 2;
+	std::nth_element(buildChildren.data() + begin, buildChildren.data() + mid, buildChildren.data() + end, [axis](const BuildChild& lhs, const BuildChild& rhs) {
+		return lhs.centroid[axis] < rhs.centroid[axis];
+	});
+
+	BuildNode(buildChildren, begin, mid);
+	const int secondChild = (int)nodes.size();
+	BuildNode(buildChildren, mid, end);
+	nodes[nodeIdx].data = secondChild;
+}
+//^ Build =================================================================
+//v Query =================================================================
+int CompoundBVH::Query(const Bounds& box, std::vector<int>& children) const
+{
+	if (nodes.empty()) return 0;
+
+	const int numBefore = (int)children.size();
+
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const int nodeIdx = stack[--stackSize];
+		const Node& node = nodes[nodeIdx];
+		if (!node.bounds.DoesIntersect(box)) continue;
+
+		if (node.IsLeaf()) {
+			children.push_back(node.Child());
+			continue;
+		}
+
+		// First child on top, it is the next node in memory
+		stack[stackSize++] = node.SecondChild();
+		stack[stackSize++] = nodeIdx + 1;
+	}
+
+	return (int)children.size() - numBefore;
+}
+//^ Query =================================================================
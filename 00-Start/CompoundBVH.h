@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include "code/Math/Bounds.h"
+
+
+/// <summary>
+/// Bounding volume hierarchy over the children of a compound shape, in the compound's body space.
+/// Compounds hold tens of children at most, so nodes keep plain float bounds, leaves hold a
+/// single child and the tree is split at the median child along the widest axis.
+/// </summary>
+class CompoundBVH
+{
+public:
+	void Build(const std::vector<Bounds>& childBounds);
+
+	// Appends the children whose bounds overlap the box, in body space,
+	// and returns how many were added
+	int Query(const Bounds& bounds, std::vector<int>& children) const;
+
+	// Root bounds, there must be at least one child
+	const Bounds& GetBounds() const { return nodes[0].bounds; }
+	int NumNodes() const { return (int)nodes.size(); }
+
+private:
+	struct Node
+	{
+		Bounds bounds;
+
+		// Leaves: the child index, negated minus one.
+		// Inner nodes: index of the second child, the first one is the next node.
+		int data;
+
+		bool IsLeaf() const { return data < 0; }
+		int Child() const { return -data - 1; }
+		int SecondChild() const { return data; }
+	};
+
+	struct BuildChild
+	{
+		Bounds bounds;
+		Vec3 centroid;
+		int index;
+	};
+
+	void BuildNode(std::vector<BuildChild>& buildChildren, const int begin, const int end);
+
+	std::vector<Node> nodes;
+};
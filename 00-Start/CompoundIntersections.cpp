@@ -0,0 +1,64 @@
+#include "Intersections.h"
+#include <vector>
+
+
+/// <summary>
+/// Stand-in body for one child of a compound, where the child sits this instant and moving
+/// the way that part of the compound moves. Only the narrowphase ever sees it.
+/// </summary>
+static Body ChildBody(const Body& compound, const CompoundChild& child)
+{
+	Body body = compound;
+	body.shape = child.shape;
+	body.position = compound.position + compound.orientation.RotatePoint(child.position);
+	body.orientation = compound.orientation * child.orientation;
+
+	const Vec3 r = body.GetCenterOfMassWorldSpace() - compound.GetCenterOfMassWorldSpace();
+	body.linearVelocity = compound.linearVelocity + compound.angularVelocity.Cross(r);
+
+	return body;
+}
+
+/// <summary>
+/// Children of b near a, found through the BVH of the compound in its body space, each tested
+/// against a with the kernel of their own pair of shapes. A compound a is walked the same way
+/// from within that kernel, so two compounds only test the children overlapping each other.
+/// Every child's contacts are returned as they are, IntersectPairs reduces them as one manifold.
+/// </summary>
+int Intersections::IntersectCompound(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	const ShapeCompound* compound = static_cast<const ShapeCompound*>(b.shape);
+
+	std::vector<int>& candidates = context.scratch->childCandidates;
+	const int first = (int)candidates.size();
+	const int numCandidates = compound->bvh.Query(BoundsInBodySpace(a, b), candidates);
+
+	// Warm starts are keyed on body addresses, the stand-in bodies have none worth keeping
+	NarrowphaseContext childContext = context;
+	childContext.gjkCache = nullptr;
+
+	int numContacts = 0;
+	for (int i = 0; i < numCandidates && numContacts < maxContacts; ++i) {
+		const CompoundChild& child = compound->children[candidates[first + i]];
+		Body childBody = ChildBody(b, child);
+
+		const int numChildContacts = Intersect(childContext, a, childBody, dt, contacts + numContacts, maxContacts - numContacts);
+
+		// Hand the contacts over to the compound. Swept contacts hold the child's local point at the time
+		// of impact, taken through the child's placement it stays right wherever the compound is then.
+		for (int j = numContacts; j < numContacts + numChildContacts; ++j) {
+			Contact& contact = contacts[j];
+			const Vec3 ptOnChild = child.shape->GetCenterOfMass() + contact.ptOnBLocalSpace;
+
+			contact.b = &b;
+			contact.ptOnBLocalSpace = child.position + child.orientation.RotatePoint(ptOnChild) - compound->GetCenterOfMass();
+		}
+		numContacts += numChildContacts;
+	}
+
+	candidates.resize(first);
+
+	return numContacts;
+}
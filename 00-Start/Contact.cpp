@@ -1,6 +1,10 @@
 #include "Contact.h"
+#include <vector>
 
 
+// Normals closer than this, as the cosine of their angle, belong to the same manifold
+static const float MANIFOLD_NORMAL_COS = 0.95f;
+
 void Contact::ResolveContact(Contact& contact)
 {
 	Body* a = contact.a;
@@ -78,17 +82,438 @@ void Contact::ResolveContact(Contact& contact)
 	}
 }
 
+/// <summary>
+/// Move a body by a position level impulse applied at a world space point,
+/// the same way ApplyImpulse changes its velocities
+/// </summary>
+static void ApplyPositionImpulse(Body* body, const Vec3& point, const Vec3& impulse)
+{
+	if (body->inverseMass == 0.0f) return;
+
+	const Vec3 centerOfMass = body->GetCenterOfMassWorldSpace();
+	const Vec3 dAngle = body->GetInverseInertiaTensorWorldSpace() * (point - centerOfMass).Cross(impulse);
+	const Quat dq = Quat(dAngle, dAngle.GetMagnitude());
+
+	const Vec3 centerOfMassToPosition = body->position - centerOfMass;
+	body->orientation = dq * body->orientation;
+	body->orientation.Normalize();
+	body->position = centerOfMass + impulse * body->inverseMass + dq.RotatePoint(centerOfMassToPosition);
+}
+
+/// <summary>
+/// Resolve contacts that are already touching (time of impact of 0) all together.
+/// Impulses are accumulated and clamped over several iterations, so the points of a manifold,
+/// and the manifolds of a stack, share the load instead of the first contact taking all of it.
+/// </summary>
+void Contact::ResolveContacts(Contact* contacts, const int num, ContactCache* cache)
+{
+	// Approach speeds below this don't bounce, which keeps resting contacts resting
+	const float restitutionThreshold = 0.5f;
+	// Penetration left in place by the positional correction, so touching bodies
+	// are still found touching on the next frame instead of losing their contacts
+	const float penetrationSlop = 0.005f;
+	const int numIterations = 10;
+	// Fraction of the penetration removed by each position pass
+	const float positionCorrection = 0.5f;
+	const int numPositionIterations = 4;
+
+	struct ContactPoint
+	{
+		Vec3 rA;
+		Vec3 rB;
+		Vec3 tangents[2];
+		float normalMass;
+		float tangentMass[2];
+		float bounceVelocity;
+		float friction;
+		float normalImpulse;
+		float tangentImpulse[2];
+	};
+	std::vector<ContactPoint> points(num);
+
+	//v Prepare ======================================================
+	for (int i = 0; i < num; ++i)
+	{
+		const Contact& contact = contacts[i];
+		const Body* a = contact.a;
+		const Body* b = contact.b;
+		ContactPoint& point = points[i];
+
+		const Vec3& n = contact.normal;
+		point.rA = contact.ptOnAWorldSpace - a->GetCenterOfMassWorldSpace();
+		point.rB = contact.ptOnBWorldSpace - b->GetCenterOfMassWorldSpace();
+
+		const Mat3 inverseWorldInertiaA = a->GetInverseInertiaTensorWorldSpace();
+		const Mat3 inverseWorldInertiaB = b->GetInverseInertiaTensorWorldSpace();
+		const float invMass = a->inverseMass + b->inverseMass;
+
+		const Vec3 angularJA = (inverseWorldInertiaA * point.rA.Cross(n)).Cross(point.rA);
+		const Vec3 angularJB = (inverseWorldInertiaB * point.rB.Cross(n)).Cross(point.rB);
+		point.normalMass = 1.0f / (invMass + (angularJA + angularJB).Dot(n));
+
+		n.GetOrtho(point.tangents[0], point.tangents[1]);
+		for (int t = 0; t < 2; ++t) {
+			const Vec3& tangent = point.tangents[t];
+			const Vec3 inertiaA = (inverseWorldInertiaA * point.rA.Cross(tangent)).Cross(point.rA);
+			const Vec3 inertiaB = (inverseWorldInertiaB * point.rB.Cross(tangent)).Cross(point.rB);
+			point.tangentMass[t] = 1.0f / (invMass + (inertiaA + inertiaB).Dot(tangent));
+			point.tangentImpulse[t] = 0.0f;
+		}
+
+		// Relative velocity of b with respect to a, negative along the normal when approaching
+		const Vec3 velA = a->linearVelocity + a->angularVelocity.Cross(point.rA);
+		const Vec3 velB = b->linearVelocity + b->angularVelocity.Cross(point.rB);
+		const float normalVelocity = (velB - velA).Dot(n);
+
+		const float elasticity = a->elasticity * b->elasticity;
+		point.bounceVelocity = (normalVelocity < -restitutionThreshold) ? -elasticity * normalVelocity : 0.0f;
+		point.friction = a->friction * b->friction;
+		point.normalImpulse = 0.0f;
+	}
+	//^ Prepare ======================================================
+	//v Warm start ===================================================
+	if (cache != nullptr)
+	{
+		for (int i = 0; i < num; ++i)
+		{
+			Contact& contact = contacts[i];
+			ContactPoint& point = points[i];
+
+			const ContactCache::Entry* entry = cache->Find(contact);
+			if (entry == nullptr) continue;
+
+			point.normalImpulse = entry->normalImpulse;
+			point.tangentImpulse[0] = entry->tangentImpulse.Dot(point.tangents[0]);
+			point.tangentImpulse[1] = entry->tangentImpulse.Dot(point.tangents[1]);
+
+			const Vec3 impulse = contact.normal * point.normalImpulse + point.tangents[0] * point.tangentImpulse[0] + point.tangents[1] * point.tangentImpulse[1];
+			contact.a->ApplyImpulse(contact.ptOnAWorldSpace, impulse * -1.0f);
+			contact.b->ApplyImpulse(contact.ptOnBWorldSpace, impulse);
+		}
+	}
+	//^ Warm start ===================================================
+	//v Iterate ======================================================
+	for (int iteration = 0; iteration < numIterations; ++iteration)
+	{
+		for (int i = 0; i < num; ++i)
+		{
+			Contact& contact = contacts[i];
+			Body* a = contact.a;
+			Body* b = contact.b;
+			ContactPoint& point = points[i];
+			const Vec3& n = contact.normal;
+
+			// Normal impulse, the accumulated impulse may only push
+			Vec3 velAB = (b->linearVelocity + b->angularVelocity.Cross(point.rB)) - (a->linearVelocity + a->angularVelocity.Cross(point.rA));
+			float lambda = point.normalMass * (point.bounceVelocity - velAB.Dot(n));
+			const float normalImpulse = (point.normalImpulse + lambda > 0.0f) ? point.normalImpulse + lambda : 0.0f;
+			lambda = normalImpulse - point.normalImpulse;
+			point.normalImpulse = normalImpulse;
+
+			a->ApplyImpulse(contact.ptOnAWorldSpace, n * -lambda);
+			b->ApplyImpulse(contact.ptOnBWorldSpace, n * lambda);
+
+			// Friction impulses, bounded by the normal impulse (Coulomb)
+			const float maxFriction = point.friction * point.normalImpulse;
+			for (int t = 0; t < 2; ++t)
+			{
+				const Vec3& tangent = point.tangents[t];
+				velAB = (b->linearVelocity + b->angularVelocity.Cross(point.rB)) - (a->linearVelocity + a->angularVelocity.Cross(point.rA));
+				lambda = -point.tangentMass[t] * velAB.Dot(tangent);
+
+				float tangentImpulse = point.tangentImpulse[t] + lambda;
+				tangentImpulse = (tangentImpulse < -maxFriction) ? -maxFriction : ((tangentImpulse > maxFriction) ? maxFriction : tangentImpulse);
+				lambda = tangentImpulse - point.tangentImpulse[t];
+				point.tangentImpulse[t] = tangentImpulse;
+
+				a->ApplyImpulse(contact.ptOnAWorldSpace, tangent * -lambda);
+				b->ApplyImpulse(contact.ptOnBWorldSpace, tangent * lambda);
+			}
+		}
+	}
+	//^ Iterate ======================================================
+
+	if (cache != nullptr)
+	{
+		cache->Clear();
+		for (int i = 0; i < num; ++i) {
+			const ContactPoint& point = points[i];
+			const Vec3 tangentImpulse = point.tangents[0] * point.tangentImpulse[0] + point.tangents[1] * point.tangentImpulse[1];
+			cache->Store(contacts[i], point.normalImpulse, tangentImpulse);
+		}
+	}
+
+	//v Positional correction ========================================
+	// Position level impulses along the normal, which move and rotate the bodies.
+	// Points are recomputed from their local positions on every pass, so once a manifold point
+	// has moved the bodies apart, the other points of the manifold don't push them apart again.
+	for (int iteration = 0; iteration < numPositionIterations; ++iteration)
+	{
+		for (int i = 0; i < num; ++i)
+		{
+			Contact& contact = contacts[i];
+			Body* a = contact.a;
+			Body* b = contact.b;
+			const Vec3& n = contact.normal;
+
+			const Vec3 ptOnA = a->BodySpaceToWorldSpace(contact.ptOnALocalSpace);
+			const Vec3 ptOnB = b->BodySpaceToWorldSpace(contact.ptOnBLocalSpace);
+			const float depth = (ptOnA - ptOnB).Dot(n) - penetrationSlop;
+			if (depth <= 0.0f) continue;
+
+			const Vec3 rA = ptOnA - a->GetCenterOfMassWorldSpace();
+			const Vec3 rB = ptOnB - b->GetCenterOfMassWorldSpace();
+			const Vec3 angularJA = (a->GetInverseInertiaTensorWorldSpace() * rA.Cross(n)).Cross(rA);
+			const Vec3 angularJB = (b->GetInverseInertiaTensorWorldSpace() * rB.Cross(n)).Cross(rB);
+			const float effectiveMass = a->inverseMass + b->inverseMass + (angularJA + angularJB).Dot(n);
+			if (effectiveMass == 0.0f) continue;
+
+			const Vec3 impulse = n * (positionCorrection * depth / effectiveMass);
+			ApplyPositionImpulse(a, ptOnA, impulse * -1.0f);
+			ApplyPositionImpulse(b, ptOnB, impulse);
+		}
+	}
+	//^ Positional correction ========================================
+}
+
 int Contact::CompareContact(const void* p1, const void* p2)
 {
 	const Contact& a = *(Contact*)p1;
-	const Contact& b = *(Contact*)p1;
+	const Contact& b = *(Contact*)p2;
 
 	if (a.timeOfImpact < b.timeOfImpact) {
 		return -1;
 	}
 	else if (a.timeOfImpact == b.timeOfImpact) {
-		return -0;
+		return 0;
 	}
 
 	return 1;
 }
+
+//v Manifold reduction ===================================================
+/// <summary>
+/// Signed area of the triangle abc seen along normal, positive when counter clockwise
+/// </summary>
+static float SignedArea(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& normal)
+{
+	return (b - a).Cross(c - a).Dot(normal);
+}
+
+/// <summary>
+/// Pick up to MAX_MANIFOLD_POINTS of the points: the deepest one, the one furthest from it,
+/// the one making the largest triangle with those two, and the one furthest out of that
+/// triangle. What is left spans about as much area as all of them did, which is what keeps a
+/// body from tipping over, and the deepest point keeps the penetration from being missed.
+/// </summary>
+static int SelectManifoldPoints(const Contact* contacts, const int* indices, const int num, const Vec3& normal, int* selected)
+{
+	const float epsilon = 1e-8f;
+
+	if (num <= Contact::MAX_MANIFOLD_POINTS) {
+		for (int i = 0; i < num; ++i) {
+			selected[i] = indices[i];
+		}
+		return num;
+	}
+
+	int deepest = indices[0];
+	for (int i = 1; i < num; ++i) {
+		if (contacts[indices[i]].separationDistance < contacts[deepest].separationDistance) {
+			deepest = indices[i];
+		}
+	}
+	const Vec3& p0 = contacts[deepest].ptOnAWorldSpace;
+	selected[0] = deepest;
+
+	int furthest = -1;
+	float maxDistSqr = epsilon;
+	for (int i = 0; i < num; ++i) {
+		const float distSqr = (contacts[indices[i]].ptOnAWorldSpace - p0).GetLengthSqr();
+		if (distSqr > maxDistSqr) {
+			maxDistSqr = distSqr;
+			furthest = indices[i];
+		}
+	}
+	if (furthest < 0) return 1;
+	const Vec3& p1 = contacts[furthest].ptOnAWorldSpace;
+	selected[1] = furthest;
+
+	int widest = -1;
+	float maxArea = epsilon;
+	for (int i = 0; i < num; ++i) {
+		const float area = fabsf(SignedArea(p0, p1, contacts[indices[i]].ptOnAWorldSpace, normal));
+		if (area > maxArea) {
+			maxArea = area;
+			widest = indices[i];
+		}
+	}
+	if (widest < 0) return 2;
+	const Vec3& p2 = contacts[widest].ptOnAWorldSpace;
+	selected[2] = widest;
+
+	// Outside of the triangle, an edge sees the point on the other side than the triangle
+	const float winding = (SignedArea(p0, p1, p2, normal) > 0.0f) ? 1.0f : -1.0f;
+	int outermost = -1;
+	float minArea = -epsilon;
+	for (int i = 0; i < num; ++i) {
+		const Vec3& q = contacts[indices[i]].ptOnAWorldSpace;
+		const float area = fminf(fminf(winding * SignedArea(p0, p1, q, normal), winding * SignedArea(p1, p2, q, normal)), winding * SignedArea(p2, p0, q, normal));
+		if (area < minArea) {
+			minArea = area;
+			outermost = indices[i];
+		}
+	}
+	if (outermost < 0) return 3;
+	selected[3] = outermost;
+
+	return 4;
+}
+
+/// <summary>
+/// Meshes, compounds and boxes hand over many points for a single pair, the solver only needs
+/// a few of them per contact plane. Contacts are grouped by normal, each group keeps the points
+/// SelectManifoldPoints picks and shares the average of its normals.
+/// </summary>
+int Contact::ReduceManifold(Contact* contacts, const int num, ManifoldScratch& scratch)
+{
+	if (num <= MAX_MANIFOLD_POINTS) return num;
+
+	// Swept contacts come one per pair, there is nothing to reduce
+	for (int i = 0; i < num; ++i) {
+		if (contacts[i].timeOfImpact != 0.0f) return num;
+	}
+
+	std::vector<int>* clusterIndices = scratch.clusterIndices;
+	Vec3 clusterNormals[MAX_MANIFOLD_CLUSTERS];
+	Vec3 normalSums[MAX_MANIFOLD_CLUSTERS];
+	int numClusters = 0;
+
+	// Every contact joins the cluster of the closest normal, or starts one while there is room
+	for (int i = 0; i < num; ++i) {
+		const Vec3& normal = contacts[i].normal;
+
+		int best = -1;
+		float bestCos = -2.0f;
+		for (int c = 0; c < numClusters; ++c) {
+			const float cos = clusterNormals[c].Dot(normal);
+			if (cos > bestCos) {
+				bestCos = cos;
+				best = c;
+			}
+		}
+
+		if (best < 0 || (bestCos < MANIFOLD_NORMAL_COS && numClusters < MAX_MANIFOLD_CLUSTERS)) {
+			best = numClusters++;
+			clusterNormals[best] = normal;
+			normalSums[best].Zero();
+			clusterIndices[best].clear();
+		}
+
+		normalSums[best] += normal;
+		clusterIndices[best].push_back(i);
+	}
+
+	Contact reduced[MAX_MANIFOLD_CLUSTERS * MAX_MANIFOLD_POINTS];
+	int numReduced = 0;
+	for (int c = 0; c < numClusters; ++c) {
+		Vec3 normal = normalSums[c];
+		if (normal.GetLengthSqr() < 1e-12f) {
+			normal = clusterNormals[c];
+		}
+		normal.Normalize();
+
+		int selected[MAX_MANIFOLD_POINTS];
+		const int numSelected = SelectManifoldPoints(contacts, clusterIndices[c].data(), (int)clusterIndices[c].size(), normal, selected);
+		for (int i = 0; i < numSelected; ++i) {
+			Contact& contact = reduced[numReduced++];
+			contact = contacts[selected[i]];
+
+			// Same convention as the kernels, negative when the points went past each other
+			contact.normal = normal;
+			contact.separationDistance = (contact.ptOnBWorldSpace - contact.ptOnAWorldSpace).Dot(normal);
+		}
+	}
+
+	for (int i = 0; i < numReduced; ++i) {
+		contacts[i] = reduced[i];
+	}
+
+	return numReduced;
+}
+//^ Manifold reduction ===================================================
+
+uint64_t ContactCache::PairKey(const Body* a, const Body* b)
+{
+	const uint64_t keyA = (uint64_t)(uintptr_t)a;
+	const uint64_t keyB = (uint64_t)(uintptr_t)b;
+
+	return keyA * 1099511628211ULL ^ keyB;
+}
+
+const ContactCache::Entry* ContactCache::Find(const Contact& contact) const
+{
+	// Points further apart than this on a are different contacts
+	const float maxDistance = 0.05f;
+
+	// The closest one, not the first one: the order entries of a pair come out of the map in
+	// isn't specified, and a restored snapshot has to match the same entries as the original
+	const Entry* closest = nullptr;
+	float closestDistanceSqr = maxDistance * maxDistance;
+
+	auto range = entries.equal_range(PairKey(contact.a, contact.b));
+	for (auto it = range.first; it != range.second; ++it) {
+		const Entry& entry = it->second;
+		if (entry.a != contact.a || entry.b != contact.b) continue;
+
+		const Vec3 delta = entry.ptOnALocalSpace - contact.ptOnALocalSpace;
+		if (delta.GetLengthSqr() < closestDistanceSqr) {
+			closest = &entry;
+			closestDistanceSqr = delta.GetLengthSqr();
+		}
+	}
+
+	return closest;
+}
+
+void ContactCache::Store(const Contact& contact, const float normalImpulse, const Vec3& tangentImpulse)
+{
+	Entry entry;
+	entry.a = contact.a;
+	entry.b = contact.b;
+	entry.ptOnALocalSpace = contact.ptOnALocalSpace;
+	entry.normalImpulse = normalImpulse;
+	entry.tangentImpulse = tangentImpulse;
+
+	entries.insert(std::make_pair(PairKey(contact.a, contact.b), entry));
+}
+
+void ContactCache::Save(const Body* bodies, SavedEntry* out) const
+{
+	int i = 0;
+	for (auto it = entries.begin(); it != entries.end(); ++it, ++i) {
+		const Entry& entry = it->second;
+		out[i].a = (int)(entry.a - bodies);
+		out[i].b = (int)(entry.b - bodies);
+		out[i].ptOnALocalSpace = entry.ptOnALocalSpace;
+		out[i].normalImpulse = entry.normalImpulse;
+		out[i].tangentImpulse = entry.tangentImpulse;
+	}
+}
+
+void ContactCache::Restore(const Body* bodies, const SavedEntry* saved, const int num)
+{
+	entries.clear();
+	entries.reserve(num);
+
+	for (int i = 0; i < num; ++i) {
+		Entry entry;
+		entry.a = bodies + saved[i].a;
+		entry.b = bodies + saved[i].b;
+		entry.ptOnALocalSpace = saved[i].ptOnALocalSpace;
+		entry.normalImpulse = saved[i].normalImpulse;
+		entry.tangentImpulse = saved[i].tangentImpulse;
+
+		entries.insert(std::make_pair(PairKey(entry.a, entry.b), entry));
+	}
+}
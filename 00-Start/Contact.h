@@ -1,4 +1,7 @@
 #pragma once
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
 #include "code/Math/Vector.h"
 #include "Body.h"
 
@@ -19,6 +22,62 @@ public:
 	Body* b{ nullptr };
 
 	static void ResolveContact(Contact& contact);
+	static void ResolveContacts(Contact* contacts, const int num, class ContactCache* cache = nullptr);
 	static int CompareContact(const void* p1, const void* p2);
+
+	static const int MAX_MANIFOLD_POINTS = 4;
+	static const int MAX_MANIFOLD_CLUSTERS = 2;
+
+	// Lists ReduceManifold fills, kept by the caller so they aren't reallocated for every pair
+	struct ManifoldScratch
+	{
+		std::vector<int> clusterIndices[MAX_MANIFOLD_CLUSTERS];
+	};
+
+	// Cut the contacts of a single pair down to at most MAX_MANIFOLD_POINTS per group of
+	// similar normals, MAX_MANIFOLD_CLUSTERS groups, in place. Returns how many are left.
+	static int ReduceManifold(Contact* contacts, const int num, ManifoldScratch& scratch);
+};
+
+/// <summary>
+/// Impulses the resting contact solver ended with, kept from one update to the next.
+/// Starting the solver from them (warm starting) lets stacks settle in a few iterations.
+/// Contacts are matched by bodies and by their point on a in body space.
+/// </summary>
+class ContactCache
+{
+public:
+	struct Entry
+	{
+		const Body* a;
+		const Body* b;
+		Vec3 ptOnALocalSpace;
+		float normalImpulse;
+		Vec3 tangentImpulse;
+	};
+
+	// Entry with its bodies as indices into the scene's bodies, plain data that can be copied around
+	struct SavedEntry
+	{
+		int a;
+		int b;
+		Vec3 ptOnALocalSpace;
+		float normalImpulse;
+		Vec3 tangentImpulse;
+	};
+
+	const Entry* Find(const Contact& contact) const;
+	void Store(const Contact& contact, const float normalImpulse, const Vec3& tangentImpulse);
+	void Clear() { entries.clear(); }
+
+	int Size() const { return (int)entries.size(); }
+	// Size() entries into out, and back. Restoring replaces every entry.
+	void Save(const Body* bodies, SavedEntry* out) const;
+	void Restore(const Body* bodies, const SavedEntry* saved, const int num);
+
+private:
+	static uint64_t PairKey(const Body* a, const Body* b);
+
+	std::unordered_multimap<uint64_t, Entry> entries;
 };
 
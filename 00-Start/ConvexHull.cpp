@@ -0,0 +1,327 @@
+#include "ConvexHull.h"
+#include <math.h>
+#include <assert.h>
+
+
+//v Helpers ===============================================================
+static int FindPointFurthestInDir(const Vec3* pts, const int num, const Vec3& dir)
+{
+	int maxIdx = 0;
+	float maxDist = dir.Dot(pts[0]);
+	for (int i = 1; i < num; ++i) {
+		const float dist = dir.Dot(pts[i]);
+		if (dist > maxDist) {
+			maxDist = dist;
+			maxIdx = i;
+		}
+	}
+
+	return maxIdx;
+}
+
+static float DistanceFromLine(const Vec3& a, const Vec3& b, const Vec3& pt)
+{
+	Vec3 ab = b - a;
+	ab.Normalize();
+
+	const Vec3 ray = pt - a;
+	const Vec3 perpendicular = ray - ab * ray.Dot(ab);
+
+	return perpendicular.GetMagnitude();
+}
+
+static Vec3 FindPointFurthestFromLine(const Vec3* pts, const int num, const Vec3& a, const Vec3& b)
+{
+	int maxIdx = 0;
+	float maxDist = DistanceFromLine(a, b, pts[0]);
+	for (int i = 1; i < num; ++i) {
+		const float dist = DistanceFromLine(a, b, pts[i]);
+		if (dist > maxDist) {
+			maxDist = dist;
+			maxIdx = i;
+		}
+	}
+
+	return pts[maxIdx];
+}
+
+// Signed distance, positive in front of the counter clockwise face
+static float DistanceFromTriangle(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& pt)
+{
+	Vec3 normal = (b - a).Cross(c - a);
+	normal.Normalize();
+
+	return (pt - a).Dot(normal);
+}
+
+static Vec3 FindPointFurthestFromTriangle(const Vec3* pts, const int num, const Vec3& a, const Vec3& b, const Vec3& c)
+{
+	int maxIdx = 0;
+	float maxDist = fabsf(DistanceFromTriangle(a, b, c, pts[0]));
+	for (int i = 1; i < num; ++i) {
+		const float dist = fabsf(DistanceFromTriangle(a, b, c, pts[i]));
+		if (dist > maxDist) {
+			maxDist = dist;
+			maxIdx = i;
+		}
+	}
+
+	return pts[maxIdx];
+}
+//^ Helpers ===============================================================
+
+//v Hull construction =====================================================
+static void BuildTetrahedron(const Vec3* verts, const int num, std::vector<Vec3>& hullPts, std::vector<tri_t>& hullTris)
+{
+	hullPts.clear();
+	hullTris.clear();
+
+	Vec3 points[4];
+
+	int idx = FindPointFurthestInDir(verts, num, Vec3(1, 0, 0));
+	points[0] = verts[idx];
+	idx = FindPointFurthestInDir(verts, num, points[0] * -1.0f);
+	points[1] = verts[idx];
+	points[2] = FindPointFurthestFromLine(verts, num, points[0], points[1]);
+	points[3] = FindPointFurthestFromTriangle(verts, num, points[0], points[1], points[2]);
+
+	// Keep the base winding facing away from the apex, so every face points outwards
+	if (DistanceFromTriangle(points[0], points[1], points[2], points[3]) > 0.0f) {
+		const Vec3 tmp = points[0];
+		points[0] = points[1];
+		points[1] = tmp;
+	}
+
+	hullPts.push_back(points[0]);
+	hullPts.push_back(points[1]);
+	hullPts.push_back(points[2]);
+	hullPts.push_back(points[3]);
+
+	hullTris.push_back({ 0, 1, 2 });
+	hullTris.push_back({ 0, 2, 3 });
+	hullTris.push_back({ 2, 1, 3 });
+	hullTris.push_back({ 1, 0, 3 });
+}
+
+static void RemoveInternalPoints(const std::vector<Vec3>& hullPts, const std::vector<tri_t>& hullTris, std::vector<Vec3>& checkPts)
+{
+	for (int i = 0; i < checkPts.size(); ++i) {
+		const Vec3& pt = checkPts[i];
+
+		bool isExternal = false;
+		for (int t = 0; t < hullTris.size(); ++t) {
+			const tri_t& tri = hullTris[t];
+			if (DistanceFromTriangle(hullPts[tri.a], hullPts[tri.b], hullPts[tri.c], pt) > 0.0f) {
+				isExternal = true;
+				break;
+			}
+		}
+
+		// Points sitting on a hull vertex would only add slivers
+		bool isTooClose = false;
+		for (int j = 0; j < hullPts.size(); ++j) {
+			if ((hullPts[j] - pt).GetLengthSqr() < 0.01f * 0.01f) {
+				isTooClose = true;
+				break;
+			}
+		}
+
+		if (!isExternal || isTooClose) {
+			checkPts.erase(checkPts.begin() + i);
+			--i;
+		}
+	}
+}
+
+static bool IsEdgeUnique(const std::vector<tri_t>& tris, const std::vector<int>& facingTris, const int ignoreTri, const edge_t& edge)
+{
+	for (int i = 0; i < facingTris.size(); ++i) {
+		const int triIdx = facingTris[i];
+		if (triIdx == ignoreTri) continue;
+
+		const tri_t& tri = tris[triIdx];
+		const edge_t edges[3] = { { tri.a, tri.b }, { tri.b, tri.c }, { tri.c, tri.a } };
+		for (int e = 0; e < 3; ++e) {
+			if (edge == edges[e]) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static void RemoveUnreferencedVerts(std::vector<Vec3>& hullPts, std::vector<tri_t>& hullTris)
+{
+	for (int i = 0; i < hullPts.size(); ++i) {
+		bool isUsed = false;
+		for (int t = 0; t < hullTris.size(); ++t) {
+			const tri_t& tri = hullTris[t];
+			if (tri.a == i || tri.b == i || tri.c == i) {
+				isUsed = true;
+				break;
+			}
+		}
+		if (isUsed) continue;
+
+		for (int t = 0; t < hullTris.size(); ++t) {
+			tri_t& tri = hullTris[t];
+			if (tri.a > i) --tri.a;
+			if (tri.b > i) --tri.b;
+			if (tri.c > i) --tri.c;
+		}
+
+		hullPts.erase(hullPts.begin() + i);
+		--i;
+	}
+}
+
+static void AddPoint(std::vector<Vec3>& hullPts, std::vector<tri_t>& hullTris, const Vec3& pt)
+{
+	// Every triangle that sees the point is replaced
+	std::vector<int> facingTris;
+	for (int t = (int)hullTris.size() - 1; t >= 0; --t) {
+		const tri_t& tri = hullTris[t];
+		if (DistanceFromTriangle(hullPts[tri.a], hullPts[tri.b], hullPts[tri.c], pt) > 0.0f) {
+			facingTris.push_back(t);
+		}
+	}
+
+	// The edges they don't share form the horizon, the new fan is stitched onto it
+	std::vector<edge_t> uniqueEdges;
+	for (int i = 0; i < facingTris.size(); ++i) {
+		const int triIdx = facingTris[i];
+		const tri_t& tri = hullTris[triIdx];
+
+		const edge_t edges[3] = { { tri.a, tri.b }, { tri.b, tri.c }, { tri.c, tri.a } };
+		for (int e = 0; e < 3; ++e) {
+			if (IsEdgeUnique(hullTris, facingTris, triIdx, edges[e])) {
+				uniqueEdges.push_back(edges[e]);
+			}
+		}
+	}
+
+	// Indices were gathered from the back, so erasing doesn't shift the ones left
+	for (int i = 0; i < facingTris.size(); ++i) {
+		hullTris.erase(hullTris.begin() + facingTris[i]);
+	}
+
+	hullPts.push_back(pt);
+	const int newPtIdx = (int)hullPts.size() - 1;
+
+	// Horizon edges keep the winding of their removed triangle
+	for (int i = 0; i < uniqueEdges.size(); ++i) {
+		const edge_t& edge = uniqueEdges[i];
+		hullTris.push_back({ edge.a, edge.b, newPtIdx });
+	}
+
+	RemoveUnreferencedVerts(hullPts, hullTris);
+}
+
+static void ExpandConvexHull(std::vector<Vec3>& hullPts, std::vector<tri_t>& hullTris, const std::vector<Vec3>& verts)
+{
+	std::vector<Vec3> externalVerts = verts;
+	RemoveInternalPoints(hullPts, hullTris, externalVerts);
+
+	while (externalVerts.size() > 0) {
+		const int pointIdx = FindPointFurthestInDir(externalVerts.data(), (int)externalVerts.size(), externalVerts[0]);
+		const Vec3 pt = externalVerts[pointIdx];
+		externalVerts.erase(externalVerts.begin() + pointIdx);
+
+		AddPoint(hullPts, hullTris, pt);
+		RemoveInternalPoints(hullPts, hullTris, externalVerts);
+	}
+}
+
+void BuildConvexHull(const std::vector<Vec3>& verts, std::vector<Vec3>& hullPts, std::vector<tri_t>& hullTris)
+{
+	assert(verts.size() >= 4);
+
+	BuildTetrahedron(verts.data(), (int)verts.size(), hullPts, hullTris);
+	ExpandConvexHull(hullPts, hullTris, verts);
+}
+//^ Hull construction =====================================================
+
+//v Mass properties =======================================================
+// The solid is split into tetrahedra joining every face to a point inside the hull,
+// their signed volumes add up exactly whatever point is picked
+static Vec3 InteriorPoint(const std::vector<Vec3>& pts)
+{
+	Vec3 sum(0.0f);
+	for (int i = 0; i < pts.size(); ++i) {
+		sum += pts[i];
+	}
+
+	return sum / (float)pts.size();
+}
+
+static float TetrahedronVolume(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& d)
+{
+	return (a - d).Dot((b - d).Cross(c - d)) / 6.0f;
+}
+
+Vec3 CalculateCenterOfMass(const std::vector<Vec3>& pts, const std::vector<tri_t>& tris)
+{
+	const Vec3 origin = InteriorPoint(pts);
+
+	Vec3 centerOfMass(0.0f);
+	float totalVolume = 0.0f;
+	for (int t = 0; t < tris.size(); ++t) {
+		const tri_t& tri = tris[t];
+		const Vec3& a = pts[tri.a];
+		const Vec3& b = pts[tri.b];
+		const Vec3& c = pts[tri.c];
+
+		const float volume = TetrahedronVolume(a, b, c, origin);
+		centerOfMass += (a + b + c + origin) * (volume * 0.25f);
+		totalVolume += volume;
+	}
+
+	return centerOfMass / totalVolume;
+}
+
+Mat3 CalculateInertiaTensor(const std::vector<Vec3>& pts, const std::vector<tri_t>& tris, const Vec3& centerOfMass)
+{
+	const Vec3 origin = InteriorPoint(pts) - centerOfMass;
+
+	// Second moment (covariance) of the solid about the center of mass:
+	// for a tetrahedron with corners p_i, C = V / 20 * (sum p_i p_i^T + (sum p_i)(sum p_i)^T)
+	float covariance[3][3] = {};
+	float totalVolume = 0.0f;
+	for (int t = 0; t < tris.size(); ++t) {
+		const tri_t& tri = tris[t];
+		const Vec3 corners[4] = {
+			pts[tri.a] - centerOfMass,
+			pts[tri.b] - centerOfMass,
+			pts[tri.c] - centerOfMass,
+			origin
+		};
+
+		const float volume = TetrahedronVolume(corners[0], corners[1], corners[2], corners[3]);
+		const Vec3 sum = corners[0] + corners[1] + corners[2] + corners[3];
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				float moment = sum[i] * sum[j];
+				for (int k = 0; k < 4; ++k) {
+					moment += corners[k][i] * corners[k][j];
+				}
+				covariance[i][j] += moment * volume / 20.0f;
+			}
+		}
+		totalVolume += volume;
+	}
+
+	// Unit mass, so the density is 1 / volume
+	const float trace = covariance[0][0] + covariance[1][1] + covariance[2][2];
+
+	Mat3 tensor;
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			tensor.rows[i][j] = ((i == j) ? trace : 0.0f) - covariance[i][j];
+			tensor.rows[i][j] /= totalVolume;
+		}
+	}
+
+	return tensor;
+}
+//^ Mass properties =======================================================
@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include "code/Math/Vector.h"
+#include "code/Math/Matrix.h"
+
+
+// Triangle of a hull, indices into its points, counter clockwise seen from outside
+struct tri_t
+{
+	int a;
+	int b;
+	int c;
+};
+
+struct edge_t
+{
+	int a;
+	int b;
+
+	bool operator==(const edge_t& rhs) const
+	{
+		return ((a == rhs.a && b == rhs.b) || (a == rhs.b && b == rhs.a));
+	}
+};
+
+/// <summary>
+/// Quickhull style incremental hull: start from the largest tetrahedron of the cloud,
+/// then repeatedly add the furthest point still outside and stitch its horizon.
+/// Points inside the hull are dropped, hullPts only holds the hull vertices.
+/// Expects at least four points that aren't coplanar.
+/// </summary>
+void BuildConvexHull(const std::vector<Vec3>& verts, std::vector<Vec3>& hullPts, std::vector<tri_t>& hullTris);
+
+// Mass properties of the solid enclosed by a hull, for a uniform density and a unit mass
+Vec3 CalculateCenterOfMass(const std::vector<Vec3>& pts, const std::vector<tri_t>& tris);
+Mat3 CalculateInertiaTensor(const std::vector<Vec3>& pts, const std::vector<tri_t>& tris, const Vec3& centerOfMass);
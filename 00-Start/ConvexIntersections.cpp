@@ -0,0 +1,394 @@
+#include "Intersections.h"
+#include "GJK.h"
+#include <math.h>
+
+
+// Inflates the simplex before EPA, so shapes that only touch still get a usable normal
+static const float GJK_BIAS = 0.001f;
+
+// Vertices this close to the support plane, relative to the size of the shape,
+// belong to the supporting feature, so resting faces don't flicker between a corner and the face
+static const float FEATURE_RELATIVE_TOLERANCE = 0.02f;
+
+// A body is tested continuously once it can sweep this fraction of its bounding radius in a step
+static const float CCD_MOTION_FRACTION = 0.25f;
+
+// Conservative advancement stops this close to the time of impact, and gives up after so many steps
+static const float CCD_DISTANCE_TOLERANCE = 0.001f;
+static const int CCD_MAX_ITERATIONS = 32;
+
+// Largest supporting feature kept, and room for it clipped by as many planes
+static const int MAX_FEATURE_POINTS = 16;
+static const int MAX_CLIP_POINTS = MAX_FEATURE_POINTS * 2;
+
+/// <summary>
+/// Order the points of a feature counter clockwise around dir, by angle around their centroid
+/// </summary>
+static void SortFeature(Vec3* feature, const int num, const Vec3& dir)
+{
+	Vec3 centroid(0.0f);
+	for (int i = 0; i < num; ++i) {
+		centroid += feature[i];
+	}
+	centroid /= (float)num;
+
+	Vec3 u, v;
+	dir.GetOrtho(u, v);
+
+	float angles[MAX_FEATURE_POINTS];
+	for (int i = 0; i < num; ++i) {
+		const Vec3 r = feature[i] - centroid;
+		angles[i] = atan2f(r.Dot(v), r.Dot(u));
+	}
+	for (int i = 1; i < num; ++i) {
+		for (int j = i; j > 0 && angles[j - 1] > angles[j]; --j) {
+			const float tmpAngle = angles[j];
+			angles[j] = angles[j - 1];
+			angles[j - 1] = tmpAngle;
+
+			const Vec3 tmp = feature[j];
+			feature[j] = feature[j - 1];
+			feature[j - 1] = tmp;
+		}
+	}
+}
+
+/// <summary>
+/// World space vertices of the body's shape that support it along dir,
+/// ordered counter clockwise around dir when they form a polygon
+/// </summary>
+static int SupportFeature(const Body& body, const Vec3& dir, Vec3* feature)
+{
+	const Vec3* verts = nullptr;
+	int numVerts = 0;
+	switch (body.shape->GetType()) {
+	case Shape::ShapeType::SHAPE_BOX: {
+		const ShapeBox* box = static_cast<const ShapeBox*>(body.shape);
+		verts = box->points;
+		numVerts = 8;
+	} break;
+	case Shape::ShapeType::SHAPE_CONVEX: {
+		const ShapeConvex* convex = static_cast<const ShapeConvex*>(body.shape);
+		verts = convex->points.data();
+		numVerts = (int)convex->points.size();
+	} break;
+	case Shape::ShapeType::SHAPE_CAPSULE: {
+		// Its segment when it lies across dir, the nearest end otherwise
+		const ShapeCapsule* capsule = static_cast<const ShapeCapsule*>(body.shape);
+		const float tolerance = FEATURE_RELATIVE_TOLERANCE * 2.0f * (capsule->halfHeight + capsule->radius);
+
+		Vec3 p0, p1;
+		capsule->GetSegment(body.position, body.orientation, p0, p1);
+		const float d0 = dir.Dot(p0);
+		const float d1 = dir.Dot(p1);
+		if (fabsf(d1 - d0) <= tolerance) {
+			feature[0] = p0 + dir * capsule->radius;
+			feature[1] = p1 + dir * capsule->radius;
+			return 2;
+		}
+
+		feature[0] = ((d1 > d0) ? p1 : p0) + dir * capsule->radius;
+		return 1;
+	}
+	default:
+		// Round shapes are supported by a single point
+		feature[0] = body.shape->Support(dir, body.position, body.orientation, 0.0f);
+		return 1;
+	}
+
+	const Bounds& bounds = body.shape->GetLocalBounds();
+	const float tolerance = FEATURE_RELATIVE_TOLERANCE * (bounds.maxs - bounds.mins).GetMagnitude();
+
+	// Search in body space, so only the vertices kept get rotated
+	const Vec3 localDir = body.orientation.Inverse().RotatePoint(dir);
+
+	float maxDist = localDir.Dot(verts[0]);
+	for (int i = 1; i < numVerts; ++i) {
+		maxDist = fmaxf(maxDist, localDir.Dot(verts[i]));
+	}
+
+	int num = 0;
+	for (int i = 0; i < numVerts && num < MAX_FEATURE_POINTS; ++i) {
+		if (localDir.Dot(verts[i]) >= maxDist - tolerance) {
+			feature[num++] = body.orientation.RotatePoint(verts[i]) + body.position;
+		}
+	}
+
+	if (num >= 3) {
+		SortFeature(feature, num, dir);
+	}
+	return num;
+}
+
+/// <summary>
+/// Vertices of a world space triangle that support it along dir, with the same tolerance as the shapes
+/// </summary>
+static int TriangleFeature(const Vec3* triangle, const Vec3& dir, Vec3* feature)
+{
+	float size = 0.0f;
+	float maxDist = dir.Dot(triangle[0]);
+	for (int i = 0; i < 3; ++i) {
+		size = fmaxf(size, (triangle[(i + 1) % 3] - triangle[i]).GetMagnitude());
+		maxDist = fmaxf(maxDist, dir.Dot(triangle[i]));
+	}
+	const float tolerance = FEATURE_RELATIVE_TOLERANCE * size;
+
+	int num = 0;
+	for (int i = 0; i < 3; ++i) {
+		if (dir.Dot(triangle[i]) >= maxDist - tolerance) {
+			feature[num++] = triangle[i];
+		}
+	}
+
+	if (num == 3) {
+		SortFeature(feature, num, dir);
+	}
+	return num;
+}
+
+/// <summary>
+/// Sutherland-Hodgman clip against the half space (p - origin).dir <= 0.
+/// Two points are clipped as a segment rather than a closed polygon.
+/// </summary>
+static int ClipFeature(const Vec3* in, const int numIn, const Vec3& origin, const Vec3& dir, Vec3* out)
+{
+	const int numEdges = (numIn == 2) ? 1 : numIn;
+
+	int numOut = 0;
+	for (int i = 0; i < numEdges; ++i)
+	{
+		const Vec3& p0 = in[i];
+		const Vec3& p1 = in[(i + 1) % numIn];
+		const float d0 = (p0 - origin).Dot(dir);
+		const float d1 = (p1 - origin).Dot(dir);
+
+		if (d0 <= 0.0f) {
+			out[numOut++] = p0;
+		}
+		if ((d0 < 0.0f && d1 > 0.0f) || (d0 > 0.0f && d1 < 0.0f)) {
+			const float t = d0 / (d0 - d1);
+			out[numOut++] = p0 + (p1 - p0) * t;
+		}
+	}
+
+	// The far end of a segment has no edge of its own
+	if (numIn == 2 && (in[1] - origin).Dot(dir) <= 0.0f) {
+		out[numOut++] = in[1];
+	}
+
+	return numOut;
+}
+
+/// <summary>
+/// Clip the incident feature against the side planes of the reference face, and keep the points below it.
+/// refNormal is the outward normal of the reference face, points go out as (on reference, on incident).
+/// </summary>
+static int ClipFeatures(const Vec3* ref, const int numRef, const Vec3& refNormal, const Vec3* inc, const int numInc, Vec3* ptsOnRef, Vec3* ptsOnInc, float* separations, const int maxPoints)
+{
+	Vec3 polygon[MAX_CLIP_POINTS];
+	Vec3 clipped[MAX_CLIP_POINTS];
+	int numPoints = numInc;
+	for (int i = 0; i < numInc; ++i) {
+		polygon[i] = inc[i];
+	}
+
+	// The reference face winds counter clockwise around its normal, so edge x normal points out
+	for (int i = 0; i < numRef && numPoints > 0; ++i) {
+		const Vec3& p0 = ref[i];
+		const Vec3& p1 = ref[(i + 1) % numRef];
+		const Vec3 sideNormal = (p1 - p0).Cross(refNormal);
+
+		numPoints = ClipFeature(polygon, numPoints, p0, sideNormal, clipped);
+		for (int j = 0; j < numPoints; ++j) {
+			polygon[j] = clipped[j];
+		}
+	}
+
+	// The face is flat within the feature tolerance, its plane goes through its highest vertex
+	float refOffset = refNormal.Dot(ref[0]);
+	for (int i = 1; i < numRef; ++i) {
+		refOffset = fmaxf(refOffset, refNormal.Dot(ref[i]));
+	}
+
+	int numContacts = 0;
+	for (int i = 0; i < numPoints && numContacts < maxPoints; ++i)
+	{
+		const float separation = refNormal.Dot(polygon[i]) - refOffset;
+		if (separation > 0.0f) continue;
+
+		ptsOnInc[numContacts] = polygon[i];
+		ptsOnRef[numContacts] = polygon[i] - refNormal * separation;
+		separations[numContacts] = separation;
+		++numContacts;
+	}
+
+	return numContacts;
+}
+
+static void FillContact(Body& a, Body& b, const Vec3& ptOnA, const Vec3& ptOnB, const Vec3& normal, const float separation, Contact& contact)
+{
+	contact.a = &a;
+	contact.b = &b;
+	contact.ptOnAWorldSpace = ptOnA;
+	contact.ptOnBWorldSpace = ptOnB;
+	contact.ptOnALocalSpace = a.WorldSpaceToBodySpace(ptOnA);
+	contact.ptOnBLocalSpace = b.WorldSpaceToBodySpace(ptOnB);
+	contact.normal = normal;
+	contact.separationDistance = separation;
+	contact.timeOfImpact = 0.0f;
+}
+
+/// <summary>
+/// When either side rests on a face along the normal, the other side's supporting feature
+/// is clipped against it for a full manifold, otherwise the deepest point is the only contact
+/// </summary>
+static int BuildManifold(Body& a, Body& b, const Vec3* featureA, const int numA, const Vec3* featureB, const int numB, const Vec3& normal, const Vec3& ptOnA, const Vec3& ptOnB, Contact* contacts, const int maxContacts)
+{
+	Vec3 ptsOnRef[MAX_CLIP_POINTS];
+	Vec3 ptsOnInc[MAX_CLIP_POINTS];
+	float separations[MAX_CLIP_POINTS];
+
+	int numContacts = 0;
+	if (numA >= 3 && numB >= 2) {
+		numContacts = ClipFeatures(featureA, numA, normal, featureB, numB, ptsOnRef, ptsOnInc, separations, maxContacts);
+		for (int i = 0; i < numContacts; ++i) {
+			FillContact(a, b, ptsOnRef[i], ptsOnInc[i], normal, separations[i], contacts[i]);
+		}
+	}
+	else if (numB >= 3 && numA >= 2) {
+		numContacts = ClipFeatures(featureB, numB, normal * -1.0f, featureA, numA, ptsOnRef, ptsOnInc, separations, maxContacts);
+		for (int i = 0; i < numContacts; ++i) {
+			FillContact(a, b, ptsOnInc[i], ptsOnRef[i], normal, separations[i], contacts[i]);
+		}
+	}
+
+	// Vertex or edge-edge contact, or nothing left after clipping
+	if (numContacts == 0) {
+		FillContact(a, b, ptOnA, ptOnB, normal, -(ptOnA - ptOnB).Dot(normal), contacts[0]);
+		numContacts = 1;
+	}
+
+	return numContacts;
+}
+
+/// <summary>
+/// GJK tells whether the bodies overlap and EPA gives the contact normal,
+/// the supporting features of both sides along it make the manifold
+/// </summary>
+int Intersections::IntersectConvex(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	GJKWarmStart* warmStart = (context.gjkCache != nullptr) ? context.gjkCache->Find(&a, &b) : nullptr;
+
+	Vec3 ptOnA, ptOnB, normal;
+	if (!GJK_DoesIntersect(&a, &b, GJK_BIAS, ptOnA, ptOnB, normal, warmStart)) {
+		return IntersectSwept(context, a, b, dt, contacts, maxContacts);
+	}
+
+	// Take the bias back out of the points
+	ptOnA -= normal * GJK_BIAS;
+	ptOnB += normal * GJK_BIAS;
+
+	Vec3 featureA[MAX_FEATURE_POINTS];
+	Vec3 featureB[MAX_FEATURE_POINTS];
+	const int numA = SupportFeature(a, normal, featureA);
+	const int numB = SupportFeature(b, normal * -1.0f, featureB);
+
+	return BuildManifold(a, b, featureA, numA, featureB, numB, normal, ptOnA, ptOnB, contacts, maxContacts);
+}
+
+/// <summary>
+/// Same as IntersectConvex, with a single triangle of the static body b standing in for its shape.
+/// There is no warm start, triangles come and go too often to be worth caching.
+/// </summary>
+int Intersections::IntersectConvexTriangle(Body& a, Body& b, const Vec3* triangle, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	Vec3 ptOnA, ptOnB, normal;
+	if (!GJK_DoesIntersect(GJKShape(a), GJKShape(triangle), GJK_BIAS, ptOnA, ptOnB, normal)) return 0;
+
+	ptOnA -= normal * GJK_BIAS;
+	ptOnB += normal * GJK_BIAS;
+
+	Vec3 featureA[MAX_FEATURE_POINTS];
+	Vec3 featureB[3];
+	const int numA = SupportFeature(a, normal, featureA);
+	const int numB = TriangleFeature(triangle, normal * -1.0f, featureB);
+
+	return BuildManifold(a, b, featureA, numA, featureB, numB, normal, ptOnA, ptOnB, contacts, maxContacts);
+}
+
+bool Intersections::NeedsContinuous(const Body& body, const float dt)
+{
+	const float radius = body.shape->GetBoundingRadius();
+	const float sweep = (body.linearVelocity.GetMagnitude() + body.angularVelocity.GetMagnitude() * radius) * dt;
+
+	return sweep > CCD_MOTION_FRACTION * radius;
+}
+
+int Intersections::IntersectSwept(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	// Slow pairs can't jump past each other between two discrete tests
+	if (!NeedsContinuous(a, dt) && !NeedsContinuous(b, dt)) return 0;
+
+	return ConservativeAdvance(context, a, b, dt, contacts[0]) ? 1 : 0;
+}
+
+/// <summary>
+/// Step both bodies by the time it takes them to close the gap between them at the fastest they could,
+/// with every point moving at most |v| + |w| * bounding radius, until the gap is gone.
+/// The steps never overshoot, so thin or spinning shapes can't pass through each other.
+/// </summary>
+bool Intersections::ConservativeAdvance(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact& contact)
+{
+	GJKWarmStart* warmStart = (context.gjkCache != nullptr) ? context.gjkCache->Find(&a, &b) : nullptr;
+
+	// Step copies of the bodies, stepping back by -toi doesn't exactly restore them
+	Body bodyA = a;
+	Body bodyB = b;
+
+	const float angularSpeedA = a.angularVelocity.GetMagnitude() * a.shape->GetBoundingRadius();
+	const float angularSpeedB = b.angularVelocity.GetMagnitude() * b.shape->GetBoundingRadius();
+
+	float toi = 0.0f;
+	for (int i = 0; i < CCD_MAX_ITERATIONS; ++i) {
+		Vec3 ptOnA, ptOnB;
+		GJK_ClosestPoints(&bodyA, &bodyB, ptOnA, ptOnB, warmStart);
+
+		const Vec3 ab = ptOnB - ptOnA;
+		const float distance = ab.GetMagnitude();
+
+		if (distance < CCD_DISTANCE_TOLERANCE) {
+			// Overlapping from the start is the discrete kernels' business
+			if (i == 0) return false;
+
+			contact.a = &a;
+			contact.b = &b;
+			contact.ptOnAWorldSpace = ptOnA;
+			contact.ptOnBWorldSpace = ptOnB;
+			contact.ptOnALocalSpace = bodyA.WorldSpaceToBodySpace(ptOnA);
+			contact.ptOnBLocalSpace = bodyB.WorldSpaceToBodySpace(ptOnB);
+			contact.separationDistance = distance;
+			contact.timeOfImpact = toi;
+			return true;
+		}
+
+		// Upper bound of the speed at which the gap closes
+		contact.normal = ab / distance;
+		const float closingSpeed = (bodyA.linearVelocity - bodyB.linearVelocity).Dot(contact.normal) + angularSpeedA + angularSpeedB;
+		if (closingSpeed <= 0.0f) return false;
+
+		const float step = distance / closingSpeed;
+		if (toi + step > dt) return false;
+
+		toi += step;
+		bodyA.Update(step);
+		bodyB.Update(step);
+	}
+
+	return false;
+}
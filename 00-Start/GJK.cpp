@@ -0,0 +1,784 @@
+#include "GJK.h"
+#include "Shape.h"
+#include <math.h>
+#include <vector>
+
+
+//v Signed volumes ========================================================
+// Barycentric coordinates of the point of the simplex closest to the origin,
+// computed from signed lengths, areas and volumes (Montanari, Petrinic and Barbieri)
+static int CompareSigns(const float a, const float b)
+{
+	if (a > 0.0f && b > 0.0f) return 1;
+	if (a < 0.0f && b < 0.0f) return 1;
+	return 0;
+}
+
+static Vec2 SignedVolume1D(const Vec3& s1, const Vec3& s2)
+{
+	const Vec3 ab = s2 - s1;
+	const Vec3 ap = Vec3(0.0f) - s1;
+	const Vec3 p0 = s1 + ab * ab.Dot(ap) / ab.GetLengthSqr();
+
+	// Work along the axis the segment is the longest on
+	int idx = 0;
+	float muMax = 0.0f;
+	for (int i = 0; i < 3; ++i) {
+		const float mu = s2[i] - s1[i];
+		if (mu * mu > muMax * muMax) {
+			muMax = mu;
+			idx = i;
+		}
+	}
+
+	const float a = s1[idx];
+	const float b = s2[idx];
+	const float p = p0[idx];
+
+	const float c1 = p - a;
+	const float c2 = b - p;
+
+	// The projection of the origin is inside the segment
+	if ((p > a && p < b) || (p > b && p < a)) {
+		return Vec2(c2 / muMax, c1 / muMax);
+	}
+
+	// Outside, on the side of a
+	if ((a <= b && p <= a) || (a >= b && p >= a)) {
+		return Vec2(1.0f, 0.0f);
+	}
+
+	return Vec2(0.0f, 1.0f);
+}
+
+static Vec3 SignedVolume2D(const Vec3& s1, const Vec3& s2, const Vec3& s3)
+{
+	const Vec3 normal = (s2 - s1).Cross(s3 - s1);
+	const Vec3 p0 = normal * s1.Dot(normal) / normal.GetLengthSqr();
+
+	// Work in the plane the triangle has the largest projected area on
+	int idx = 0;
+	float areaMax = 0.0f;
+	for (int i = 0; i < 3; ++i) {
+		const int j = (i + 1) % 3;
+		const int k = (i + 2) % 3;
+
+		const Vec2 a = Vec2(s1[j], s1[k]);
+		const Vec2 b = Vec2(s2[j], s2[k]);
+		const Vec2 c = Vec2(s3[j], s3[k]);
+		const Vec2 ab = b - a;
+		const Vec2 ac = c - a;
+
+		const float area = ab.x * ac.y - ab.y * ac.x;
+		if (area * area > areaMax * areaMax) {
+			idx = i;
+			areaMax = area;
+		}
+	}
+
+	const int x = (idx + 1) % 3;
+	const int y = (idx + 2) % 3;
+	const Vec2 s[3] = { Vec2(s1[x], s1[y]), Vec2(s2[x], s2[y]), Vec2(s3[x], s3[y]) };
+	const Vec2 p = Vec2(p0[x], p0[y]);
+
+	// Areas of the sub-triangles the projected origin makes with each edge
+	Vec3 areas;
+	for (int i = 0; i < 3; ++i) {
+		const int j = (i + 1) % 3;
+		const int k = (i + 2) % 3;
+
+		const Vec2 ab = s[j] - p;
+		const Vec2 ac = s[k] - p;
+		areas[i] = ab.x * ac.y - ab.y * ac.x;
+	}
+
+	// The projection of the origin is inside the triangle
+	if (CompareSigns(areaMax, areas[0]) > 0 && CompareSigns(areaMax, areas[1]) > 0 && CompareSigns(areaMax, areas[2]) > 0) {
+		return areas / areaMax;
+	}
+
+	// Otherwise the closest point is on one of the edges the origin is outside of
+	const Vec3 edgesPts[3] = { s1, s2, s3 };
+
+	float dist = 1e10f;
+	Vec3 lambdas(1.0f, 0.0f, 0.0f);
+	for (int i = 0; i < 3; ++i) {
+		const int k = (i + 1) % 3;
+		const int l = (i + 2) % 3;
+
+		if (CompareSigns(areaMax, -areas[i]) > 0) {
+			const Vec2 lambdaEdge = SignedVolume1D(edgesPts[k], edgesPts[l]);
+			const Vec3 pt = edgesPts[k] * lambdaEdge[0] + edgesPts[l] * lambdaEdge[1];
+			if (pt.GetLengthSqr() < dist) {
+				dist = pt.GetLengthSqr();
+				lambdas.Zero();
+				lambdas[k] = lambdaEdge[0];
+				lambdas[l] = lambdaEdge[1];
+			}
+		}
+	}
+
+	return lambdas;
+}
+
+static Vec4 SignedVolume3D(const Vec3& s1, const Vec3& s2, const Vec3& s3, const Vec3& s4)
+{
+	Mat4 m;
+	m.rows[0] = Vec4(s1.x, s2.x, s3.x, s4.x);
+	m.rows[1] = Vec4(s1.y, s2.y, s3.y, s4.y);
+	m.rows[2] = Vec4(s1.z, s2.z, s3.z, s4.z);
+	m.rows[3] = Vec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+	// Solving m * lambdas = (0, 0, 0, 1) by Cramer's rule only needs the cofactors of the last row
+	Vec4 c4;
+	c4[0] = m.Cofactor(3, 0);
+	c4[1] = m.Cofactor(3, 1);
+	c4[2] = m.Cofactor(3, 2);
+	c4[3] = m.Cofactor(3, 3);
+
+	const float detM = c4[0] + c4[1] + c4[2] + c4[3];
+
+	// The origin is inside the tetrahedron
+	if (CompareSigns(detM, c4[0]) > 0 && CompareSigns(detM, c4[1]) > 0 && CompareSigns(detM, c4[2]) > 0 && CompareSigns(detM, c4[3]) > 0) {
+		return c4 * (1.0f / detM);
+	}
+
+	// Otherwise the closest point is on a face the origin is outside of,
+	// the face opposite to vertex i when its coefficient has the wrong sign
+	const Vec3 facePts[4] = { s1, s2, s3, s4 };
+
+	float dist = 1e10f;
+	Vec4 lambdas(1.0f, 0.0f, 0.0f, 0.0f);
+	for (int i = 0; i < 4; ++i) {
+		if (CompareSigns(detM, c4[i]) > 0) continue;
+
+		const int j = (i + 1) % 4;
+		const int k = (i + 2) % 4;
+		const int l = (i + 3) % 4;
+
+		const Vec3 lambdasFace = SignedVolume2D(facePts[j], facePts[k], facePts[l]);
+		const Vec3 pt = facePts[j] * lambdasFace[0] + facePts[k] * lambdasFace[1] + facePts[l] * lambdasFace[2];
+		if (pt.GetLengthSqr() < dist) {
+			dist = pt.GetLengthSqr();
+			lambdas.Zero();
+			lambdas[j] = lambdasFace[0];
+			lambdas[k] = lambdasFace[1];
+			lambdas[l] = lambdasFace[2];
+		}
+	}
+
+	return lambdas;
+}
+//^ Signed volumes ========================================================
+
+//v Support ===============================================================
+Vec3 GJKShape::Support(const Vec3& dir, const float bias) const
+{
+	if (shape != nullptr) {
+		return shape->Support(dir, position, orientation, bias);
+	}
+
+	int best = 0;
+	float bestDist = dir.Dot(triangle[0]);
+	for (int i = 1; i < 3; ++i) {
+		const float dist = dir.Dot(triangle[i]);
+		if (dist > bestDist) {
+			bestDist = dist;
+			best = i;
+		}
+	}
+
+	return triangle[best] + dir * bias;
+}
+//^ Support ===============================================================
+//v Simplex ===============================================================
+struct point_t
+{
+	// Point of A - B and the two support points it comes from
+	Vec3 xyz;
+	Vec3 ptA;
+	Vec3 ptB;
+	// Search direction it was found along, kept for warm starting
+	Vec3 dir;
+};
+
+static point_t Support(const GJKShape& shapeA, const GJKShape& shapeB, Vec3 dir, const float bias)
+{
+	dir.Normalize();
+
+	point_t point;
+	point.dir = dir;
+	point.ptA = shapeA.Support(dir, bias);
+	point.ptB = shapeB.Support(dir * -1.0f, bias);
+	point.xyz = point.ptA - point.ptB;
+
+	return point;
+}
+
+static bool HasPoint(const point_t* simplexPoints, const int numPts, const point_t& newPt)
+{
+	const float precision = 1e-6f;
+
+	for (int i = 0; i < numPts; ++i) {
+		const Vec3 delta = simplexPoints[i].xyz - newPt.xyz;
+		if (delta.GetLengthSqr() < precision * precision) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Lambdas of the point of the simplex closest to the origin, and the direction from it to the origin.
+/// Returns true when that point is the origin.
+/// </summary>
+static bool SimplexSignedVolumes(const point_t* pts, const int num, Vec3& newDir, Vec4& lambdasOut)
+{
+	const float epsilon = 0.0001f * 0.0001f;
+	lambdasOut.Zero();
+
+	Vec3 v(0.0f);
+	switch (num) {
+	case 1: {
+		lambdasOut[0] = 1.0f;
+		v = pts[0].xyz;
+	} break;
+	case 2: {
+		const Vec2 lambdas = SignedVolume1D(pts[0].xyz, pts[1].xyz);
+		for (int i = 0; i < 2; ++i) {
+			v += pts[i].xyz * lambdas[i];
+			lambdasOut[i] = lambdas[i];
+		}
+	} break;
+	case 3: {
+		const Vec3 lambdas = SignedVolume2D(pts[0].xyz, pts[1].xyz, pts[2].xyz);
+		for (int i = 0; i < 3; ++i) {
+			v += pts[i].xyz * lambdas[i];
+			lambdasOut[i] = lambdas[i];
+		}
+	} break;
+	case 4: {
+		const Vec4 lambdas = SignedVolume3D(pts[0].xyz, pts[1].xyz, pts[2].xyz, pts[3].xyz);
+		for (int i = 0; i < 4; ++i) {
+			v += pts[i].xyz * lambdas[i];
+		}
+		lambdasOut = lambdas;
+	} break;
+	}
+
+	newDir = v * -1.0f;
+	return (v.GetLengthSqr() < epsilon);
+}
+
+/// <summary>
+/// Move the points that support the closest point to the front, and return how many there are
+/// </summary>
+static int ReduceSimplex(point_t* simplexPoints, Vec4& lambdas)
+{
+	int numValids = 0;
+	for (int i = 0; i < 4; ++i) {
+		if (lambdas[i] == 0.0f) continue;
+
+		simplexPoints[numValids] = simplexPoints[i];
+		lambdas[numValids] = lambdas[i];
+		++numValids;
+	}
+	for (int i = numValids; i < 4; ++i) {
+		lambdas[i] = 0.0f;
+	}
+
+	return numValids;
+}
+
+/// <summary>
+/// Starting simplex, rebuilt from last frame's search directions when there are any
+/// </summary>
+static int SeedSimplex(const GJKShape& shapeA, const GJKShape& shapeB, const GJKWarmStart* warmStart, point_t* simplexPoints)
+{
+	int numPts = 0;
+	if (warmStart != nullptr) {
+		for (int i = 0; i < warmStart->numDirections; ++i) {
+			const point_t pt = Support(shapeA, shapeB, warmStart->directions[i], 0.0f);
+			if (!HasPoint(simplexPoints, numPts, pt)) {
+				simplexPoints[numPts] = pt;
+				++numPts;
+			}
+		}
+	}
+
+	if (numPts == 0) {
+		simplexPoints[0] = Support(shapeA, shapeB, Vec3(1.0f, 1.0f, 1.0f), 0.0f);
+		numPts = 1;
+	}
+
+	return numPts;
+}
+
+static void StoreSimplex(GJKWarmStart* warmStart, const point_t* simplexPoints, const int numPts)
+{
+	if (warmStart == nullptr) return;
+
+	warmStart->numDirections = numPts;
+	for (int i = 0; i < numPts; ++i) {
+		warmStart->directions[i] = simplexPoints[i].dir;
+	}
+}
+//^ Simplex ===============================================================
+
+// GJK converges in a handful of iterations, more only happens on degenerate or non finite input
+static const int GJK_MAX_ITERATIONS = 32;
+
+//v EPA ===================================================================
+static float SignedDistanceToTriangle(const tri_t& tri, const Vec3& pt, const std::vector<point_t>& points)
+{
+	const Vec3& a = points[tri.a].xyz;
+	const Vec3& b = points[tri.b].xyz;
+	const Vec3& c = points[tri.c].xyz;
+
+	Vec3 normal = (b - a).Cross(c - a);
+	normal.Normalize();
+
+	return normal.Dot(pt - a);
+}
+
+static Vec3 NormalDirection(const tri_t& tri, const std::vector<point_t>& points)
+{
+	const Vec3& a = points[tri.a].xyz;
+	const Vec3& b = points[tri.b].xyz;
+	const Vec3& c = points[tri.c].xyz;
+
+	Vec3 normal = (b - a).Cross(c - a);
+	normal.Normalize();
+
+	return normal;
+}
+
+static int ClosestTriangle(const std::vector<tri_t>& triangles, const std::vector<point_t>& points)
+{
+	float minDistSqr = 1e10f;
+	int idx = -1;
+	for (int i = 0; i < triangles.size(); ++i) {
+		const float dist = SignedDistanceToTriangle(triangles[i], Vec3(0.0f), points);
+		if (dist * dist < minDistSqr) {
+			minDistSqr = dist * dist;
+			idx = i;
+		}
+	}
+
+	return idx;
+}
+
+static bool HasPoint(const Vec3& w, const std::vector<tri_t>& triangles, const std::vector<point_t>& points)
+{
+	const float epsilon = 0.001f * 0.001f;
+
+	for (int i = 0; i < triangles.size(); ++i) {
+		const tri_t& tri = triangles[i];
+		if ((w - points[tri.a].xyz).GetLengthSqr() < epsilon) return true;
+		if ((w - points[tri.b].xyz).GetLengthSqr() < epsilon) return true;
+		if ((w - points[tri.c].xyz).GetLengthSqr() < epsilon) return true;
+	}
+
+	return false;
+}
+
+static int RemoveTrianglesFacingPoint(const Vec3& pt, std::vector<tri_t>& triangles, const std::vector<point_t>& points)
+{
+	int numRemoved = 0;
+	for (int i = 0; i < triangles.size(); ++i) {
+		if (SignedDistanceToTriangle(triangles[i], pt, points) > 0.0f) {
+			triangles.erase(triangles.begin() + i);
+			--i;
+			++numRemoved;
+		}
+	}
+
+	return numRemoved;
+}
+
+// Edges of the hole left by the removed triangles: used by a single remaining triangle
+static void FindDanglingEdges(std::vector<edge_t>& danglingEdges, const std::vector<tri_t>& triangles)
+{
+	danglingEdges.clear();
+
+	for (int i = 0; i < triangles.size(); ++i) {
+		const tri_t& tri = triangles[i];
+		const edge_t edges[3] = { { tri.a, tri.b }, { tri.b, tri.c }, { tri.c, tri.a } };
+
+		int counts[3] = { 0, 0, 0 };
+		for (int j = 0; j < triangles.size(); ++j) {
+			if (j == i) continue;
+
+			const tri_t& tri2 = triangles[j];
+			const edge_t edges2[3] = { { tri2.a, tri2.b }, { tri2.b, tri2.c }, { tri2.c, tri2.a } };
+			for (int k = 0; k < 3; ++k) {
+				if (edges[k] == edges2[0]) ++counts[k];
+				if (edges[k] == edges2[1]) ++counts[k];
+				if (edges[k] == edges2[2]) ++counts[k];
+			}
+		}
+
+		for (int k = 0; k < 3; ++k) {
+			if (counts[k] == 0) {
+				danglingEdges.push_back(edges[k]);
+			}
+		}
+	}
+}
+
+// Barycentric coordinates of the projection of pt on the triangle's plane
+static Vec3 BarycentricCoordinates(Vec3 s1, Vec3 s2, Vec3 s3, const Vec3& pt)
+{
+	s1 = s1 - pt;
+	s2 = s2 - pt;
+	s3 = s3 - pt;
+
+	const Vec3 normal = (s2 - s1).Cross(s3 - s1);
+	const Vec3 p0 = normal * s1.Dot(normal) / normal.GetLengthSqr();
+
+	int idx = 0;
+	float areaMax = 0.0f;
+	for (int i = 0; i < 3; ++i) {
+		const int j = (i + 1) % 3;
+		const int k = (i + 2) % 3;
+
+		const Vec2 ab = Vec2(s2[j], s2[k]) - Vec2(s1[j], s1[k]);
+		const Vec2 ac = Vec2(s3[j], s3[k]) - Vec2(s1[j], s1[k]);
+
+		const float area = ab.x * ac.y - ab.y * ac.x;
+		if (area * area > areaMax * areaMax) {
+			idx = i;
+			areaMax = area;
+		}
+	}
+
+	const int x = (idx + 1) % 3;
+	const int y = (idx + 2) % 3;
+	const Vec2 s[3] = { Vec2(s1[x], s1[y]), Vec2(s2[x], s2[y]), Vec2(s3[x], s3[y]) };
+	const Vec2 p = Vec2(p0[x], p0[y]);
+
+	Vec3 areas;
+	for (int i = 0; i < 3; ++i) {
+		const int j = (i + 1) % 3;
+		const int k = (i + 2) % 3;
+
+		const Vec2 ab = s[j] - p;
+		const Vec2 ac = s[k] - p;
+		areas[i] = ab.x * ac.y - ab.y * ac.x;
+	}
+
+	Vec3 lambdas = areas / areaMax;
+	if (!lambdas.IsValid()) {
+		lambdas = Vec3(1.0f, 0.0f, 0.0f);
+	}
+
+	return lambdas;
+}
+
+/// <summary>
+/// Grow the tetrahedron towards the boundary of A - B until the face closest to the origin stops moving
+/// </summary>
+static void EPA_Expand(const GJKShape& shapeA, const GJKShape& shapeB, const float bias, const point_t simplexPoints[4], Vec3& ptOnA, Vec3& ptOnB, Vec3& normal)
+{
+	// The polytope can't grow past this without making progress
+	const int maxIterations = 64;
+	const float tolerance = 0.0001f;
+
+	std::vector<point_t> points;
+	std::vector<tri_t> triangles;
+	std::vector<edge_t> danglingEdges;
+
+	Vec3 center(0.0f);
+	for (int i = 0; i < 4; ++i) {
+		points.push_back(simplexPoints[i]);
+		center += simplexPoints[i].xyz;
+	}
+	center *= 0.25f;
+
+	// Wind every face so it points away from the fourth vertex
+	for (int i = 0; i < 4; ++i) {
+		const int j = (i + 1) % 4;
+		const int k = (i + 2) % 4;
+		tri_t tri = { i, j, k };
+
+		const int unusedPt = (i + 3) % 4;
+		if (SignedDistanceToTriangle(tri, points[unusedPt].xyz, points) > 0.0f) {
+			const int tmp = tri.a;
+			tri.a = tri.b;
+			tri.b = tmp;
+		}
+
+		triangles.push_back(tri);
+	}
+
+	for (int iteration = 0; iteration < maxIterations; ++iteration) {
+		const int idx = ClosestTriangle(triangles, points);
+		const Vec3 dir = NormalDirection(triangles[idx], points);
+
+		const point_t newPt = Support(shapeA, shapeB, dir, bias);
+		if (HasPoint(newPt.xyz, triangles, points)) break;
+
+		// The boundary is no further than the closest face, it is the answer
+		const float dist = SignedDistanceToTriangle(triangles[idx], newPt.xyz, points);
+		if (dist <= tolerance) break;
+
+		const int newIdx = (int)points.size();
+		points.push_back(newPt);
+
+		if (RemoveTrianglesFacingPoint(newPt.xyz, triangles, points) == 0) break;
+
+		FindDanglingEdges(danglingEdges, triangles);
+		if (danglingEdges.size() == 0) break;
+
+		// Close the hole with a fan around the new point, facing away from the inside
+		for (int i = 0; i < danglingEdges.size(); ++i) {
+			const edge_t& edge = danglingEdges[i];
+
+			tri_t tri = { newIdx, edge.b, edge.a };
+			if (SignedDistanceToTriangle(tri, center, points) > 0.0f) {
+				const int tmp = tri.b;
+				tri.b = tri.c;
+				tri.c = tmp;
+			}
+
+			triangles.push_back(tri);
+		}
+	}
+
+	// The origin projected on the closest face, mapped back onto both shapes
+	const tri_t& tri = triangles[ClosestTriangle(triangles, points)];
+	const point_t& ptA = points[tri.a];
+	const point_t& ptB = points[tri.b];
+	const point_t& ptC = points[tri.c];
+	const Vec3 lambdas = BarycentricCoordinates(ptA.xyz, ptB.xyz, ptC.xyz, Vec3(0.0f));
+
+	ptOnA = ptA.ptA * lambdas[0] + ptB.ptA * lambdas[1] + ptC.ptA * lambdas[2];
+	ptOnB = ptA.ptB * lambdas[0] + ptB.ptB * lambdas[1] + ptC.ptB * lambdas[2];
+	normal = NormalDirection(tri, points);
+}
+//^ EPA ===================================================================
+
+bool GJK_DoesIntersect(const GJKShape& shapeA, const GJKShape& shapeB, const float bias, Vec3& ptOnA, Vec3& ptOnB, Vec3& normal, GJKWarmStart* warmStart)
+{
+	if (warmStart != nullptr && warmStart->hasSeparatingAxis) {
+		const point_t pt = Support(shapeA, shapeB, warmStart->separatingAxis, 0.0f);
+		if (warmStart->separatingAxis.Dot(pt.xyz) < 0.0f) return false;
+
+		warmStart->hasSeparatingAxis = false;
+	}
+
+	point_t simplexPoints[4];
+	int numPts = SeedSimplex(shapeA, shapeB, warmStart, simplexPoints);
+
+	Vec4 lambdas;
+	Vec3 newDir;
+	bool doesContainOrigin = SimplexSignedVolumes(simplexPoints, numPts, newDir, lambdas);
+	numPts = ReduceSimplex(simplexPoints, lambdas);
+	doesContainOrigin = doesContainOrigin || (numPts == 4);
+
+	float closestDist = newDir.GetLengthSqr();
+	for (int iteration = 0; iteration < GJK_MAX_ITERATIONS && !doesContainOrigin; ++iteration) {
+		const point_t newPt = Support(shapeA, shapeB, newDir, 0.0f);
+
+		// Nothing further along the search direction, the simplex can't grow any more
+		if (HasPoint(simplexPoints, numPts, newPt)) break;
+
+		// The new point didn't reach past the origin, so the origin isn't in A - B
+		if (newDir.Dot(newPt.xyz) < 0.0f) {
+			if (warmStart != nullptr) {
+				warmStart->hasSeparatingAxis = true;
+				warmStart->separatingAxis = newDir;
+			}
+			break;
+		}
+
+		simplexPoints[numPts] = newPt;
+		++numPts;
+
+		doesContainOrigin = SimplexSignedVolumes(simplexPoints, numPts, newDir, lambdas);
+		if (doesContainOrigin) break;
+
+		// Stop once the closest point of the simplex stops getting closer
+		const float dist = newDir.GetLengthSqr();
+		if (dist >= closestDist) break;
+		closestDist = dist;
+
+		numPts = ReduceSimplex(simplexPoints, lambdas);
+		doesContainOrigin = (numPts == 4);
+	}
+
+	StoreSimplex(warmStart, simplexPoints, numPts);
+	if (!doesContainOrigin) return false;
+
+	// EPA needs a tetrahedron, complete the simplex with points away from the one it has
+	if (numPts == 1) {
+		simplexPoints[numPts] = Support(shapeA, shapeB, simplexPoints[0].xyz * -1.0f, 0.0f);
+		++numPts;
+	}
+	if (numPts == 2) {
+		Vec3 u, v;
+		(simplexPoints[1].xyz - simplexPoints[0].xyz).GetOrtho(u, v);
+		simplexPoints[numPts] = Support(shapeA, shapeB, u, 0.0f);
+		++numPts;
+	}
+	if (numPts == 3) {
+		const Vec3 ab = simplexPoints[1].xyz - simplexPoints[0].xyz;
+		const Vec3 ac = simplexPoints[2].xyz - simplexPoints[0].xyz;
+		simplexPoints[numPts] = Support(shapeA, shapeB, ab.Cross(ac), 0.0f);
+		++numPts;
+	}
+
+	// Inflate the simplex by the bias, so touching shapes still give it some volume around the origin
+	Vec3 avg(0.0f);
+	for (int i = 0; i < 4; ++i) {
+		avg += simplexPoints[i].xyz;
+	}
+	avg *= 0.25f;
+
+	for (int i = 0; i < numPts; ++i) {
+		point_t& pt = simplexPoints[i];
+
+		Vec3 dir = pt.xyz - avg;
+		dir.Normalize();
+		pt.ptA += dir * bias;
+		pt.ptB -= dir * bias;
+		pt.xyz = pt.ptA - pt.ptB;
+	}
+
+	EPA_Expand(shapeA, shapeB, bias, simplexPoints, ptOnA, ptOnB, normal);
+	return true;
+}
+
+void GJK_ClosestPoints(const GJKShape& shapeA, const GJKShape& shapeB, Vec3& ptOnA, Vec3& ptOnB, GJKWarmStart* warmStart)
+{
+	point_t simplexPoints[4];
+	int numPts = SeedSimplex(shapeA, shapeB, warmStart, simplexPoints);
+
+	Vec4 lambdas;
+	Vec3 newDir;
+	SimplexSignedVolumes(simplexPoints, numPts, newDir, lambdas);
+	numPts = ReduceSimplex(simplexPoints, lambdas);
+
+	float closestDist = newDir.GetLengthSqr();
+	for (int iteration = 0; iteration < GJK_MAX_ITERATIONS && numPts < 4; ++iteration) {
+		const point_t newPt = Support(shapeA, shapeB, newDir, 0.0f);
+		if (HasPoint(simplexPoints, numPts, newPt)) break;
+
+		simplexPoints[numPts] = newPt;
+		++numPts;
+
+		Vec4 newLambdas;
+		Vec3 dir;
+		SimplexSignedVolumes(simplexPoints, numPts, dir, newLambdas);
+
+		// Keep the previous simplex if the new point didn't bring it closer
+		const float dist = dir.GetLengthSqr();
+		if (dist >= closestDist) {
+			--numPts;
+			break;
+		}
+		closestDist = dist;
+
+		lambdas = newLambdas;
+		newDir = dir;
+		numPts = ReduceSimplex(simplexPoints, lambdas);
+	}
+
+	StoreSimplex(warmStart, simplexPoints, numPts);
+
+	ptOnA.Zero();
+	ptOnB.Zero();
+	for (int i = 0; i < numPts; ++i) {
+		ptOnA += simplexPoints[i].ptA * lambdas[i];
+		ptOnB += simplexPoints[i].ptB * lambdas[i];
+	}
+}
+
+bool GJK_DoesIntersect(const Body* bodyA, const Body* bodyB, const float bias, Vec3& ptOnA, Vec3& ptOnB, Vec3& normal, GJKWarmStart* warmStart)
+{
+	return GJK_DoesIntersect(GJKShape(*bodyA), GJKShape(*bodyB), bias, ptOnA, ptOnB, normal, warmStart);
+}
+
+void GJK_ClosestPoints(const Body* bodyA, const Body* bodyB, Vec3& ptOnA, Vec3& ptOnB, GJKWarmStart* warmStart)
+{
+	GJK_ClosestPoints(GJKShape(*bodyA), GJKShape(*bodyB), ptOnA, ptOnB, warmStart);
+}
+
+//v Cache =================================================================
+uint64_t GJKCache::PairKey(const Body* a, const Body* b)
+{
+	const uint64_t keyA = (uint64_t)(uintptr_t)a;
+	const uint64_t keyB = (uint64_t)(uintptr_t)b;
+
+	return keyA * 1099511628211ULL ^ keyB;
+}
+
+GJKWarmStart* GJKCache::Find(const Body* a, const Body* b)
+{
+	const uint64_t key = PairKey(a, b);
+
+	auto range = entries.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		Entry& entry = it->second;
+		if (entry.a == a && entry.b == b) {
+			entry.lastFrame = frame;
+			return &entry.warmStart;
+		}
+	}
+
+	Entry entry;
+	entry.a = a;
+	entry.b = b;
+	entry.warmStart.numDirections = 0;
+	entry.warmStart.hasSeparatingAxis = false;
+	entry.lastFrame = frame;
+
+	auto it = entries.insert(std::make_pair(key, entry));
+	return &it->second.warmStart;
+}
+
+void GJKCache::NextFrame()
+{
+	for (auto it = entries.begin(); it != entries.end();) {
+		if (it->second.lastFrame != frame) {
+			it = entries.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	++frame;
+}
+
+void GJKCache::Save(const Body* bodies, SavedEntry* out) const
+{
+	int i = 0;
+	for (auto it = entries.begin(); it != entries.end(); ++it, ++i) {
+		const Entry& entry = it->second;
+		out[i].a = (int)(entry.a - bodies);
+		out[i].b = (int)(entry.b - bodies);
+		out[i].warmStart = entry.warmStart;
+		out[i].lastFrame = entry.lastFrame;
+	}
+}
+
+void GJKCache::Restore(const Body* bodies, const SavedEntry* saved, const int num, const int savedFrame)
+{
+	entries.clear();
+	entries.reserve(num);
+
+	for (int i = 0; i < num; ++i) {
+		Entry entry;
+		entry.a = bodies + saved[i].a;
+		entry.b = bodies + saved[i].b;
+		entry.warmStart = saved[i].warmStart;
+		entry.lastFrame = saved[i].lastFrame;
+
+		entries.insert(std::make_pair(PairKey(entry.a, entry.b), entry));
+	}
+
+	frame = savedFrame;
+}
+//^ Cache =================================================================
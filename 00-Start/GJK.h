@@ -0,0 +1,100 @@
+#pragma once
+#include <stdint.h>
+#include <unordered_map>
+#include "Body.h"
+
+
+/// <summary>
+/// What GJK sees of one side of the query: the shape of a body where the body stands,
+/// or a lone triangle already in world space, as handed out by the mesh colliders
+/// </summary>
+struct GJKShape
+{
+	explicit GJKShape(const Body& body) : shape(body.shape), position(body.position), orientation(body.orientation), triangle(nullptr) {}
+	explicit GJKShape(const Vec3* trianglePts) : shape(nullptr), triangle(trianglePts) {}
+
+	Vec3 Support(const Vec3& dir, const float bias) const;
+
+	const Shape* shape;
+	Vec3 position;
+	Quat orientation;
+	// Three world space points, only used when there is no shape
+	const Vec3* triangle;
+};
+
+/// <summary>
+/// Search directions that produced the final simplex of a pair.
+/// Bodies barely move between two frames, so feeding them back into GJK
+/// rebuilds a simplex close to the answer and saves most of the iterations.
+/// </summary>
+struct GJKWarmStart
+{
+	int numDirections;
+	Vec3 directions[4];
+
+	// Direction that proved the pair apart last time, if it did.
+	// Pairs that stay apart are rejected again with a single support query.
+	bool hasSeparatingAxis;
+	Vec3 separatingAxis;
+};
+
+/// <summary>
+/// Warm start data per body pair, pairs that stop being queried are evicted
+/// </summary>
+class GJKCache
+{
+public:
+	GJKCache() : frame(0) {}
+
+	// Entry of the pair, created empty the first time it is asked for
+	GJKWarmStart* Find(const Body* a, const Body* b);
+	// Drop the pairs that weren't asked for since the previous call
+	void NextFrame();
+	void Clear() { entries.clear(); }
+
+	int Size() const { return (int)entries.size(); }
+
+	// Entry with its bodies as indices into the scene's bodies, plain data that can be copied around
+	struct SavedEntry
+	{
+		int a;
+		int b;
+		GJKWarmStart warmStart;
+		int lastFrame;
+	};
+
+	// Size() entries into out, and back along with the frame they were saved on.
+	// Restoring replaces every entry.
+	void Save(const Body* bodies, SavedEntry* out) const;
+	void Restore(const Body* bodies, const SavedEntry* saved, const int num, const int savedFrame);
+	int GetFrame() const { return frame; }
+
+private:
+	struct Entry
+	{
+		const Body* a;
+		const Body* b;
+		GJKWarmStart warmStart;
+		int lastFrame;
+	};
+
+	static uint64_t PairKey(const Body* a, const Body* b);
+
+	std::unordered_multimap<uint64_t, Entry> entries;
+	int frame;
+};
+
+/// <summary>
+/// GJK on the Minkowski difference A - B, using signed volumes to find the sub-simplex closest to the origin.
+/// On overlap the simplex is inflated by bias and expanded with EPA, which gives the closest points of
+/// the penetration and the normal (from a to b) of the face of A - B closest to the origin.
+/// Points come back pushed out by bias along the normal.
+/// </summary>
+bool GJK_DoesIntersect(const GJKShape& shapeA, const GJKShape& shapeB, const float bias, Vec3& ptOnA, Vec3& ptOnB, Vec3& normal, GJKWarmStart* warmStart = nullptr);
+bool GJK_DoesIntersect(const Body* bodyA, const Body* bodyB, const float bias, Vec3& ptOnA, Vec3& ptOnB, Vec3& normal, GJKWarmStart* warmStart = nullptr);
+
+/// <summary>
+/// Closest points of two separated convex bodies, meaningless if they overlap
+/// </summary>
+void GJK_ClosestPoints(const GJKShape& shapeA, const GJKShape& shapeB, Vec3& ptOnA, Vec3& ptOnB, GJKWarmStart* warmStart = nullptr);
+void GJK_ClosestPoints(const Body* bodyA, const Body* bodyB, Vec3& ptOnA, Vec3& ptOnB, GJKWarmStart* warmStart = nullptr);
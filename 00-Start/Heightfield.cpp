@@ -0,0 +1,216 @@
+#include "Heightfield.h"
+#include <algorithm>
+
+
+static const float QUANTIZED_MAX = 65535.0f;
+
+//v Build =================================================================
+void HeightfieldGrid::Build(const float* heights, const int numXP, const int numYP, const float spacingP)
+{
+	assert(numXP >= 2 && numYP >= 2);
+
+	numX = numXP;
+	numY = numYP;
+	spacing = spacingP;
+
+	const int numSamples = numX * numY;
+	minHeight = heights[0];
+	float maxHeight = heights[0];
+	for (int i = 1; i < numSamples; ++i) {
+		minHeight = fminf(minHeight, heights[i]);
+		maxHeight = fmaxf(maxHeight, heights[i]);
+	}
+	heightScale = (maxHeight > minHeight) ? (maxHeight - minHeight) / QUANTIZED_MAX : 0.0f;
+
+	samples.resize(numSamples);
+	for (int i = 0; i < numSamples; ++i) {
+		samples[i] = QuantizeHeight(heights[i]);
+	}
+
+	origin = Vec3(-0.5f * (numX - 1) * spacing, -0.5f * (numY - 1) * spacing, 0.0f);
+	bounds.mins = Vec3(origin.x, origin.y, minHeight);
+	bounds.maxs = Vec3(-origin.x, -origin.y, maxHeight);
+
+	// Level 0 straight from the samples, blocks on the far edges may hold fewer cells
+	const int numCellsX = numX - 1;
+	const int numCellsY = numY - 1;
+
+	levels.clear();
+	Level base;
+	base.numX = (numCellsX + BLOCK_CELLS - 1) / BLOCK_CELLS;
+	base.numY = (numCellsY + BLOCK_CELLS - 1) / BLOCK_CELLS;
+	base.ranges.resize(base.numX * base.numY);
+	for (int by = 0; by < base.numY; ++by) {
+		for (int bx = 0; bx < base.numX; ++bx) {
+			HeightRange range = { 0xffff, 0 };
+
+			// A block of n cells spans n + 1 samples
+			const int lastX = std::min((bx + 1) * BLOCK_CELLS, numCellsX);
+			const int lastY = std::min((by + 1) * BLOCK_CELLS, numCellsY);
+			for (int j = by * BLOCK_CELLS; j <= lastY; ++j) {
+				for (int i = bx * BLOCK_CELLS; i <= lastX; ++i) {
+					range.min = std::min(range.min, Sample(i, j));
+					range.max = std::max(range.max, Sample(i, j));
+				}
+			}
+
+			base.ranges[by * base.numX + bx] = range;
+		}
+	}
+	levels.push_back(base);
+
+	// Merge 2 x 2 blocks until one covers the whole grid
+	while (levels.back().numX > 1 || levels.back().numY > 1) {
+		const Level& below = levels.back();
+
+		Level level;
+		level.numX = (below.numX + 1) / 2;
+		level.numY = (below.numY + 1) / 2;
+		level.ranges.resize(level.numX * level.numY);
+		for (int by = 0; by < level.numY; ++by) {
+			for (int bx = 0; bx < level.numX; ++bx) {
+				HeightRange range = { 0xffff, 0 };
+				for (int cy = 2 * by; cy < std::min(2 * by + 2, below.numY); ++cy) {
+					for (int cx = 2 * bx; cx < std::min(2 * bx + 2, below.numX); ++cx) {
+						const HeightRange& child = below.ranges[cy * below.numX + cx];
+						range.min = std::min(range.min, child.min);
+						range.max = std::max(range.max, child.max);
+					}
+				}
+
+				level.ranges[by * level.numX + bx] = range;
+			}
+		}
+		levels.push_back(level);
+	}
+}
+
+uint16_t HeightfieldGrid::QuantizeHeight(const float height) const
+{
+	if (heightScale == 0.0f) return 0;
+
+	const float q = floorf((height - minHeight) / heightScale + 0.5f);
+	return (uint16_t)std::min(std::max(q, 0.0f), QUANTIZED_MAX);
+}
+
+bool HeightfieldGrid::Matches(const float* heights, const int numXP, const int numYP, const float spacingP) const
+{
+	if (numXP != numX || numYP != numY || spacingP != spacing) return false;
+
+	// Same extremes give the same quantization, then the samples decide
+	const int numSamples = numX * numY;
+	float lo = heights[0];
+	float hi = heights[0];
+	for (int i = 1; i < numSamples; ++i) {
+		lo = fminf(lo, heights[i]);
+		hi = fmaxf(hi, heights[i]);
+	}
+	if (lo != minHeight || hi != bounds.maxs.z) return false;
+
+	for (int i = 0; i < numSamples; ++i) {
+		if (QuantizeHeight(heights[i]) != samples[i]) return false;
+	}
+
+	return true;
+}
+//^ Build =================================================================
+//v Query =================================================================
+Vec3 HeightfieldGrid::GetPoint(const int i, const int j) const
+{
+	return origin + Vec3(i * spacing, j * spacing, minHeight + Sample(i, j) * heightScale);
+}
+
+int HeightfieldGrid::Query(const Bounds& box, std::vector<Vec3>& triangles, BVHQueryStats* stats) const
+{
+	if (samples.empty() || !bounds.DoesIntersect(box)) return 0;
+
+	// Cells under the box, and the box heights on the sample grid, rounded outwards
+	QueryRange range;
+	range.cellMinX = std::min(std::max((int)floorf((box.mins.x - origin.x) / spacing), 0), numX - 2);
+	range.cellMinY = std::min(std::max((int)floorf((box.mins.y - origin.y) / spacing), 0), numY - 2);
+	range.cellMaxX = std::min(std::max((int)floorf((box.maxs.x - origin.x) / spacing), 0), numX - 2);
+	range.cellMaxY = std::min(std::max((int)floorf((box.maxs.y - origin.y) / spacing), 0), numY - 2);
+
+	range.heightMin = 0;
+	range.heightMax = 0xffff;
+	if (heightScale > 0.0f) {
+		const float lo = floorf((box.mins.z - minHeight) / heightScale);
+		const float hi = ceilf((box.maxs.z - minHeight) / heightScale);
+		range.heightMin = (uint16_t)std::min(std::max(lo, 0.0f), QUANTIZED_MAX);
+		range.heightMax = (uint16_t)std::min(std::max(hi, 0.0f), QUANTIZED_MAX);
+	}
+
+	BVHQueryStats local;
+	const int numBefore = (int)triangles.size() / 3;
+	QueryBlock((int)levels.size() - 1, 0, 0, range, triangles, local);
+
+	if (stats != nullptr) {
+		stats->Add(local);
+	}
+
+	return (int)triangles.size() / 3 - numBefore;
+}
+
+void HeightfieldGrid::QueryBlock(const int level, const int blockX, const int blockY, const QueryRange& range, std::vector<Vec3>& triangles, BVHQueryStats& stats) const
+{
+	++stats.nodesVisited;
+
+	// Cells of the block under the box
+	const int blockCells = BLOCK_CELLS << level;
+	const int x0 = std::max(blockX * blockCells, range.cellMinX);
+	const int y0 = std::max(blockY * blockCells, range.cellMinY);
+	const int x1 = std::min(blockX * blockCells + blockCells - 1, range.cellMaxX);
+	const int y1 = std::min(blockY * blockCells + blockCells - 1, range.cellMaxY);
+	if (x0 > x1 || y0 > y1) return;
+
+	const Level& blocks = levels[level];
+	const HeightRange& heights = blocks.ranges[blockY * blocks.numX + blockX];
+	if (heights.max < range.heightMin || heights.min > range.heightMax) return;
+
+	if (level > 0) {
+		const Level& below = levels[level - 1];
+		for (int cy = 2 * blockY; cy < std::min(2 * blockY + 2, below.numY); ++cy) {
+			for (int cx = 2 * blockX; cx < std::min(2 * blockX + 2, below.numX); ++cx) {
+				QueryBlock(level - 1, cx, cy, range, triangles, stats);
+			}
+		}
+		return;
+	}
+
+	for (int j = y0; j <= y1; ++j) {
+		for (int i = x0; i <= x1; ++i) {
+			const int corners[2][3][2] = {
+				{ { i, j }, { i + 1, j }, { i + 1, j + 1 } },
+				{ { i, j }, { i + 1, j + 1 }, { i, j + 1 } },
+			};
+
+			for (int t = 0; t < 2; ++t) {
+				++stats.trianglesTested;
+
+				uint16_t lo = 0xffff;
+				uint16_t hi = 0;
+				for (int k = 0; k < 3; ++k) {
+					const uint16_t sample = Sample(corners[t][k][0], corners[t][k][1]);
+					lo = std::min(lo, sample);
+					hi = std::max(hi, sample);
+				}
+				if (hi < range.heightMin || lo > range.heightMax) continue;
+
+				for (int k = 0; k < 3; ++k) {
+					triangles.push_back(GetPoint(corners[t][k][0], corners[t][k][1]));
+				}
+			}
+		}
+	}
+}
+//^ Query =================================================================
+
+size_t HeightfieldGrid::NumBytes() const
+{
+	size_t numBytes = samples.size() * sizeof(uint16_t);
+	for (int i = 0; i < levels.size(); ++i) {
+		numBytes += levels[i].ranges.size() * sizeof(HeightRange);
+	}
+
+	return numBytes;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "code/Math/Bounds.h"
+#include "MeshBVH.h"
+
+
+/// <summary>
+/// Heights on a regular grid over the xy plane of body space, centered on the origin, z up.
+/// Samples are quantized to 16 bits between the lowest and highest height, and a pyramid of
+/// min/max ranges over blocks of cells rejects whole areas of the grid in a few compares.
+/// No triangle is stored: cell (i, j) is split into (i, j) (i + 1, j) (i + 1, j + 1)
+/// and (i, j) (i + 1, j + 1) (i, j + 1), both counter clockwise seen from above.
+/// </summary>
+class HeightfieldGrid
+{
+public:
+	// heights[j * numX + i] is the sample at column i, row j
+	void Build(const float* heights, const int numX, const int numY, const float spacing);
+
+	// Appends the triangles of the cells overlapping the box, in body space, three points each,
+	// and returns how many triangles were added. Pyramid blocks count as nodes in the stats.
+	int Query(const Bounds& bounds, std::vector<Vec3>& triangles, BVHQueryStats* stats) const;
+
+	// Whether building from these samples would give this very grid
+	bool Matches(const float* heights, const int numX, const int numY, const float spacing) const;
+
+	Vec3 GetPoint(const int i, const int j) const;
+	const Bounds& GetBounds() const { return bounds; }
+	int NumX() const { return numX; }
+	int NumY() const { return numY; }
+	float GetSpacing() const { return spacing; }
+
+	// Memory held by the samples and the pyramid
+	size_t NumBytes() const;
+
+private:
+	struct HeightRange
+	{
+		uint16_t min;
+		uint16_t max;
+	};
+
+	// Ranges of the blocks of one level, level 0 blocks cover BLOCK_CELLS x BLOCK_CELLS cells
+	// and every level above merges 2 x 2 blocks of the one below
+	struct Level
+	{
+		int numX;
+		int numY;
+		std::vector<HeightRange> ranges;
+	};
+
+	static const int BLOCK_CELLS = 8;
+
+	struct QueryRange
+	{
+		int cellMinX;
+		int cellMinY;
+		int cellMaxX;
+		int cellMaxY;
+		uint16_t heightMin;
+		uint16_t heightMax;
+	};
+
+	void QueryBlock(const int level, const int blockX, const int blockY, const QueryRange& range, std::vector<Vec3>& triangles, BVHQueryStats& stats) const;
+	uint16_t QuantizeHeight(const float height) const;
+	uint16_t Sample(const int i, const int j) const { return samples[j * numX + i]; }
+
+	std::vector<uint16_t> samples;
+	std::vector<Level> levels;
+
+	int numX = 0;
+	int numY = 0;
+	float spacing = 0.0f;
+
+	// Height of a sample is minHeight + sample * heightScale
+	float minHeight = 0.0f;
+	float heightScale = 0.0f;
+
+	// Body space position of sample (0, 0)
+	Vec3 origin;
+	Bounds bounds;
+};
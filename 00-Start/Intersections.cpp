@@ -1,56 +1,368 @@
 #include "Intersections.h"
+#include "SphereBatch.h"
+#include <vector>
 
 
-bool Intersections::Intersect(Body& a, Body& b, const float dt, Contact& contact)
+/// <summary>
+/// Narrowphase dispatch table, indexed by the canonical (lower, higher) shape type pair
+/// </summary>
+struct IntersectTable
 {
+	static const int NUM_TYPES = (int)Shape::ShapeType::SHAPE_NUM;
+
+	Intersections::IntersectFn pairFns[NUM_TYPES][NUM_TYPES];
+	Intersections::IntersectBatchFn batchFns[NUM_TYPES][NUM_TYPES];
+
+	IntersectTable();
+};
+
+static IntersectTable& GetIntersectTable()
+{
+	static IntersectTable table;
+	return table;
+}
+
+static int CellIndex(const Shape::ShapeType typeA, const Shape::ShapeType typeB)
+{
+	int a = (int)typeA;
+	int b = (int)typeB;
+	if (a > b) {
+		const int tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	return a * IntersectTable::NUM_TYPES + b;
+}
+
+/// <summary>
+/// Default batch runner, calls the cell's pair kernel on every pair of the batch.
+/// Each pair's contacts are reduced right away, before they take room from the next pairs.
+/// </summary>
+static int IntersectBatchDefault(Intersections::IntersectFn fn, const NarrowphaseContext& context, Body* bodies, const CollisionPair* pairs, const int numPairs, const float dt, Contact* contacts, const int maxContacts)
+{
+	int numContacts = 0;
+	for (int i = 0; i < numPairs; ++i)
+	{
+		if (numContacts >= maxContacts) break;
+
+		Body& bodyA = bodies[pairs[i].a];
+		Body& bodyB = bodies[pairs[i].b];
+		const int numPairContacts = fn(context, bodyA, bodyB, dt, contacts + numContacts, maxContacts - numContacts);
+		numContacts += Contact::ReduceManifold(contacts + numContacts, numPairContacts, context.scratch->manifold);
+	}
+
+	return numContacts;
+}
+
+/// <summary>
+/// Swap the roles of a and b in a contact computed with the bodies swapped
+/// </summary>
+static void FlipContact(Contact& contact)
+{
+	Body* tmpBody = contact.a;
+	contact.a = contact.b;
+	contact.b = tmpBody;
+
+	Vec3 tmp = contact.ptOnAWorldSpace;
+	contact.ptOnAWorldSpace = contact.ptOnBWorldSpace;
+	contact.ptOnBWorldSpace = tmp;
+
+	tmp = contact.ptOnALocalSpace;
+	contact.ptOnALocalSpace = contact.ptOnBLocalSpace;
+	contact.ptOnBLocalSpace = tmp;
+
+	contact.normal *= -1.0f;
+}
+
+IntersectTable::IntersectTable()
+{
+	for (int i = 0; i < NUM_TYPES; ++i) {
+		for (int j = 0; j < NUM_TYPES; ++j) {
+			pairFns[i][j] = nullptr;
+			batchFns[i][j] = nullptr;
+		}
+	}
+}
+
+void Intersections::RegisterIntersect(const Shape::ShapeType typeA, const Shape::ShapeType typeB, IntersectFn fn)
+{
+	// Make sure a user kernel can't be overwritten later by a builtin one
+	RegisterBuiltinKernels();
+
+	// Kernels always receive the lower shape type first
+	assert(typeA <= typeB);
+	const int cell = CellIndex(typeA, typeB);
+
+	GetIntersectTable().pairFns[cell / IntersectTable::NUM_TYPES][cell % IntersectTable::NUM_TYPES] = fn;
+}
+
+void Intersections::RegisterIntersectBatch(const Shape::ShapeType typeA, const Shape::ShapeType typeB, IntersectBatchFn fn)
+{
+	RegisterBuiltinKernels();
+
+	assert(typeA <= typeB);
+	const int cell = CellIndex(typeA, typeB);
+
+	GetIntersectTable().batchFns[cell / IntersectTable::NUM_TYPES][cell % IntersectTable::NUM_TYPES] = fn;
+}
+
+/// <summary>
+/// Register the kernels that ship with the engine, only once
+/// </summary>
+void Intersections::RegisterBuiltinKernels()
+{
+	static bool isRegistered = false;
+	if (isRegistered) return;
+	isRegistered = true;
+
+	RegisterIntersect(Shape::ShapeType::SHAPE_SPHERE, Shape::ShapeType::SHAPE_SPHERE, IntersectSphereSphere);
+	RegisterIntersectBatch(Shape::ShapeType::SHAPE_SPHERE, Shape::ShapeType::SHAPE_SPHERE, IntersectSphereSphereBatch);
+	RegisterIntersect(Shape::ShapeType::SHAPE_SPHERE, Shape::ShapeType::SHAPE_BOX, IntersectSphereBox);
+	RegisterIntersect(Shape::ShapeType::SHAPE_BOX, Shape::ShapeType::SHAPE_BOX, IntersectBoxBox);
+	RegisterIntersect(Shape::ShapeType::SHAPE_SPHERE, Shape::ShapeType::SHAPE_CONVEX, IntersectConvex);
+	RegisterIntersect(Shape::ShapeType::SHAPE_BOX, Shape::ShapeType::SHAPE_CONVEX, IntersectConvex);
+	RegisterIntersect(Shape::ShapeType::SHAPE_CONVEX, Shape::ShapeType::SHAPE_CONVEX, IntersectConvex);
+	RegisterIntersect(Shape::ShapeType::SHAPE_SPHERE, Shape::ShapeType::SHAPE_CAPSULE, IntersectSphereCapsule);
+	RegisterIntersect(Shape::ShapeType::SHAPE_BOX, Shape::ShapeType::SHAPE_CAPSULE, IntersectConvex);
+	RegisterIntersect(Shape::ShapeType::SHAPE_CONVEX, Shape::ShapeType::SHAPE_CAPSULE, IntersectConvex);
+	RegisterIntersect(Shape::ShapeType::SHAPE_CAPSULE, Shape::ShapeType::SHAPE_CAPSULE, IntersectCapsuleCapsule);
+	RegisterIntersect(Shape::ShapeType::SHAPE_SPHERE, Shape::ShapeType::SHAPE_MESH, IntersectMesh);
+	RegisterIntersect(Shape::ShapeType::SHAPE_BOX, Shape::ShapeType::SHAPE_MESH, IntersectMesh);
+	RegisterIntersect(Shape::ShapeType::SHAPE_CONVEX, Shape::ShapeType::SHAPE_MESH, IntersectMesh);
+	RegisterIntersect(Shape::ShapeType::SHAPE_CAPSULE, Shape::ShapeType::SHAPE_MESH, IntersectMesh);
+	RegisterIntersect(Shape::ShapeType::SHAPE_SPHERE, Shape::ShapeType::SHAPE_HEIGHTFIELD, IntersectHeightfield);
+	RegisterIntersect(Shape::ShapeType::SHAPE_BOX, Shape::ShapeType::SHAPE_HEIGHTFIELD, IntersectHeightfield);
+	RegisterIntersect(Shape::ShapeType::SHAPE_CONVEX, Shape::ShapeType::SHAPE_HEIGHTFIELD, IntersectHeightfield);
+	RegisterIntersect(Shape::ShapeType::SHAPE_CAPSULE, Shape::ShapeType::SHAPE_HEIGHTFIELD, IntersectHeightfield);
+
+	// Compounds come last in the type order, so they are always b and every type pairs with them
+	for (int type = 0; type <= (int)Shape::ShapeType::SHAPE_COMPOUND; ++type) {
+		RegisterIntersect((Shape::ShapeType)type, Shape::ShapeType::SHAPE_COMPOUND, IntersectCompound);
+	}
+}
+
+bool Intersections::Intersect(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact& contact)
+{
+	Contact contacts[MAX_CONTACTS_PER_PAIR];
+	const int numContacts = Intersect(context, a, b, dt, contacts, MAX_CONTACTS_PER_PAIR);
+	if (numContacts == 0) return false;
+
+	contact = contacts[0];
+	return true;
+}
+
+/// <summary>
+/// Look up the kernel for the pair of shapes and run it.
+/// Contacts are returned with a and b in the caller's order.
+/// </summary>
+int Intersections::Intersect(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	assert(context.scratch != nullptr);
+	RegisterBuiltinKernels();
+
+	const int cell = CellIndex(a.shape->GetType(), b.shape->GetType());
+	IntersectFn fn = GetIntersectTable().pairFns[cell / IntersectTable::NUM_TYPES][cell % IntersectTable::NUM_TYPES];
+	if (fn == nullptr) return 0;
+
+	if (a.shape->GetType() <= b.shape->GetType()) {
+		return fn(context, a, b, dt, contacts, maxContacts);
+	}
+
+	const int numContacts = fn(context, b, a, dt, contacts, maxContacts);
+	for (int i = 0; i < numContacts; ++i) {
+		FlipContact(contacts[i]);
+	}
+
+	return numContacts;
+}
+
+/// <summary>
+/// Bucket the pairs by table cell, then run every kernel over its contiguous bucket.
+/// Pairs keep their relative order inside a bucket.
+/// </summary>
+int Intersections::IntersectPairs(const NarrowphaseContext& context, Body* bodies, const CollisionPair* pairs, const int numPairs, const float dt, Contact* contacts, const int maxContacts)
+{
+	assert(context.scratch != nullptr);
+	RegisterBuiltinKernels();
+
+	const int numCells = IntersectTable::NUM_TYPES * IntersectTable::NUM_TYPES;
+	const IntersectTable& table = GetIntersectTable();
+
+	// Counting sort of the pairs by cell, swapping them into canonical order on the way
+	int offsets[numCells + 1] = {};
+	for (int i = 0; i < numPairs; ++i) {
+		const int cell = CellIndex(bodies[pairs[i].a].shape->GetType(), bodies[pairs[i].b].shape->GetType());
+		++offsets[cell + 1];
+	}
+	for (int c = 0; c < numCells; ++c) {
+		offsets[c + 1] += offsets[c];
+	}
+
+	std::vector<CollisionPair> buckets(numPairs);
+	int cursor[numCells];
+	for (int c = 0; c < numCells; ++c) {
+		cursor[c] = offsets[c];
+	}
+	for (int i = 0; i < numPairs; ++i) {
+		CollisionPair pair = pairs[i];
+		if (bodies[pair.a].shape->GetType() > bodies[pair.b].shape->GetType()) {
+			const int tmp = pair.a;
+			pair.a = pair.b;
+			pair.b = tmp;
+		}
+
+		const int cell = CellIndex(bodies[pair.a].shape->GetType(), bodies[pair.b].shape->GetType());
+		buckets[cursor[cell]++] = pair;
+	}
+
+	// Run each kernel over its batch
+	int numContacts = 0;
+	for (int c = 0; c < numCells; ++c) {
+		const int begin = offsets[c];
+		const int num = offsets[c + 1] - begin;
+		if (num == 0) continue;
+
+		const int i = c / IntersectTable::NUM_TYPES;
+		const int j = c % IntersectTable::NUM_TYPES;
+		if (table.batchFns[i][j] != nullptr) {
+			numContacts += table.batchFns[i][j](context, bodies, buckets.data() + begin, num, dt, contacts + numContacts, maxContacts - numContacts);
+		}
+		else if (table.pairFns[i][j] != nullptr) {
+			numContacts += IntersectBatchDefault(table.pairFns[i][j], context, bodies, buckets.data() + begin, num, dt, contacts + numContacts, maxContacts - numContacts);
+		}
+	}
+
+	return numContacts;
+}
+
+int Intersections::IntersectSphereSphere(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	Contact& contact = contacts[0];
 	contact.a = &a;
 	contact.b = &b;
 
-	const Vec3 ab = b.position - a.position;
+	const ShapeSphere* sphereA = static_cast<const ShapeSphere*>(a.shape);
+	const ShapeSphere* sphereB = static_cast<const ShapeSphere*>(b.shape);
 
-	contact.normal = ab;
-	contact.normal.Normalize();
+	Vec3 posA = a.position;
+	Vec3 posB = b.position;
+	Vec3 valA = a.linearVelocity;
+	Vec3 velB = b.linearVelocity;
 
-	//v Spheres collisions ===========================================
-	if (a.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE &&
-		b.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE) {
+	if (SphereSphereDynamic(*sphereA, *sphereB, posA, posB, valA, velB, dt, contact.ptOnAWorldSpace, contact.ptOnBWorldSpace, contact.timeOfImpact))
+	{
+		FinishSphereContact(a, b, contact);
+		return 1;
+	}
 
-		ShapeSphere* sphereA = reinterpret_cast<ShapeSphere*>(a.shape);
-		ShapeSphere* sphereB = reinterpret_cast<ShapeSphere*>(b.shape);
+	return 0;
+}
 
-		Vec3 posA = a.position;
-		Vec3 posB = b.position;
-		Vec3 valA = a.linearVelocity;
-		Vec3 velB = b.linearVelocity;
+/// <summary>
+/// Same as IntersectSphereSphere, with the time of impact of the whole batch
+/// computed up front by SphereSphereDynamicBatch
+/// </summary>
+int Intersections::IntersectSphereSphereBatch(const NarrowphaseContext& context, Body* bodies, const CollisionPair* pairs, const int numPairs, const float dt, Contact* contacts, const int maxContacts)
+{
+	SpherePairBatch& batch = context.scratch->sphereBatch;
+	batch.Resize(numPairs);
 
-		if (SphereSphereDynamic(*sphereA, *sphereB, posA, posB, valA, velB, dt, contact.ptOnAWorldSpace, contact.ptOnBWorldSpace, contact.timeOfImpact))
-		{
-			// Step bodies forward to get local space collision points
-			a.Update(contact.timeOfImpact);
-			b.Update(contact.timeOfImpact);
-	
-			// Convert world space contacts to local space
-			contact.ptOnALocalSpace = a.WorldSpaceToBodySpace(contact.ptOnAWorldSpace);
-			contact.ptOnBLocalSpace = b.WorldSpaceToBodySpace(contact.ptOnBWorldSpace);
-
-			Vec3 ab = a.position - b.position;
-			contact.normal = ab;
-			contact.normal.Normalize();
-
-			// Unwind time step
-			a.Update(-contact.timeOfImpact);
-			b.Update(-contact.timeOfImpact);
-
-			// Calculate separation distance
-			float r = ab.GetMagnitude() - (sphereA->radius + sphereB->radius);
-			contact.separationDistance = r;
-
-			return true;
-		}
+	float* posAX = batch.Get(SpherePairBatch::POS_A_X);
+	float* posAY = batch.Get(SpherePairBatch::POS_A_Y);
+	float* posAZ = batch.Get(SpherePairBatch::POS_A_Z);
+	float* posBX = batch.Get(SpherePairBatch::POS_B_X);
+	float* posBY = batch.Get(SpherePairBatch::POS_B_Y);
+	float* posBZ = batch.Get(SpherePairBatch::POS_B_Z);
+	float* velAX = batch.Get(SpherePairBatch::VEL_A_X);
+	float* velAY = batch.Get(SpherePairBatch::VEL_A_Y);
+	float* velAZ = batch.Get(SpherePairBatch::VEL_A_Z);
+	float* velBX = batch.Get(SpherePairBatch::VEL_B_X);
+	float* velBY = batch.Get(SpherePairBatch::VEL_B_Y);
+	float* velBZ = batch.Get(SpherePairBatch::VEL_B_Z);
+	float* radiusA = batch.Get(SpherePairBatch::RADIUS_A);
+	float* radiusB = batch.Get(SpherePairBatch::RADIUS_B);
+
+	// Gather
+	for (int i = 0; i < numPairs; ++i)
+	{
+		const Body& a = bodies[pairs[i].a];
+		const Body& b = bodies[pairs[i].b];
+
+		posAX[i] = a.position.x;
+		posAY[i] = a.position.y;
+		posAZ[i] = a.position.z;
+		posBX[i] = b.position.x;
+		posBY[i] = b.position.y;
+		posBZ[i] = b.position.z;
+		velAX[i] = a.linearVelocity.x;
+		velAY[i] = a.linearVelocity.y;
+		velAZ[i] = a.linearVelocity.z;
+		velBX[i] = b.linearVelocity.x;
+		velBY[i] = b.linearVelocity.y;
+		velBZ[i] = b.linearVelocity.z;
+		radiusA[i] = static_cast<const ShapeSphere*>(a.shape)->radius;
+		radiusB[i] = static_cast<const ShapeSphere*>(b.shape)->radius;
 	}
-	//^ Spheres collisions ===========================================
 
-	return false;
+	SphereSphereDynamicBatch(batch, dt, GetSphereBatchMode());
+
+	// Scatter the hits into contacts, in pair order
+	const float* toi = batch.Get(SpherePairBatch::TIME_OF_IMPACT);
+	const float* ptAX = batch.Get(SpherePairBatch::PT_ON_A_X);
+	const float* ptAY = batch.Get(SpherePairBatch::PT_ON_A_Y);
+	const float* ptAZ = batch.Get(SpherePairBatch::PT_ON_A_Z);
+	const float* ptBX = batch.Get(SpherePairBatch::PT_ON_B_X);
+	const float* ptBY = batch.Get(SpherePairBatch::PT_ON_B_Y);
+	const float* ptBZ = batch.Get(SpherePairBatch::PT_ON_B_Z);
+
+	int numContacts = 0;
+	for (int i = 0; i < numPairs; ++i)
+	{
+		if (numContacts >= maxContacts) break;
+		if (batch.hit[i] == 0) continue;
+
+		Contact& contact = contacts[numContacts++];
+		contact.a = &bodies[pairs[i].a];
+		contact.b = &bodies[pairs[i].b];
+		contact.timeOfImpact = toi[i];
+		contact.ptOnAWorldSpace = Vec3(ptAX[i], ptAY[i], ptAZ[i]);
+		contact.ptOnBWorldSpace = Vec3(ptBX[i], ptBY[i], ptBZ[i]);
+
+		FinishSphereContact(*contact.a, *contact.b, contact);
+	}
+
+	return numContacts;
+}
+
+/// <summary>
+/// Fill in the local space points, normal and separation of a sphere-sphere contact
+/// from its world space points and time of impact
+/// </summary>
+void Intersections::FinishSphereContact(Body& a, Body& b, Contact& contact)
+{
+	// Step copies of the bodies forward to get local space collision points,
+	// stepping the bodies themselves back by -toi doesn't exactly restore them
+	Body bodyA = a;
+	Body bodyB = b;
+	bodyA.Update(contact.timeOfImpact);
+	bodyB.Update(contact.timeOfImpact);
+
+	// Convert world space contacts to local space
+	contact.ptOnALocalSpace = bodyA.WorldSpaceToBodySpace(contact.ptOnAWorldSpace);
+	contact.ptOnBLocalSpace = bodyB.WorldSpaceToBodySpace(contact.ptOnBWorldSpace);
+
+	Vec3 ab = bodyB.position - bodyA.position;
+	contact.normal = ab;
+	contact.normal.Normalize();
+
+	// Calculate separation distance
+	const ShapeSphere* sphereA = static_cast<const ShapeSphere*>(a.shape);
+	const ShapeSphere* sphereB = static_cast<const ShapeSphere*>(b.shape);
+	float r = ab.GetMagnitude() - (sphereA->radius + sphereB->radius);
+	contact.separationDistance = r;
 }
 
 bool Intersections::RaySphere(const Vec3& rayStart, const Vec3& rayDir, const Vec3& sphereCenter, const float sphereRadius, float& t0, float& t1)
@@ -76,6 +388,11 @@ bool Intersections::RaySphere(const Vec3& rayStart, const Vec3& rayDir, const Ve
 }
 
 bool Intersections::SphereSphereDynamic(const ShapeSphere& shapeA, const ShapeSphere& shapeB, const Vec3& posA, const Vec3& posB, const Vec3& velA, const Vec3& velB, const float dt, Vec3& ptOnA, Vec3& ptOnB, float& timeOfImpact)
+{
+	return SphereSphereDynamic(shapeA.radius, shapeB.radius, posA, posB, velA, velB, dt, ptOnA, ptOnB, timeOfImpact);
+}
+
+bool Intersections::SphereSphereDynamic(const float radiusA, const float radiusB, const Vec3& posA, const Vec3& posB, const Vec3& velA, const Vec3& velB, const float dt, Vec3& ptOnA, Vec3& ptOnB, float& timeOfImpact)
 {
 	const Vec3 relativeVelocity = velA - velB;
 
@@ -89,14 +406,14 @@ bool Intersections::SphereSphereDynamic(const ShapeSphere& shapeA, const ShapeSp
 	{
 		// Ray is too short, just check if already intersecting
 		Vec3 ab = posB - posA;
-		float radius = shapeA.radius + shapeB.radius + 0.001f;
+		float radius = radiusA + radiusB + 0.001f;
 
 		if (ab.GetLengthSqr() > radius * radius)
 		{
 			return false;
 		}
 	}
-	else if (!RaySphere(startPtA, rayDir, posB,	shapeA.radius + shapeB.radius, t0, t1))
+	else if (!RaySphere(startPtA, rayDir, posB,	radiusA + radiusB, t0, t1))
 	{
 		return false;
 	}
@@ -124,8 +441,8 @@ bool Intersections::SphereSphereDynamic(const ShapeSphere& shapeA, const ShapeSp
 	Vec3 ab = newPosB - newPosA;
 	ab.Normalize();
 
-	ptOnA = newPosA + ab * shapeA.radius;
-	ptOnB = newPosB - ab * shapeB.radius;
+	ptOnA = newPosA + ab * radiusA;
+	ptOnB = newPosB - ab * radiusB;
 
 	return true;
 }
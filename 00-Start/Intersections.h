@@ -2,14 +2,114 @@
 #include "Body.h"
 #include "Shape.h"
 #include "Contact.h"
+#include "Broadphase.h"
+#include "SphereBatch.h"
+#include <vector>
 
+class GJKCache;
+
+/// <summary>
+/// Lists the kernels fill and empty again on every call, kept by the caller so they aren't
+/// reallocated every step. A scratch must only be used by one call of the narrowphase at a time.
+/// </summary>
+struct NarrowphaseScratch
+{
+	SpherePairBatch sphereBatch;
+
+	// Triangles near a body, for the mesh and heightfield kernels
+	std::vector<int> triangleCandidates;
+	std::vector<Vec3> triangles;
+
+	// Children near a body. Nested calls for a compound a append after their caller's
+	// children and truncate back, so indices stay valid across them.
+	std::vector<int> childCandidates;
+
+	Contact::ManifoldScratch manifold;
+};
+
+/// <summary>
+/// State the narrowphase kernels share, owned by whoever runs them and handed down
+/// through every kernel, so two scenes never see each other's
+/// </summary>
+struct NarrowphaseContext
+{
+	// Lists for the kernels to work in, required
+	NarrowphaseScratch* scratch = nullptr;
+
+	// Where the GJK kernel keeps its per pair warm start, none when null
+	GJKCache* gjkCache = nullptr;
+
+	// Where the mesh kernels add up their BVH and heightfield pyramid work, none when null
+	BVHQueryStats* meshQueryStats = nullptr;
+};
 
 class Intersections
 {
 public: 
-	static bool Intersect(Body& a, Body& b, const float dt, Contact& contact);
+	// Narrowphase kernel for a single pair, the bodies come in the canonical order of
+	// the table cell (shape type of a <= shape type of b). Writes at most maxContacts
+	// contacts, with normals pointing from a to b, and returns how many were written.
+	typedef int (*IntersectFn)(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+
+	// Narrowphase kernel for a contiguous batch of pairs that all map to the same table cell,
+	// already in canonical order
+	typedef int (*IntersectBatchFn)(const NarrowphaseContext& context, Body* bodies, const CollisionPair* pairs, const int numPairs, const float dt, Contact* contacts, const int maxContacts);
+
+	static void RegisterIntersect(const Shape::ShapeType typeA, const Shape::ShapeType typeB, IntersectFn fn);
+	static void RegisterIntersectBatch(const Shape::ShapeType typeA, const Shape::ShapeType typeB, IntersectBatchFn fn);
+
+	static bool Intersect(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact& contact);
+	static int Intersect(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+	// Every pair's contacts come out reduced to a few per contact plane, see Contact::ReduceManifold
+	static int IntersectPairs(const NarrowphaseContext& context, Body* bodies, const CollisionPair* pairs, const int numPairs, const float dt, Contact* contacts, const int maxContacts);
+
 	static bool RaySphere(const Vec3& rayStart, const Vec3& rayDir, const Vec3& sphereCenter, const float sphereRadius, float& t0, float& t1);
 	static bool SphereSphereDynamic(const ShapeSphere& shapeA, const ShapeSphere& shapeB, const Vec3& posA, const Vec3& posB, const Vec3& velA, const Vec3& velB, const float dt, Vec3& ptOnA, Vec3& ptOnB, float& timeOfImpact);
+	static bool SphereSphereDynamic(const float radiusA, const float radiusB, const Vec3& posA, const Vec3& posB, const Vec3& velA, const Vec3& velB, const float dt, Vec3& ptOnA, Vec3& ptOnB, float& timeOfImpact);
 
-};
+	// Time of impact of two convex bodies within dt, by conservative advancement.
+	// Contacts come back at that time, with a positive separation close to zero.
+	static bool ConservativeAdvance(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact& contact);
+	// Whether the body sweeps far enough in dt, relative to its size, to tunnel through something
+	static bool NeedsContinuous(const Body& body, const float dt);
+
+	// Most contacts a single pair may produce, once reduced
+	static const int MAX_CONTACTS_PER_PAIR = Contact::MAX_MANIFOLD_CLUSTERS * Contact::MAX_MANIFOLD_POINTS;
+
+private:
+	static void RegisterBuiltinKernels();
+
+	static int IntersectSphereSphere(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+	static int IntersectSphereSphereBatch(const NarrowphaseContext& context, Body* bodies, const CollisionPair* pairs, const int numPairs, const float dt, Contact* contacts, const int maxContacts);
+	static void FinishSphereContact(Body& a, Body& b, Contact& contact);
+
+	// Discrete separating axis kernels, in BoxIntersections.cpp
+	static int IntersectSphereBox(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+	static int IntersectBoxBox(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
 
+	// Closed form kernels on the segments at the core of capsules, in CapsuleIntersections.cpp
+	static int IntersectSphereCapsule(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+	static int IntersectCapsuleCapsule(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+
+	// Any pair of convex shapes through their support functions, in ConvexIntersections.cpp
+	static int IntersectConvex(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+
+	// Static triangle meshes and heightfields, in MeshIntersections.cpp. The triangles near a are handed
+	// one at a time, in world space, to IntersectTriangle, with b standing in for the body they belong to.
+	static int IntersectMesh(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+	static int IntersectHeightfield(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+	static Bounds BoundsInBodySpace(const Body& a, const Body& b);
+	static int IntersectTriangleList(Body& a, Body& b, const Vec3* triangles, const int numTriangles, Contact* contacts, const int maxContacts);
+	static int IntersectTriangle(Body& a, Body& b, const Vec3* triangle, Contact* contacts, const int maxContacts);
+	static int IntersectSphereTriangle(Body& a, Body& b, const Vec3* triangle, Contact* contacts, const int maxContacts);
+	// In ConvexIntersections.cpp, it shares the feature clipping of IntersectConvex
+	static int IntersectConvexTriangle(Body& a, Body& b, const Vec3* triangle, Contact* contacts, const int maxContacts);
+
+	// Compounds against anything, including other compounds, in CompoundIntersections.cpp.
+	// Every child near a goes through the kernel of its own pair of shapes.
+	static int IntersectCompound(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+
+	// Continuous fallback of the discrete kernels, for pairs they found apart
+	static int IntersectSwept(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts);
+
+};
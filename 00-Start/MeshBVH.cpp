@@ -0,0 +1,230 @@
+#include "MeshBVH.h"
+#include <algorithm>
+
+
+// Candidate split planes per axis for the surface area heuristic
+static const int SAH_BINS = 16;
+
+// Cost of visiting a node, relative to testing one triangle
+static const float SAH_TRAVERSAL_COST = 1.0f;
+
+// Ranges this small always become leaves
+static const int LEAF_TRIANGLES = 4;
+
+// Past this depth nodes are split in halves, so the traversal stack below always suffices
+static const int SAH_MAX_DEPTH = 32;
+static const int MAX_STACK_DEPTH = 64;
+
+static const float QUANTIZED_MAX = 65535.0f;
+
+static float SurfaceArea(const Bounds& bounds)
+{
+	const Vec3 extent = bounds.maxs - bounds.mins;
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+//v Build =================================================================
+void MeshBVH::Build(const std::vector<Vec3>& verts, std::vector<tri_t>& tris)
+{
+	assert(tris.size() < BVHNode::MAX_TRIANGLES);
+
+	nodes.clear();
+	bounds.Clear();
+
+	std::vector<BuildTriangle> buildTris(tris.size());
+	for (int i = 0; i < tris.size(); ++i) {
+		BuildTriangle& buildTri = buildTris[i];
+		buildTri.bounds.Expand(verts[tris[i].a]);
+		buildTri.bounds.Expand(verts[tris[i].b]);
+		buildTri.bounds.Expand(verts[tris[i].c]);
+		buildTri.centroid = (buildTri.bounds.mins + buildTri.bounds.maxs) * 0.5f;
+		buildTri.index = i;
+
+		bounds.Expand(buildTri.bounds);
+	}
+
+	if (buildTris.empty()) return;
+
+	const Vec3 extent = bounds.maxs - bounds.mins;
+	for (int i = 0; i < 3; ++i) {
+		scale[i] = (extent[i] > 0.0f) ? QUANTIZED_MAX / extent[i] : 0.0f;
+	}
+
+	// A binary tree over n leaves has 2n - 1 nodes
+	nodes.reserve(2 * (buildTris.size() / LEAF_TRIANGLES + 1));
+	BuildNode(buildTris, 0, (int)buildTris.size(), 0);
+
+	// Leaves reference ranges of the triangles in build order
+	std::vector<tri_t> sorted(tris.size());
+	for (int i = 0; i < buildTris.size(); ++i) {
+		sorted[i] = tris[buildTris[i].index];
+	}
+	tris.swap(sorted);
+}
+
+int MeshBVH::BuildNode(std::vector<BuildTriangle>& buildTris, const int begin, const int end, const int depth)
+{
+	const int nodeIdx = (int)nodes.size();
+	nodes.push_back(BVHNode());
+
+	Bounds nodeBounds;
+	Bounds centroidBounds;
+	for (int i = begin; i < end; ++i) {
+		nodeBounds.Expand(buildTris[i].bounds);
+		centroidBounds.Expand(buildTris[i].centroid);
+	}
+	Quantize(nodeBounds, nodes[nodeIdx].mins, nodes[nodeIdx].maxs);
+
+	const int count = end - begin;
+	if (count <= LEAF_TRIANGLES) {
+		nodes[nodeIdx].data = BVHNode::LEAF_FLAG | ((uint32_t)count << 24) | (uint32_t)begin;
+		return nodeIdx;
+	}
+
+	// Binned surface area heuristic, the best plane over the three axes
+	int bestAxis = -1;
+	int bestSplit = 0;
+	float bestCost = (float)count;
+	const float invArea = 1.0f / fmaxf(SurfaceArea(nodeBounds), 1e-12f);
+	for (int axis = 0; axis < 3 && depth < SAH_MAX_DEPTH; ++axis) {
+		const float axisMin = centroidBounds.mins[axis];
+		const float axisExtent = centroidBounds.maxs[axis] - axisMin;
+		if (axisExtent <= 0.0f) continue;
+
+		Bounds binBounds[SAH_BINS];
+		int binCounts[SAH_BINS] = { 0 };
+		const float binScale = (float)SAH_BINS / axisExtent;
+		for (int i = begin; i < end; ++i) {
+			const int bin = std::min(SAH_BINS - 1, (int)((buildTris[i].centroid[axis] - axisMin) * binScale));
+			binBounds[bin].Expand(buildTris[i].bounds);
+			++binCounts[bin];
+		}
+
+		// Sweep from the right for the cost of every right side, then from the left
+		float rightAreas[SAH_BINS];
+		int rightCounts[SAH_BINS];
+		Bounds right;
+		int rightCount = 0;
+		for (int i = SAH_BINS - 1; i > 0; --i) {
+			// Expanding by a cleared bounds would take in its inverted corners
+			if (binCounts[i] > 0) {
+				right.Expand(binBounds[i]);
+			}
+			rightCount += binCounts[i];
+			rightAreas[i] = (rightCount > 0) ? SurfaceArea(right) : 0.0f;
+			rightCounts[i] = rightCount;
+		}
+
+		Bounds left;
+		int leftCount = 0;
+		for (int i = 1; i < SAH_BINS; ++i) {
+			if (binCounts[i - 1] > 0) {
+				left.Expand(binBounds[i - 1]);
+			}
+			leftCount += binCounts[i - 1];
+			if (leftCount == 0 || rightCounts[i] == 0) continue;
+
+			const float cost = SAH_TRAVERSAL_COST + (SurfaceArea(left) * leftCount + rightAreas[i] * rightCounts[i]) * invArea;
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i;
+			}
+		}
+	}
+
+	int mid = begin;
+	if (bestAxis >= 0) {
+		const float axisMin = centroidBounds.mins[bestAxis];
+		const float binScale = (float)SAH_BINS / (centroidBounds.maxs[bestAxis] - axisMin);
+		BuildTriangle* split = std::partition(buildTris.data() + begin, buildTris.data() + end, [&](const BuildTriangle& tri) {
+			return std::min(SAH_BINS - 1, (int)((tri.centroid[bestAxis] - axisMin) * binScale)) < bestSplit;
+		});
+		mid = (int)(split - buildTris.data());
+	}
+	else if (count <= BVHNode::MAX_LEAF_TRIANGLES) {
+		// Splitting costs more than testing them all, or there is nothing left to split on
+		nodes[nodeIdx].data = BVHNode::LEAF_FLAG | ((uint32_t)count << 24) | (uint32_t)begin;
+		return nodeIdx;
+	}
+	else {
+		// Too many triangles sharing a centroid for a leaf: halve along the longest axis
+		const Vec3 extent = centroidBounds.maxs - centroidBounds.mins;
+		const int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : ((extent.y >= extent.z) ? 1 : 2);
+		mid = begin + count / 2;
+		std::nth_element(buildTris.data() + begin, buildTris.data() + mid, buildTris.data() + end, [axis](const BuildTriangle& lhs, const BuildTriangle& rhs) {
+			return lhs.centroid[axis] < rhs.centroid[axis];
+		});
+	}
+
+	BuildNode(buildTris, begin, mid, depth + 1);
+	const int secondChild = BuildNode(buildTris, mid, end, depth + 1);
+	nodes[nodeIdx].data = (uint32_t)secondChild;
+
+	return nodeIdx;
+}
+
+void MeshBVH::Quantize(const Bounds& box, uint16_t* qMins, uint16_t* qMaxs) const
+{
+	for (int i = 0; i < 3; ++i) {
+		const float lo = floorf((box.mins[i] - bounds.mins[i]) * scale[i]);
+		const float hi = ceilf((box.maxs[i] - bounds.mins[i]) * scale[i]);
+		qMins[i] = (uint16_t)std::min(std::max(lo, 0.0f), QUANTIZED_MAX);
+		qMaxs[i] = (uint16_t)std::min(std::max(hi, 0.0f), QUANTIZED_MAX);
+	}
+}
+//^ Build =================================================================
+//v Query =================================================================
+int MeshBVH::Query(const Bounds& box, const std::vector<Vec3>& verts, const std::vector<tri_t>& tris, std::vector<int>& triangles, BVHQueryStats* stats) const
+{
+	if (nodes.empty() || !bounds.DoesIntersect(box)) return 0;
+
+	// The query box goes on the same grid, so nodes are tested with integer compares only
+	uint16_t qMins[3];
+	uint16_t qMaxs[3];
+	Quantize(box, qMins, qMaxs);
+
+	BVHQueryStats local;
+	const int numBefore = (int)triangles.size();
+
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const int nodeIdx = stack[--stackSize];
+		const BVHNode& node = nodes[nodeIdx];
+		++local.nodesVisited;
+
+		if (node.mins[0] > qMaxs[0] || node.mins[1] > qMaxs[1] || node.mins[2] > qMaxs[2]) continue;
+		if (node.maxs[0] < qMins[0] || node.maxs[1] < qMins[1] || node.maxs[2] < qMins[2]) continue;
+
+		if (!node.IsLeaf()) {
+			// First child on top, it is the next node in memory
+			stack[stackSize++] = node.SecondChild();
+			stack[stackSize++] = nodeIdx + 1;
+			continue;
+		}
+
+		// Leaves are coarse, weed out their triangles with exact bounds
+		const int first = node.FirstTriangle();
+		const int last = first + node.NumTriangles();
+		for (int i = first; i < last; ++i) {
+			++local.trianglesTested;
+
+			Bounds triBounds;
+			triBounds.Expand(verts[tris[i].a]);
+			triBounds.Expand(verts[tris[i].b]);
+			triBounds.Expand(verts[tris[i].c]);
+			if (triBounds.DoesIntersect(box)) {
+				triangles.push_back(i);
+			}
+		}
+	}
+
+	if (stats != nullptr) {
+		stats->Add(local);
+	}
+
+	return (int)triangles.size() - numBefore;
+}
+//^ Query =================================================================
@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "code/Math/Bounds.h"
+#include "ConvexHull.h"
+
+
+// Work done by one BVH query, what a level costs the narrowphase shows up here
+struct BVHQueryStats
+{
+	int nodesVisited = 0;
+	int trianglesTested = 0;
+
+	void Add(const BVHQueryStats& rhs)
+	{
+		nodesVisited += rhs.nodesVisited;
+		trianglesTested += rhs.trianglesTested;
+	}
+};
+
+/// <summary>
+/// 16 bytes, four nodes to a cache line. Bounds are quantized on a 16 bit grid spanning
+/// the whole mesh, rounded outwards so a node never reports less than it holds.
+/// </summary>
+struct BVHNode
+{
+	uint16_t mins[3];
+	uint16_t maxs[3];
+
+	// Leaves: bit 31 set, triangle count in bits 24 to 30, first triangle in bits 0 to 23.
+	// Inner nodes: index of the second child, the first one is the next node.
+	uint32_t data;
+
+	static const uint32_t LEAF_FLAG = 0x80000000u;
+	static const int MAX_LEAF_TRIANGLES = 127;
+	static const int MAX_TRIANGLES = 1 << 24;
+
+	bool IsLeaf() const { return (data & LEAF_FLAG) != 0; }
+	int FirstTriangle() const { return (int)(data & 0x00ffffffu); }
+	int NumTriangles() const { return (int)((data >> 24) & 0x7fu); }
+	int SecondChild() const { return (int)data; }
+};
+
+/// <summary>
+/// Bounding volume hierarchy over the triangles of a static mesh, in the mesh's body space.
+/// Built top down with a binned surface area heuristic, stored depth first in a single array.
+/// </summary>
+class MeshBVH
+{
+public:
+	// Reorders tris so every leaf references a contiguous range of them
+	void Build(const std::vector<Vec3>& verts, std::vector<tri_t>& tris);
+
+	// Appends the triangles whose bounds overlap the box, in body space,
+	// and returns how many were added
+	int Query(const Bounds& bounds, const std::vector<Vec3>& verts, const std::vector<tri_t>& tris, std::vector<int>& triangles, BVHQueryStats* stats) const;
+
+	const Bounds& GetBounds() const { return bounds; }
+	int NumNodes() const { return (int)nodes.size(); }
+
+private:
+	struct BuildTriangle
+	{
+		Bounds bounds;
+		Vec3 centroid;
+		int index;
+	};
+
+	int BuildNode(std::vector<BuildTriangle>& buildTris, const int begin, const int end, const int depth);
+	void Quantize(const Bounds& box, uint16_t* qMins, uint16_t* qMaxs) const;
+
+	std::vector<BVHNode> nodes;
+	Bounds bounds;
+	// Grid cells per unit along each axis
+	Vec3 scale;
+};
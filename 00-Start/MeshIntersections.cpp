@@ -0,0 +1,203 @@
+#include "Intersections.h"
+#include <math.h>
+#include <vector>
+
+
+// Contacts of neighbouring triangles closer than this along a shared edge or vertex are the same contact
+static const float DUPLICATE_CONTACT_DISTANCE = 0.001f;
+
+static void FillContact(Body& a, Body& b, const Vec3& ptOnA, const Vec3& ptOnB, const Vec3& normal, const float separation, Contact& contact)
+{
+	contact.a = &a;
+	contact.b = &b;
+	contact.ptOnAWorldSpace = ptOnA;
+	contact.ptOnBWorldSpace = ptOnB;
+	contact.ptOnALocalSpace = a.WorldSpaceToBodySpace(ptOnA);
+	contact.ptOnBLocalSpace = b.WorldSpaceToBodySpace(ptOnB);
+	contact.normal = normal;
+	contact.separationDistance = separation;
+	contact.timeOfImpact = 0.0f;
+}
+
+/// <summary>
+/// Closest point of the triangle abc to p, by the Voronoi region p falls in (Ericson, Real-Time Collision Detection 5.1.5)
+/// </summary>
+static Vec3 ClosestPointOnTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+{
+	const Vec3 ab = b - a;
+	const Vec3 ac = c - a;
+
+	const Vec3 ap = p - a;
+	const float d1 = ab.Dot(ap);
+	const float d2 = ac.Dot(ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+	const Vec3 bp = p - b;
+	const float d3 = ab.Dot(bp);
+	const float d4 = ac.Dot(bp);
+	if (d3 >= 0.0f && d4 <= d3) return b;
+
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		return a + ab * (d1 / (d1 - d3));
+	}
+
+	const Vec3 cp = p - c;
+	const float d5 = ab.Dot(cp);
+	const float d6 = ac.Dot(cp);
+	if (d6 >= 0.0f && d5 <= d6) return c;
+
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		return a + ac * (d2 / (d2 - d6));
+	}
+
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+
+	// Inside the face
+	const float denom = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+/// <summary>
+/// Triangles near a, found through the BVH of the mesh in its body space.
+/// Discrete only: meshes are static, and nothing in the demo moves fast enough to skip a triangle in a step.
+/// </summary>
+int Intersections::IntersectMesh(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	const ShapeMesh* mesh = static_cast<const ShapeMesh*>(b.shape);
+
+	std::vector<int>& candidates = context.scratch->triangleCandidates;
+	std::vector<Vec3>& triangles = context.scratch->triangles;
+	candidates.clear();
+	triangles.clear();
+
+	BVHQueryStats stats;
+	const int numCandidates = mesh->bvh.Query(BoundsInBodySpace(a, b), mesh->vertices, mesh->triangles, candidates, &stats);
+	if (context.meshQueryStats != nullptr) {
+		context.meshQueryStats->Add(stats);
+	}
+
+	for (int i = 0; i < numCandidates; ++i) {
+		const tri_t& tri = mesh->triangles[candidates[i]];
+		triangles.push_back(mesh->vertices[tri.a]);
+		triangles.push_back(mesh->vertices[tri.b]);
+		triangles.push_back(mesh->vertices[tri.c]);
+	}
+
+	return IntersectTriangleList(a, b, triangles.data(), numCandidates, contacts, maxContacts);
+}
+
+/// <summary>
+/// Triangles of the cells under a, generated from the heightfield's samples on the spot
+/// </summary>
+int Intersections::IntersectHeightfield(const NarrowphaseContext& context, Body& a, Body& b, const float dt, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	const ShapeHeightfield* heightfield = static_cast<const ShapeHeightfield*>(b.shape);
+
+	std::vector<Vec3>& triangles = context.scratch->triangles;
+	triangles.clear();
+
+	BVHQueryStats stats;
+	const int numTriangles = heightfield->grid.Query(BoundsInBodySpace(a, b), triangles, &stats);
+	if (context.meshQueryStats != nullptr) {
+		context.meshQueryStats->Add(stats);
+	}
+
+	return IntersectTriangleList(a, b, triangles.data(), numTriangles, contacts, maxContacts);
+}
+
+/// <summary>
+/// Bounds of a in the body space of b, tighter than its world bounds brought over
+/// </summary>
+Bounds Intersections::BoundsInBodySpace(const Body& a, const Body& b)
+{
+	const Quat toB = b.orientation.Inverse();
+	return a.shape->GetBounds(toB.RotatePoint(a.position - b.position), toB * a.orientation);
+}
+
+/// <summary>
+/// Test a against triangles given three points each in the body space of b
+/// </summary>
+int Intersections::IntersectTriangleList(Body& a, Body& b, const Vec3* triangles, const int numTriangles, Contact* contacts, const int maxContacts)
+{
+	int numContacts = 0;
+	for (int i = 0; i < numTriangles && numContacts < maxContacts; ++i) {
+		const Vec3 triangle[3] = {
+			b.orientation.RotatePoint(triangles[i * 3 + 0]) + b.position,
+			b.orientation.RotatePoint(triangles[i * 3 + 1]) + b.position,
+			b.orientation.RotatePoint(triangles[i * 3 + 2]) + b.position,
+		};
+
+		Contact triContacts[MAX_CONTACTS_PER_PAIR];
+		const int numTriContacts = IntersectTriangle(a, b, triangle, triContacts, MAX_CONTACTS_PER_PAIR);
+
+		// Triangles sharing an edge or a vertex report the contacts on it once each
+		for (int j = 0; j < numTriContacts && numContacts < maxContacts; ++j) {
+			bool isDuplicate = false;
+			for (int k = 0; k < numContacts && !isDuplicate; ++k) {
+				const Vec3 delta = contacts[k].ptOnBWorldSpace - triContacts[j].ptOnBWorldSpace;
+				isDuplicate = delta.GetLengthSqr() < DUPLICATE_CONTACT_DISTANCE * DUPLICATE_CONTACT_DISTANCE;
+			}
+
+			if (!isDuplicate) {
+				contacts[numContacts++] = triContacts[j];
+			}
+		}
+	}
+
+	return numContacts;
+}
+
+int Intersections::IntersectTriangle(Body& a, Body& b, const Vec3* triangle, Contact* contacts, const int maxContacts)
+{
+	if (a.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE) {
+		return IntersectSphereTriangle(a, b, triangle, contacts, maxContacts);
+	}
+
+	return IntersectConvexTriangle(a, b, triangle, contacts, maxContacts);
+}
+
+/// <summary>
+/// Triangles are one sided, facing the side they wind counter clockwise from.
+/// A sphere whose center went behind one is pushed back out of its front.
+/// </summary>
+int Intersections::IntersectSphereTriangle(Body& a, Body& b, const Vec3* triangle, Contact* contacts, const int maxContacts)
+{
+	if (maxContacts < 1) return 0;
+
+	const float radius = static_cast<const ShapeSphere*>(a.shape)->radius;
+	const Vec3 center = a.GetCenterOfMassWorldSpace();
+
+	const Vec3 closest = ClosestPointOnTriangle(center, triangle[0], triangle[1], triangle[2]);
+	const Vec3 delta = closest - center;
+	const float distanceSqr = delta.GetLengthSqr();
+	if (distanceSqr > radius * radius) return 0;
+
+	Vec3 faceNormal = (triangle[1] - triangle[0]).Cross(triangle[2] - triangle[0]);
+	const float area = faceNormal.GetMagnitude();
+	if (area < 1e-12f) return 0;
+	faceNormal /= area;
+
+	// From the sphere to the triangle
+	Vec3 normal;
+	const float distance = sqrtf(distanceSqr);
+	if (faceNormal.Dot(center - triangle[0]) <= 0.0f || distance < 1e-6f) {
+		normal = faceNormal * -1.0f;
+	}
+	else {
+		normal = delta / distance;
+	}
+
+	const Vec3 ptOnSphere = center + normal * radius;
+	FillContact(a, b, ptOnSphere, closest, normal, (closest - ptOnSphere).Dot(normal), contacts[0]);
+
+	return 1;
+}
@@ -1,6 +1,14 @@
 #include "Shape.h"
 
 
+void Shape::Build()
+{
+    inertiaTensor = InertiaTensor();
+    inverseInertiaTensor = inertiaTensor.Inverse();
+    localBounds = GetBounds();
+    boundingRadius = BoundingRadius();
+}
+
 Mat3 ShapeSphere::InertiaTensor() const
 {
     Mat3 tensor;
@@ -30,3 +38,458 @@ Bounds ShapeSphere::GetBounds() const
 
     return tmp;
 }
+
+Vec3 ShapeSphere::Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const
+{
+    return pos + dir * (radius + bias);
+}
+
+float ShapeSphere::BoundingRadius() const
+{
+    return radius;
+}
+
+Mat3 ShapeBox::InertiaTensor() const
+{
+    // Solid box of unit mass, with full dimensions d: I = (d1^2 + d2^2) / 12 = (h1^2 + h2^2) / 3
+    const float xx = halfExtents.x * halfExtents.x;
+    const float yy = halfExtents.y * halfExtents.y;
+    const float zz = halfExtents.z * halfExtents.z;
+
+    Mat3 tensor;
+    tensor.Zero();
+
+    tensor.rows[0][0] = (yy + zz) / 3.0f;
+    tensor.rows[1][1] = (xx + zz) / 3.0f;
+    tensor.rows[2][2] = (xx + yy) / 3.0f;
+
+    return tensor;
+}
+
+Bounds ShapeBox::GetBounds(const Vec3& pos, const Quat& orient) const
+{
+    Bounds tmp;
+    for (int i = 0; i < 8; ++i) {
+        tmp.Expand(orient.RotatePoint(points[i]) + pos);
+    }
+
+    return tmp;
+}
+
+Bounds ShapeBox::GetBounds() const
+{
+    Bounds tmp;
+    tmp.mins = halfExtents * -1.0f;
+    tmp.maxs = halfExtents;
+
+    return tmp;
+}
+
+Vec3 ShapeBox::Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const
+{
+    // Pick the corner on the dir side of every box axis
+    const Mat3 axes = orient.ToMat3();
+
+    Vec3 pt = pos;
+    for (int i = 0; i < 3; ++i) {
+        const float side = (axes.rows[i].Dot(dir) < 0.0f) ? -halfExtents[i] : halfExtents[i];
+        pt += axes.rows[i] * side;
+    }
+
+    return pt + dir * bias;
+}
+
+float ShapeBox::BoundingRadius() const
+{
+    return halfExtents.GetMagnitude();
+}
+
+ShapeConvex::ShapeConvex(const Vec3* pts, const int num) : Shape(ShapeType::SHAPE_CONVEX)
+{
+    const std::vector<Vec3> cloud(pts, pts + num);
+    BuildConvexHull(cloud, points, triangles);
+
+    centerOfMass = CalculateCenterOfMass(points, triangles);
+    Build();
+}
+
+Mat3 ShapeConvex::InertiaTensor() const
+{
+    return CalculateInertiaTensor(points, triangles, centerOfMass);
+}
+
+Bounds ShapeConvex::GetBounds(const Vec3& pos, const Quat& orient) const
+{
+    Bounds tmp;
+    for (int i = 0; i < points.size(); ++i) {
+        tmp.Expand(orient.RotatePoint(points[i]) + pos);
+    }
+
+    return tmp;
+}
+
+Bounds ShapeConvex::GetBounds() const
+{
+    Bounds tmp;
+    tmp.Expand(points.data(), (int)points.size());
+
+    return tmp;
+}
+
+Vec3 ShapeConvex::Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const
+{
+    // Search in body space, so only the winner gets rotated
+    const Vec3 localDir = orient.Inverse().RotatePoint(dir);
+
+    int maxIdx = 0;
+    float maxDist = localDir.Dot(points[0]);
+    for (int i = 1; i < points.size(); ++i) {
+        const float dist = localDir.Dot(points[i]);
+        if (dist > maxDist) {
+            maxDist = dist;
+            maxIdx = i;
+        }
+    }
+
+    return orient.RotatePoint(points[maxIdx]) + pos + dir * bias;
+}
+
+float ShapeConvex::BoundingRadius() const
+{
+    float maxDistSqr = 0.0f;
+    for (int i = 0; i < points.size(); ++i) {
+        const float distSqr = (points[i] - centerOfMass).GetLengthSqr();
+        if (distSqr > maxDistSqr) {
+            maxDistSqr = distSqr;
+        }
+    }
+
+    return sqrtf(maxDistSqr);
+}
+
+Mat3 ShapeCapsule::InertiaTensor() const
+{
+    // Unit mass shared by volume between the cylinder and the two hemispheres
+    const float pi = 3.14159265f;
+    const float height = 2.0f * halfHeight;
+    const float rr = radius * radius;
+    const float cylinderVolume = pi * rr * height;
+    const float sphereVolume = 4.0f * pi * rr * radius / 3.0f;
+    const float cylinderMass = cylinderVolume / (cylinderVolume + sphereVolume);
+    const float sphereMass = 1.0f - cylinderMass;
+
+    // The hemispheres' own inertia, moved out to the ends of the cylinder
+    const float axial = cylinderMass * rr / 2.0f + sphereMass * 2.0f * rr / 5.0f;
+    const float transverse = cylinderMass * (height * height / 12.0f + rr / 4.0f)
+        + sphereMass * (2.0f * rr / 5.0f + height * height / 4.0f + 3.0f * height * radius / 8.0f);
+
+    Mat3 tensor;
+    tensor.Zero();
+
+    tensor.rows[0][0] = transverse;
+    tensor.rows[1][1] = transverse;
+    tensor.rows[2][2] = axial;
+
+    return tensor;
+}
+
+void ShapeCapsule::GetSegment(const Vec3& pos, const Quat& orient, Vec3& p0, Vec3& p1) const
+{
+    const Vec3 axis = orient.RotatePoint(Vec3(0.0f, 0.0f, halfHeight));
+    p0 = pos - axis;
+    p1 = pos + axis;
+}
+
+Bounds ShapeCapsule::GetBounds(const Vec3& pos, const Quat& orient) const
+{
+    Vec3 p0, p1;
+    GetSegment(pos, orient, p0, p1);
+
+    Bounds tmp;
+    tmp.Expand(p0 - Vec3(radius));
+    tmp.Expand(p0 + Vec3(radius));
+    tmp.Expand(p1 - Vec3(radius));
+    tmp.Expand(p1 + Vec3(radius));
+
+    return tmp;
+}
+
+Bounds ShapeCapsule::GetBounds() const
+{
+    Bounds tmp;
+    tmp.mins = Vec3(-radius, -radius, -halfHeight - radius);
+    tmp.maxs = Vec3(radius, radius, halfHeight + radius);
+
+    return tmp;
+}
+
+Vec3 ShapeCapsule::Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const
+{
+    Vec3 p0, p1;
+    GetSegment(pos, orient, p0, p1);
+
+    const Vec3 end = (dir.Dot(p1 - p0) > 0.0f) ? p1 : p0;
+    return end + dir * (radius + bias);
+}
+
+float ShapeCapsule::BoundingRadius() const
+{
+    return halfHeight + radius;
+}
+
+ShapeMesh::ShapeMesh(const Vec3* verts, const int numVerts, const tri_t* tris, const int numTris) :
+    Shape(ShapeType::SHAPE_MESH), vertices(verts, verts + numVerts), triangles(tris, tris + numTris)
+{
+    bvh.Build(vertices, triangles);
+
+    centerOfMass.Zero();
+    Build();
+}
+
+Mat3 ShapeMesh::InertiaTensor() const
+{
+    // Solid box of the bounds, only there to keep the tensor invertible
+    const Bounds bounds = bvh.GetBounds();
+    const float xx = bounds.WidthX() * bounds.WidthX();
+    const float yy = bounds.WidthY() * bounds.WidthY();
+    const float zz = bounds.WidthZ() * bounds.WidthZ();
+
+    Mat3 tensor;
+    tensor.Zero();
+
+    tensor.rows[0][0] = (yy + zz) / 12.0f;
+    tensor.rows[1][1] = (xx + zz) / 12.0f;
+    tensor.rows[2][2] = (xx + yy) / 12.0f;
+
+    return tensor;
+}
+
+Bounds ShapeMesh::GetBounds(const Vec3& pos, const Quat& orient) const
+{
+    const Bounds& bounds = bvh.GetBounds();
+
+    Bounds tmp;
+    for (int i = 0; i < 8; ++i) {
+        const Vec3 corner(
+            (i & 1) ? bounds.maxs.x : bounds.mins.x,
+            (i & 2) ? bounds.maxs.y : bounds.mins.y,
+            (i & 4) ? bounds.maxs.z : bounds.mins.z);
+        tmp.Expand(orient.RotatePoint(corner) + pos);
+    }
+
+    return tmp;
+}
+
+Bounds ShapeMesh::GetBounds() const
+{
+    return bvh.GetBounds();
+}
+
+Vec3 ShapeMesh::Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const
+{
+    const Vec3 localDir = orient.Inverse().RotatePoint(dir);
+
+    int maxIdx = 0;
+    float maxDist = localDir.Dot(vertices[0]);
+    for (int i = 1; i < vertices.size(); ++i) {
+        const float dist = localDir.Dot(vertices[i]);
+        if (dist > maxDist) {
+            maxDist = dist;
+            maxIdx = i;
+        }
+    }
+
+    return orient.RotatePoint(vertices[maxIdx]) + pos + dir * bias;
+}
+
+float ShapeMesh::BoundingRadius() const
+{
+    float maxDistSqr = 0.0f;
+    for (int i = 0; i < vertices.size(); ++i) {
+        const float distSqr = vertices[i].GetLengthSqr();
+        if (distSqr > maxDistSqr) {
+            maxDistSqr = distSqr;
+        }
+    }
+
+    return sqrtf(maxDistSqr);
+}
+
+ShapeHeightfield::ShapeHeightfield(const float* heights, const int numX, const int numY, const float spacing) :
+    Shape(ShapeType::SHAPE_HEIGHTFIELD)
+{
+    grid.Build(heights, numX, numY, spacing);
+
+    centerOfMass.Zero();
+    Build();
+}
+
+Mat3 ShapeHeightfield::InertiaTensor() const
+{
+    // Solid box of the bounds, only there to keep the tensor invertible
+    const Bounds& bounds = grid.GetBounds();
+    const float xx = bounds.WidthX() * bounds.WidthX();
+    const float yy = bounds.WidthY() * bounds.WidthY();
+    const float zz = bounds.WidthZ() * bounds.WidthZ();
+
+    Mat3 tensor;
+    tensor.Zero();
+
+    tensor.rows[0][0] = (yy + zz) / 12.0f;
+    tensor.rows[1][1] = (xx + zz) / 12.0f;
+    tensor.rows[2][2] = (xx + yy) / 12.0f;
+
+    return tensor;
+}
+
+Bounds ShapeHeightfield::GetBounds(const Vec3& pos, const Quat& orient) const
+{
+    const Bounds& bounds = grid.GetBounds();
+
+    Bounds tmp;
+    for (int i = 0; i < 8; ++i) {
+        const Vec3 corner(
+            (i & 1) ? bounds.maxs.x : bounds.mins.x,
+            (i & 2) ? bounds.maxs.y : bounds.mins.y,
+            (i & 4) ? bounds.maxs.z : bounds.mins.z);
+        tmp.Expand(orient.RotatePoint(corner) + pos);
+    }
+
+    return tmp;
+}
+
+Bounds ShapeHeightfield::GetBounds() const
+{
+    return grid.GetBounds();
+}
+
+Vec3 ShapeHeightfield::Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const
+{
+    // Corner of the bounds, searching millions of samples isn't worth it for a static shape
+    const Bounds& bounds = grid.GetBounds();
+    const Vec3 localDir = orient.Inverse().RotatePoint(dir);
+    const Vec3 corner(
+        (localDir.x > 0.0f) ? bounds.maxs.x : bounds.mins.x,
+        (localDir.y > 0.0f) ? bounds.maxs.y : bounds.mins.y,
+        (localDir.z > 0.0f) ? bounds.maxs.z : bounds.mins.z);
+
+    return orient.RotatePoint(corner) + pos + dir * bias;
+}
+
+float ShapeHeightfield::BoundingRadius() const
+{
+    const Bounds& bounds = grid.GetBounds();
+
+    float maxDistSqr = 0.0f;
+    for (int i = 0; i < 8; ++i) {
+        const Vec3 corner(
+            (i & 1) ? bounds.maxs.x : bounds.mins.x,
+            (i & 2) ? bounds.maxs.y : bounds.mins.y,
+            (i & 4) ? bounds.maxs.z : bounds.mins.z);
+        maxDistSqr = fmaxf(maxDistSqr, corner.GetLengthSqr());
+    }
+
+    return sqrtf(maxDistSqr);
+}
+
+ShapeCompound::ShapeCompound(const CompoundChild* childrenP, const int num) :
+    Shape(ShapeType::SHAPE_COMPOUND), children(childrenP, childrenP + num)
+{
+    assert(num > 0);
+
+    std::vector<Bounds> childBounds(num);
+    float totalMass = 0.0f;
+    centerOfMass.Zero();
+    for (int i = 0; i < num; ++i) {
+        const CompoundChild& child = children[i];
+        childBounds[i] = child.shape->GetBounds(child.position, child.orientation);
+
+        centerOfMass += (child.position + child.orientation.RotatePoint(child.shape->GetCenterOfMass())) * child.mass;
+        totalMass += child.mass;
+    }
+    centerOfMass /= totalMass;
+
+    bvh.Build(childBounds);
+    Build();
+}
+
+Mat3 ShapeCompound::InertiaTensor() const
+{
+    float totalMass = 0.0f;
+    for (int i = 0; i < children.size(); ++i) {
+        totalMass += children[i].mass;
+    }
+
+    // Every child's unit mass tensor turned into body space, moved to the compound's
+    // center of mass by the parallel axis theorem, and weighted by the child's share of the mass
+    Mat3 tensor;
+    tensor.Zero();
+    for (int i = 0; i < children.size(); ++i) {
+        const CompoundChild& child = children[i];
+
+        // The rows of the orientation matrix are the child's axes, its transpose takes child space to body space
+        const Mat3 orient = child.orientation.ToMat3();
+        Mat3 childTensor = orient.Transpose() * child.shape->GetInertiaTensor() * orient;
+
+        const Vec3 r = child.position + child.orientation.RotatePoint(child.shape->GetCenterOfMass()) - centerOfMass;
+        const float rr = r.Dot(r);
+        for (int j = 0; j < 3; ++j) {
+            for (int k = 0; k < 3; ++k) {
+                childTensor.rows[j][k] += ((j == k) ? rr : 0.0f) - r[j] * r[k];
+            }
+        }
+
+        tensor += childTensor * (child.mass / totalMass);
+    }
+
+    return tensor;
+}
+
+Bounds ShapeCompound::GetBounds(const Vec3& pos, const Quat& orient) const
+{
+    // The children's own bounds are much tighter than the rotated root of the BVH
+    Bounds tmp;
+    for (int i = 0; i < children.size(); ++i) {
+        const CompoundChild& child = children[i];
+        tmp.Expand(child.shape->GetBounds(pos + orient.RotatePoint(child.position), orient * child.orientation));
+    }
+
+    return tmp;
+}
+
+Bounds ShapeCompound::GetBounds() const
+{
+    return bvh.GetBounds();
+}
+
+Vec3 ShapeCompound::Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const
+{
+    // Furthest of the children's own support points
+    Vec3 maxPt;
+    float maxDist = 0.0f;
+    for (int i = 0; i < children.size(); ++i) {
+        const CompoundChild& child = children[i];
+        const Vec3 pt = child.shape->Support(dir, pos + orient.RotatePoint(child.position), orient * child.orientation, bias);
+
+        const float dist = dir.Dot(pt);
+        if (i == 0 || dist > maxDist) {
+            maxDist = dist;
+            maxPt = pt;
+        }
+    }
+
+    return maxPt;
+}
+
+float ShapeCompound::BoundingRadius() const
+{
+    float maxDist = 0.0f;
+    for (int i = 0; i < children.size(); ++i) {
+        const CompoundChild& child = children[i];
+        const Vec3 childCenter = child.position + child.orientation.RotatePoint(child.shape->GetCenterOfMass());
+
+        maxDist = fmaxf(maxDist, (childCenter - centerOfMass).GetMagnitude() + child.shape->GetBoundingRadius());
+    }
+
+    return maxDist;
+}
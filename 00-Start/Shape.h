@@ -2,6 +2,10 @@
 #include "code/Math/Matrix.h"
 #include "code/Math/Bounds.h"
 #include "code/Math/Quat.h"
+#include "ConvexHull.h"
+#include "MeshBVH.h"
+#include "Heightfield.h"
+#include "CompoundBVH.h"
 
 
 class Shape {
@@ -9,34 +13,234 @@ public:
 	enum class ShapeType
 	{
 		SHAPE_SPHERE,
+		SHAPE_BOX,
+		SHAPE_CONVEX,
+		SHAPE_CAPSULE,
+		SHAPE_MESH,
+		SHAPE_HEIGHTFIELD,
+		SHAPE_COMPOUND,
+
+		SHAPE_NUM,
 	};
 
-	virtual ShapeType GetType() const = 0;
-	virtual Vec3 GetCenterOfMass() const { return centerOfMass; }
+	Shape(ShapeType typeP) : type(typeP) {}
+	virtual ~Shape() {}
+
+	// The type tag is plain data, so hot loops can switch on it and
+	// static_cast to the (final) concrete shape without any virtual call
+	ShapeType GetType() const { return type; }
+	Vec3 GetCenterOfMass() const { return centerOfMass; }
 	virtual Mat3 InertiaTensor() const = 0;
 
 	virtual Bounds GetBounds(const Vec3& pos, const Quat& orient) const = 0;
 	virtual Bounds GetBounds() const = 0;
 
+	// Furthest point of the shape along dir (normalized), in world space for a body at pos/orient,
+	// pushed out by bias along dir. This is all GJK and EPA need to know about a convex shape.
+	virtual Vec3 Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const = 0;
+
+	// Distance from the center of mass to the furthest point of the shape,
+	// no point moves faster than |angular velocity| times this
+	virtual float BoundingRadius() const = 0;
+
+	// Values computed once when the shape is built, shapes are immutable afterwards
+	const Mat3& GetInertiaTensor() const { return inertiaTensor; }
+	const Mat3& GetInverseInertiaTensor() const { return inverseInertiaTensor; }
+	const Bounds& GetLocalBounds() const { return localBounds; }
+	float GetBoundingRadius() const { return boundingRadius; }
+
 protected:
+	// Must be called at the end of every concrete shape's constructor
+	void Build();
+
+	const ShapeType type;
 	Vec3 centerOfMass;
+
+	Mat3 inertiaTensor;
+	Mat3 inverseInertiaTensor;
+	Bounds localBounds;
+	float boundingRadius;
 };
 
-class ShapeSphere : public Shape {
+class ShapeSphere final : public Shape {
 public:
-	ShapeSphere(float radiusP) : radius(radiusP)
+	ShapeSphere(float radiusP) : Shape(ShapeType::SHAPE_SPHERE), radius(radiusP)
 	{
 		centerOfMass.Zero();
+		Build();
 	}
 
-	ShapeType GetType() const override { return ShapeType::SHAPE_SPHERE; }
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
+	Bounds GetBounds() const override;
+
+	Vec3 Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const override;
+	float BoundingRadius() const override;
+
+
+	float radius;
+};
+
+/// <summary>
+/// Box centered on the body's origin, axis aligned in body space
+/// </summary>
+class ShapeBox final : public Shape {
+public:
+	ShapeBox(const Vec3& halfExtentsP) : Shape(ShapeType::SHAPE_BOX), halfExtents(halfExtentsP)
+	{
+		centerOfMass.Zero();
+		for (int i = 0; i < 8; ++i) {
+			points[i] = Vec3(
+				(i & 1) ? halfExtents.x : -halfExtents.x,
+				(i & 2) ? halfExtents.y : -halfExtents.y,
+				(i & 4) ? halfExtents.z : -halfExtents.z);
+		}
+		Build();
+	}
+
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
+	Bounds GetBounds() const override;
+
+	Vec3 Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const override;
+	float BoundingRadius() const override;
+
+
+	Vec3 halfExtents;
+	// Corners in body space, bit 0/1/2 of the index selects the +x/+y/+z side
+	Vec3 points[8];
+};
+
+/// <summary>
+/// Convex hull of a point cloud, in body space.
+/// The center of mass and inertia are those of the solid hull, not of its points.
+/// </summary>
+class ShapeConvex final : public Shape {
+public:
+	ShapeConvex(const Vec3* pts, const int num);
+
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
+	Bounds GetBounds() const override;
+
+	Vec3 Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const override;
+	float BoundingRadius() const override;
+
+
+	// Hull vertices, points of the cloud inside the hull are dropped
+	std::vector<Vec3> points;
+	// Hull faces, indices into points
+	std::vector<tri_t> triangles;
+};
+
+/// <summary>
+/// Segment along the body's z axis, centered on the origin, swept by a sphere
+/// </summary>
+class ShapeCapsule final : public Shape {
+public:
+	ShapeCapsule(float radiusP, float halfHeightP) : Shape(ShapeType::SHAPE_CAPSULE), radius(radiusP), halfHeight(halfHeightP)
+	{
+		centerOfMass.Zero();
+		Build();
+	}
 
 	Mat3 InertiaTensor() const override;
 
 	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
 	Bounds GetBounds() const override;
 
+	Vec3 Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const override;
+	float BoundingRadius() const override;
+
+	// Ends of the segment in world space, for a body at pos/orient
+	void GetSegment(const Vec3& pos, const Quat& orient, Vec3& p0, Vec3& p1) const;
+
 
 	float radius;
+	// Half the length of the segment, the capsule is 2 * (halfHeight + radius) long
+	float halfHeight;
 };
 
+/// <summary>
+/// Triangle soup for level geometry, in body space, with a BVH to find the triangles near a box.
+/// Only meant for static bodies: its mass properties are those of its bounds and are never used,
+/// and its support function is that of its convex hull, the narrowphase works per triangle instead.
+/// </summary>
+class ShapeMesh final : public Shape {
+public:
+	ShapeMesh(const Vec3* verts, const int numVerts, const tri_t* tris, const int numTris);
+
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
+	Bounds GetBounds() const override;
+
+	Vec3 Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const override;
+	float BoundingRadius() const override;
+
+
+	std::vector<Vec3> vertices;
+	// Indices into vertices, reordered so every BVH leaf covers a contiguous range
+	std::vector<tri_t> triangles;
+	MeshBVH bvh;
+};
+
+/// <summary>
+/// Terrain from a grid of heights, see HeightfieldGrid. Static only, like ShapeMesh:
+/// its mass properties and support function are those of its bounds,
+/// the narrowphase works on the triangles generated under each query instead.
+/// </summary>
+class ShapeHeightfield final : public Shape {
+public:
+	ShapeHeightfield(const float* heights, const int numX, const int numY, const float spacing);
+
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
+	Bounds GetBounds() const override;
+
+	Vec3 Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const override;
+	float BoundingRadius() const override;
+
+
+	HeightfieldGrid grid;
+};
+
+/// <summary>
+/// Shape of a compound's child, placed in the compound's body space
+/// </summary>
+struct CompoundChild
+{
+	const Shape* shape;
+	// Of the child's body origin, in the compound's body space
+	Vec3 position;
+	Quat orientation;
+	// Relative to the other children, only the ratios matter
+	float mass;
+};
+
+/// <summary>
+/// Rigid assembly of other shapes under a single body. The broadphase sees the bounds of the whole,
+/// the narrowphase walks a BVH over the children to test only those near the other body.
+/// The center of mass and inertia are those of the children, weighted by their masses.
+/// Child shapes are not owned, they come from the same registry as the compound.
+/// </summary>
+class ShapeCompound final : public Shape {
+public:
+	ShapeCompound(const CompoundChild* childrenP, const int num);
+
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
+	Bounds GetBounds() const override;
+
+	Vec3 Support(const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias) const override;
+	float BoundingRadius() const override;
+
+
+	std::vector<CompoundChild> children;
+	CompoundBVH bvh;
+};
@@ -0,0 +1,153 @@
+#include "ShapeBatch.h"
+
+
+/// <summary>
+/// Counting sort of the bodies by shape type, O(num)
+/// </summary>
+void ShapeBatches::Build(const Body* bodies, const int num)
+{
+	const int numTypes = (int)Shape::ShapeType::SHAPE_NUM;
+
+	int counts[(int)Shape::ShapeType::SHAPE_NUM] = {};
+	for (int i = 0; i < num; ++i) {
+		++counts[(int)bodies[i].shape->GetType()];
+	}
+
+	offsets[0] = 0;
+	for (int t = 0; t < numTypes; ++t) {
+		offsets[t + 1] = offsets[t] + counts[t];
+	}
+
+	int cursor[(int)Shape::ShapeType::SHAPE_NUM];
+	for (int t = 0; t < numTypes; ++t) {
+		cursor[t] = offsets[t];
+	}
+
+	bodyIndices.resize(num);
+	for (int i = 0; i < num; ++i) {
+		const int t = (int)bodies[i].shape->GetType();
+		bodyIndices[cursor[t]++] = i;
+	}
+}
+
+/// <summary>
+/// World space bounds of every body, written at the body's index.
+/// Each shape type runs as its own loop with direct access to the concrete shape.
+/// </summary>
+void GetBoundsBatched(const Body* bodies, const ShapeBatches& batches, Bounds* bounds)
+{
+	//v Spheres ======================================================
+	{
+		const int begin = batches.Begin(Shape::ShapeType::SHAPE_SPHERE);
+		const int end = batches.End(Shape::ShapeType::SHAPE_SPHERE);
+
+		for (int k = begin; k < end; ++k) {
+			const int i = batches.bodyIndices[k];
+			const Body& body = bodies[i];
+			const float radius = static_cast<const ShapeSphere*>(body.shape)->radius;
+
+			bounds[i].mins = Vec3(body.position.x - radius, body.position.y - radius, body.position.z - radius);
+			bounds[i].maxs = Vec3(body.position.x + radius, body.position.y + radius, body.position.z + radius);
+		}
+	}
+	//^ Spheres ======================================================
+	//v Boxes ========================================================
+	{
+		const int begin = batches.Begin(Shape::ShapeType::SHAPE_BOX);
+		const int end = batches.End(Shape::ShapeType::SHAPE_BOX);
+
+		for (int k = begin; k < end; ++k) {
+			const int i = batches.bodyIndices[k];
+			const Body& body = bodies[i];
+			const Vec3& halfExtents = static_cast<const ShapeBox*>(body.shape)->halfExtents;
+
+			// The rows of the orientation matrix are the box axes in world space,
+			// the extent along a world axis is the sum of the projected half extents
+			const Mat3 orient = body.orientation.ToMat3();
+			Vec3 extents;
+			for (int j = 0; j < 3; ++j) {
+				extents[j] =
+					fabsf(orient.rows[0][j]) * halfExtents.x +
+					fabsf(orient.rows[1][j]) * halfExtents.y +
+					fabsf(orient.rows[2][j]) * halfExtents.z;
+			}
+
+			bounds[i].mins = body.position - extents;
+			bounds[i].maxs = body.position + extents;
+		}
+	}
+	//^ Boxes ========================================================
+	//v Convex hulls =================================================
+	{
+		const int begin = batches.Begin(Shape::ShapeType::SHAPE_CONVEX);
+		const int end = batches.End(Shape::ShapeType::SHAPE_CONVEX);
+
+		// Hulls have no cheaper bound than their rotated points
+		for (int k = begin; k < end; ++k) {
+			const int i = batches.bodyIndices[k];
+			const Body& body = bodies[i];
+			bounds[i] = static_cast<const ShapeConvex*>(body.shape)->GetBounds(body.position, body.orientation);
+		}
+	}
+	//^ Convex hulls =================================================
+	//v Capsules =====================================================
+	{
+		const int begin = batches.Begin(Shape::ShapeType::SHAPE_CAPSULE);
+		const int end = batches.End(Shape::ShapeType::SHAPE_CAPSULE);
+
+		for (int k = begin; k < end; ++k) {
+			const int i = batches.bodyIndices[k];
+			const Body& body = bodies[i];
+			const ShapeCapsule* capsule = static_cast<const ShapeCapsule*>(body.shape);
+
+			// The segment runs along the third row of the orientation matrix, grown by the radius
+			const Mat3 orient = body.orientation.ToMat3();
+			Vec3 extents;
+			for (int j = 0; j < 3; ++j) {
+				extents[j] = fabsf(orient.rows[2][j]) * capsule->halfHeight + capsule->radius;
+			}
+
+			bounds[i].mins = body.position - extents;
+			bounds[i].maxs = body.position + extents;
+		}
+	}
+	//^ Capsules =====================================================
+	//v Meshes =======================================================
+	{
+		const int begin = batches.Begin(Shape::ShapeType::SHAPE_MESH);
+		const int end = batches.End(Shape::ShapeType::SHAPE_MESH);
+
+		// The rotated corners of the BVH root
+		for (int k = begin; k < end; ++k) {
+			const int i = batches.bodyIndices[k];
+			const Body& body = bodies[i];
+			bounds[i] = static_cast<const ShapeMesh*>(body.shape)->GetBounds(body.position, body.orientation);
+		}
+	}
+	//^ Meshes =======================================================
+	//v Heightfields =================================================
+	{
+		const int begin = batches.Begin(Shape::ShapeType::SHAPE_HEIGHTFIELD);
+		const int end = batches.End(Shape::ShapeType::SHAPE_HEIGHTFIELD);
+
+		for (int k = begin; k < end; ++k) {
+			const int i = batches.bodyIndices[k];
+			const Body& body = bodies[i];
+			bounds[i] = static_cast<const ShapeHeightfield*>(body.shape)->GetBounds(body.position, body.orientation);
+		}
+	}
+	//^ Heightfields =================================================
+	//v Compounds ====================================================
+	{
+		const int begin = batches.Begin(Shape::ShapeType::SHAPE_COMPOUND);
+		const int end = batches.End(Shape::ShapeType::SHAPE_COMPOUND);
+
+		// One box around all the children, the narrowphase sorts out which of them are involved
+		for (int k = begin; k < end; ++k) {
+			const int i = batches.bodyIndices[k];
+			const Body& body = bodies[i];
+			bounds[i] = static_cast<const ShapeCompound*>(body.shape)->GetBounds(body.position, body.orientation);
+		}
+	}
+	//^ Compounds ====================================================
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include "Body.h"
+#include "Shape.h"
+
+
+/// <summary>
+/// Body indices grouped by shape type.
+/// Batch t covers bodyIndices[offsets[t]] up to bodyIndices[offsets[t + 1]],
+/// in increasing body order, so per-type loops visit bodies in a stable order.
+/// </summary>
+struct ShapeBatches
+{
+	std::vector<int> bodyIndices;
+	int offsets[(int)Shape::ShapeType::SHAPE_NUM + 1];
+
+	void Build(const Body* bodies, const int num);
+
+	int Begin(const Shape::ShapeType type) const { return offsets[(int)type]; }
+	int End(const Shape::ShapeType type) const { return offsets[(int)type + 1]; }
+};
+
+void GetBoundsBatched(const Body* bodies, const ShapeBatches& batches, Bounds* bounds);
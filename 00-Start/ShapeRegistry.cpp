@@ -0,0 +1,217 @@
+#include "ShapeRegistry.h"
+#include <string.h>
+#include <algorithm>
+
+
+const ShapeSphere* ShapeRegistry::GetSphere(const float radius)
+{
+	const uint64_t key = HashShape(Shape::ShapeType::SHAPE_SPHERE, &radius, 1);
+
+	auto range = shapes.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Shape* shape = it->second;
+		if (shape->GetType() != Shape::ShapeType::SHAPE_SPHERE) continue;
+
+		const ShapeSphere* sphere = static_cast<const ShapeSphere*>(shape);
+		if (sphere->radius == radius) {
+			return sphere;
+		}
+	}
+
+	const ShapeSphere* sphere = spheres.Allocate(radius);
+	shapes.insert(std::make_pair(key, sphere));
+
+	return sphere;
+}
+
+const ShapeBox* ShapeRegistry::GetBox(const Vec3& halfExtents)
+{
+	const float params[3] = { halfExtents.x, halfExtents.y, halfExtents.z };
+	const uint64_t key = HashShape(Shape::ShapeType::SHAPE_BOX, params, 3);
+
+	auto range = shapes.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Shape* shape = it->second;
+		if (shape->GetType() != Shape::ShapeType::SHAPE_BOX) continue;
+
+		const ShapeBox* box = static_cast<const ShapeBox*>(shape);
+		if (box->halfExtents.x == halfExtents.x && box->halfExtents.y == halfExtents.y && box->halfExtents.z == halfExtents.z) {
+			return box;
+		}
+	}
+
+	const ShapeBox* box = boxes.Allocate(halfExtents);
+	shapes.insert(std::make_pair(key, box));
+
+	return box;
+}
+
+const ShapeCapsule* ShapeRegistry::GetCapsule(const float radius, const float halfHeight)
+{
+	const float params[2] = { radius, halfHeight };
+	const uint64_t key = HashShape(Shape::ShapeType::SHAPE_CAPSULE, params, 2);
+
+	auto range = shapes.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Shape* shape = it->second;
+		if (shape->GetType() != Shape::ShapeType::SHAPE_CAPSULE) continue;
+
+		const ShapeCapsule* capsule = static_cast<const ShapeCapsule*>(shape);
+		if (capsule->radius == radius && capsule->halfHeight == halfHeight) {
+			return capsule;
+		}
+	}
+
+	const ShapeCapsule* capsule = capsules.Allocate(radius, halfHeight);
+	shapes.insert(std::make_pair(key, capsule));
+
+	return capsule;
+}
+
+const ShapeConvex* ShapeRegistry::GetConvex(const Vec3* pts, const int num)
+{
+	const uint64_t key = HashShape(Shape::ShapeType::SHAPE_CONVEX, pts[0].ToPtr(), num * 3);
+
+	auto range = shapes.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Shape* shape = it->second;
+		if (shape->GetType() != Shape::ShapeType::SHAPE_CONVEX) continue;
+
+		const std::vector<Vec3>& source = convexSources[shape];
+		if (source.size() == num && std::equal(source.begin(), source.end(), pts)) {
+			return static_cast<const ShapeConvex*>(shape);
+		}
+	}
+
+	const ShapeConvex* convex = convexes.Allocate(pts, num);
+	shapes.insert(std::make_pair(key, convex));
+	convexSources[convex].assign(pts, pts + num);
+
+	return convex;
+}
+
+const ShapeMesh* ShapeRegistry::GetMesh(const Vec3* verts, const int numVerts, const tri_t* tris, const int numTris)
+{
+	// Meshes differing only by their triangles collide, and are told apart below
+	const uint64_t key = HashShape(Shape::ShapeType::SHAPE_MESH, verts[0].ToPtr(), numVerts * 3);
+
+	auto range = shapes.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Shape* shape = it->second;
+		if (shape->GetType() != Shape::ShapeType::SHAPE_MESH) continue;
+
+		const ShapeMesh* mesh = static_cast<const ShapeMesh*>(shape);
+		if (mesh->vertices.size() != numVerts || !std::equal(mesh->vertices.begin(), mesh->vertices.end(), verts)) continue;
+
+		const std::vector<tri_t>& source = meshSources[shape];
+		const bool isSame = (source.size() == numTris) && std::equal(source.begin(), source.end(), tris, [](const tri_t& lhs, const tri_t& rhs) {
+			return lhs.a == rhs.a && lhs.b == rhs.b && lhs.c == rhs.c;
+		});
+		if (isSame) {
+			return mesh;
+		}
+	}
+
+	const ShapeMesh* mesh = meshes.Allocate(verts, numVerts, tris, numTris);
+	shapes.insert(std::make_pair(key, mesh));
+	meshSources[mesh].assign(tris, tris + numTris);
+
+	return mesh;
+}
+
+const ShapeHeightfield* ShapeRegistry::GetHeightfield(const float* heights, const int numX, const int numY, const float spacing)
+{
+	// The grid only keeps quantized samples, candidates compare by quantizing the heights again
+	const uint64_t key = HashShape(Shape::ShapeType::SHAPE_HEIGHTFIELD, heights, numX * numY);
+
+	auto range = shapes.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Shape* shape = it->second;
+		if (shape->GetType() != Shape::ShapeType::SHAPE_HEIGHTFIELD) continue;
+
+		const ShapeHeightfield* heightfield = static_cast<const ShapeHeightfield*>(shape);
+		if (heightfield->grid.Matches(heights, numX, numY, spacing)) {
+			return heightfield;
+		}
+	}
+
+	const ShapeHeightfield* heightfield = heightfields.Allocate(heights, numX, numY, spacing);
+	shapes.insert(std::make_pair(key, heightfield));
+
+	return heightfield;
+}
+
+const ShapeCompound* ShapeRegistry::GetCompound(const CompoundChild* children, const int num)
+{
+	// Child shapes are interned, so their handles tell them apart and only the placements are hashed
+	std::vector<float> params;
+	params.reserve(num * 8);
+	for (int i = 0; i < num; ++i) {
+		const CompoundChild& child = children[i];
+		const float childParams[8] = {
+			child.position.x, child.position.y, child.position.z,
+			child.orientation.x, child.orientation.y, child.orientation.z, child.orientation.w,
+			child.mass,
+		};
+		params.insert(params.end(), childParams, childParams + 8);
+	}
+	const uint64_t key = HashShape(Shape::ShapeType::SHAPE_COMPOUND, params.data(), (int)params.size());
+
+	auto range = shapes.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Shape* shape = it->second;
+		if (shape->GetType() != Shape::ShapeType::SHAPE_COMPOUND) continue;
+
+		const ShapeCompound* compound = static_cast<const ShapeCompound*>(shape);
+		const bool isSame = (compound->children.size() == num) && std::equal(compound->children.begin(), compound->children.end(), children, [](const CompoundChild& lhs, const CompoundChild& rhs) {
+			return lhs.shape == rhs.shape && lhs.mass == rhs.mass &&
+				lhs.position.x == rhs.position.x && lhs.position.y == rhs.position.y && lhs.position.z == rhs.position.z &&
+				lhs.orientation.x == rhs.orientation.x && lhs.orientation.y == rhs.orientation.y &&
+				lhs.orientation.z == rhs.orientation.z && lhs.orientation.w == rhs.orientation.w;
+		});
+		if (isSame) {
+			return compound;
+		}
+	}
+
+	const ShapeCompound* compound = compounds.Allocate(children, num);
+	shapes.insert(std::make_pair(key, compound));
+
+	return compound;
+}
+
+void ShapeRegistry::Clear()
+{
+	shapes.clear();
+	convexSources.clear();
+	meshSources.clear();
+	spheres.Clear();
+	boxes.Clear();
+	convexes.Clear();
+	capsules.Clear();
+	meshes.Clear();
+	heightfields.Clear();
+	compounds.Clear();
+	++generation;
+}
+
+/// <summary>
+/// FNV-1a over the shape type and the bit patterns of its parameters
+/// </summary>
+uint64_t ShapeRegistry::HashShape(const Shape::ShapeType type, const float* params, const int numParams)
+{
+	const uint64_t prime = 1099511628211ULL;
+	uint64_t hash = 14695981039346656037ULL;
+
+	hash = (hash ^ (uint64_t)type) * prime;
+	for (int i = 0; i < numParams; ++i) {
+		// +0 and -0 describe the same shape
+		const float value = (params[i] == 0.0f) ? 0.0f : params[i];
+
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		hash = (hash ^ bits) * prime;
+	}
+
+	return hash;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <stdlib.h>
+#include <stdint.h>
+#include <new>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+#include "Shape.h"
+
+
+/// <summary>
+/// Block allocator for one concrete shape type.
+/// Shapes never move once allocated, so handles stay valid until Clear.
+/// </summary>
+template<typename T>
+class ShapePool
+{
+public:
+	ShapePool() : numInLastBlock(BLOCK_SIZE) {}
+	~ShapePool() { Clear(); }
+
+	template<typename... Args>
+	T* Allocate(Args&&... args)
+	{
+		if (numInLastBlock == BLOCK_SIZE) {
+			blocks.push_back((T*)malloc(sizeof(T) * BLOCK_SIZE));
+			numInLastBlock = 0;
+		}
+
+		T* shape = new (blocks.back() + numInLastBlock) T(std::forward<Args>(args)...);
+		++numInLastBlock;
+		return shape;
+	}
+
+	void Clear()
+	{
+		for (int i = 0; i < blocks.size(); ++i) {
+			const int num = (i == blocks.size() - 1) ? numInLastBlock : BLOCK_SIZE;
+			for (int j = 0; j < num; ++j) {
+				blocks[i][j].~T();
+			}
+			free(blocks[i]);
+		}
+		blocks.clear();
+		numInLastBlock = BLOCK_SIZE;
+	}
+
+private:
+	ShapePool(const ShapePool&) = delete;
+	ShapePool& operator=(const ShapePool&) = delete;
+
+	enum { BLOCK_SIZE = 256 };
+
+	std::vector<T*> blocks;
+	int numInLastBlock;
+};
+
+/// <summary>
+/// Owns every shape of a scene.
+/// Identical shapes are interned, so bodies asking for the same shape
+/// share one immutable instance (and its precomputed inertia and bounds).
+/// Handles stay valid until Clear or destruction of the registry.
+/// </summary>
+class ShapeRegistry
+{
+public:
+	ShapeRegistry() : generation(0) {}
+	~ShapeRegistry() { Clear(); }
+
+	const ShapeSphere* GetSphere(const float radius);
+	const ShapeBox* GetBox(const Vec3& halfExtents);
+	const ShapeCapsule* GetCapsule(const float radius, const float halfHeight);
+	// Hull of the points, interned on the points as given
+	const ShapeConvex* GetConvex(const Vec3* pts, const int num);
+	// Static triangle mesh, interned on its vertices and triangles as given
+	const ShapeMesh* GetMesh(const Vec3* verts, const int numVerts, const tri_t* tris, const int numTris);
+	// Heightfield of numX x numY samples, heights[j * numX + i] at column i and row j
+	const ShapeHeightfield* GetHeightfield(const float* heights, const int numX, const int numY, const float spacing);
+	// Assembly of shapes of this registry, interned on its children as given
+	const ShapeCompound* GetCompound(const CompoundChild* children, const int num);
+
+	int NumShapes() const { return (int)shapes.size(); }
+	void Clear();
+	// Changes on every Clear, handles taken under another generation are gone
+	int Generation() const { return generation; }
+
+private:
+	ShapeRegistry(const ShapeRegistry&) = delete;
+	ShapeRegistry& operator=(const ShapeRegistry&) = delete;
+
+	static uint64_t HashShape(const Shape::ShapeType type, const float* params, const int numParams);
+
+	// Shapes are keyed by a hash of their type and parameters,
+	// colliding entries are told apart by comparing the parameters
+	std::unordered_multimap<uint64_t, const Shape*> shapes;
+
+	ShapePool<ShapeSphere> spheres;
+	ShapePool<ShapeBox> boxes;
+	ShapePool<ShapeConvex> convexes;
+	ShapePool<ShapeCapsule> capsules;
+	ShapePool<ShapeMesh> meshes;
+	ShapePool<ShapeHeightfield> heightfields;
+	ShapePool<ShapeCompound> compounds;
+
+	// Points each hull was built from, the hull itself drops the inner ones
+	std::unordered_map<const Shape*, std::vector<Vec3>> convexSources;
+	// Triangles each mesh was built from, the mesh reorders them for its BVH
+	std::unordered_map<const Shape*, std::vector<tri_t>> meshSources;
+
+	int generation;
+};
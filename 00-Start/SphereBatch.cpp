@@ -0,0 +1,248 @@
+#include "SphereBatch.h"
+#include "Intersections.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#define SPHERE_BATCH_AVX2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static SphereBatchMode g_sphereBatchMode = SphereBatchMode::SPHERE_BATCH_AUTO;
+
+
+void SpherePairBatch::Resize(const int numPairs)
+{
+	num = numPairs;
+	stride = (numPairs + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+
+	// Zero everything so the padding lanes hold harmless values
+	data.assign((size_t)stride * NUM_STREAMS, 0.0f);
+	hit.assign(stride, 0);
+}
+
+void SetSphereBatchMode(const SphereBatchMode mode)
+{
+	g_sphereBatchMode = mode;
+}
+
+SphereBatchMode GetSphereBatchMode()
+{
+	return g_sphereBatchMode;
+}
+
+bool SphereBatchHasAVX2()
+{
+#if defined(SPHERE_BATCH_AVX2)
+	static int hasAVX2 = -1;
+	if (hasAVX2 >= 0) return hasAVX2 != 0;
+
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+
+	bool supported = false;
+	if (maxLeaf >= 7) {
+		__cpuid(info, 1);
+		const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+		__cpuidex(info, 7, 0);
+		supported = osSavesYmm && (info[1] & (1 << 5)) != 0;
+	}
+	hasAVX2 = supported ? 1 : 0;
+#else
+	hasAVX2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+
+	return hasAVX2 != 0;
+#else
+	return false;
+#endif
+}
+
+//v Reference ==================================================================
+
+static void SphereSphereDynamicReference(SpherePairBatch& batch, const float dt)
+{
+	const float* posAX = batch.Get(SpherePairBatch::POS_A_X);
+	const float* posAY = batch.Get(SpherePairBatch::POS_A_Y);
+	const float* posAZ = batch.Get(SpherePairBatch::POS_A_Z);
+	const float* posBX = batch.Get(SpherePairBatch::POS_B_X);
+	const float* posBY = batch.Get(SpherePairBatch::POS_B_Y);
+	const float* posBZ = batch.Get(SpherePairBatch::POS_B_Z);
+	const float* velAX = batch.Get(SpherePairBatch::VEL_A_X);
+	const float* velAY = batch.Get(SpherePairBatch::VEL_A_Y);
+	const float* velAZ = batch.Get(SpherePairBatch::VEL_A_Z);
+	const float* velBX = batch.Get(SpherePairBatch::VEL_B_X);
+	const float* velBY = batch.Get(SpherePairBatch::VEL_B_Y);
+	const float* velBZ = batch.Get(SpherePairBatch::VEL_B_Z);
+	const float* radiusA = batch.Get(SpherePairBatch::RADIUS_A);
+	const float* radiusB = batch.Get(SpherePairBatch::RADIUS_B);
+
+	float* toi = batch.Get(SpherePairBatch::TIME_OF_IMPACT);
+	float* ptAX = batch.Get(SpherePairBatch::PT_ON_A_X);
+	float* ptAY = batch.Get(SpherePairBatch::PT_ON_A_Y);
+	float* ptAZ = batch.Get(SpherePairBatch::PT_ON_A_Z);
+	float* ptBX = batch.Get(SpherePairBatch::PT_ON_B_X);
+	float* ptBY = batch.Get(SpherePairBatch::PT_ON_B_Y);
+	float* ptBZ = batch.Get(SpherePairBatch::PT_ON_B_Z);
+
+	for (int i = 0; i < batch.num; ++i)
+	{
+		Vec3 ptOnA;
+		Vec3 ptOnB;
+		float timeOfImpact = 0.0f;
+
+		const bool isHit = Intersections::SphereSphereDynamic(radiusA[i], radiusB[i],
+			Vec3(posAX[i], posAY[i], posAZ[i]), Vec3(posBX[i], posBY[i], posBZ[i]),
+			Vec3(velAX[i], velAY[i], velAZ[i]), Vec3(velBX[i], velBY[i], velBZ[i]),
+			dt, ptOnA, ptOnB, timeOfImpact);
+
+		batch.hit[i] = isHit ? 1 : 0;
+		if (!isHit) continue;
+
+		toi[i] = timeOfImpact;
+		ptAX[i] = ptOnA.x;
+		ptAY[i] = ptOnA.y;
+		ptAZ[i] = ptOnA.z;
+		ptBX[i] = ptOnB.x;
+		ptBY[i] = ptOnB.y;
+		ptBZ[i] = ptOnB.z;
+	}
+}
+
+//^ Reference ==================================================================
+//v AVX2 =======================================================================
+
+#if defined(SPHERE_BATCH_AVX2)
+
+/// <summary>
+/// ((x * x) + (y * y)) + (z * z), same evaluation order as Vec3::Dot
+/// </summary>
+TARGET_AVX2 static inline __m256 Dot8(const __m256 ax, const __m256 ay, const __m256 az, const __m256 bx, const __m256 by, const __m256 bz)
+{
+	return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+}
+
+/// <summary>
+/// Eight lanes of SphereSphereDynamic.
+/// Both the short ray and the ray cast branches are evaluated, the early outs become masks.
+/// </summary>
+TARGET_AVX2 static void SphereSphereDynamicAVX2(SpherePairBatch& batch, const float dt)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 dt8 = _mm256_set1_ps(dt);
+	const __m256 shortRaySqr = _mm256_set1_ps(0.001f * 0.001f);
+	const __m256 shortRaySlop = _mm256_set1_ps(0.001f);
+
+	for (int i = 0; i < batch.stride; i += SpherePairBatch::SIMD_WIDTH)
+	{
+		const __m256 posAX = _mm256_loadu_ps(batch.Get(SpherePairBatch::POS_A_X) + i);
+		const __m256 posAY = _mm256_loadu_ps(batch.Get(SpherePairBatch::POS_A_Y) + i);
+		const __m256 posAZ = _mm256_loadu_ps(batch.Get(SpherePairBatch::POS_A_Z) + i);
+		const __m256 posBX = _mm256_loadu_ps(batch.Get(SpherePairBatch::POS_B_X) + i);
+		const __m256 posBY = _mm256_loadu_ps(batch.Get(SpherePairBatch::POS_B_Y) + i);
+		const __m256 posBZ = _mm256_loadu_ps(batch.Get(SpherePairBatch::POS_B_Z) + i);
+		const __m256 velAX = _mm256_loadu_ps(batch.Get(SpherePairBatch::VEL_A_X) + i);
+		const __m256 velAY = _mm256_loadu_ps(batch.Get(SpherePairBatch::VEL_A_Y) + i);
+		const __m256 velAZ = _mm256_loadu_ps(batch.Get(SpherePairBatch::VEL_A_Z) + i);
+		const __m256 velBX = _mm256_loadu_ps(batch.Get(SpherePairBatch::VEL_B_X) + i);
+		const __m256 velBY = _mm256_loadu_ps(batch.Get(SpherePairBatch::VEL_B_Y) + i);
+		const __m256 velBZ = _mm256_loadu_ps(batch.Get(SpherePairBatch::VEL_B_Z) + i);
+		const __m256 radiusA = _mm256_loadu_ps(batch.Get(SpherePairBatch::RADIUS_A) + i);
+		const __m256 radiusB = _mm256_loadu_ps(batch.Get(SpherePairBatch::RADIUS_B) + i);
+
+		// rayDir = (posA + (velA - velB) * dt) - posA
+		const __m256 rayDirX = _mm256_sub_ps(_mm256_add_ps(posAX, _mm256_mul_ps(_mm256_sub_ps(velAX, velBX), dt8)), posAX);
+		const __m256 rayDirY = _mm256_sub_ps(_mm256_add_ps(posAY, _mm256_mul_ps(_mm256_sub_ps(velAY, velBY), dt8)), posAY);
+		const __m256 rayDirZ = _mm256_sub_ps(_mm256_add_ps(posAZ, _mm256_mul_ps(_mm256_sub_ps(velAZ, velBZ), dt8)), posAZ);
+
+		const __m256 sX = _mm256_sub_ps(posBX, posAX);
+		const __m256 sY = _mm256_sub_ps(posBY, posAY);
+		const __m256 sZ = _mm256_sub_ps(posBZ, posAZ);
+		const __m256 radiusSum = _mm256_add_ps(radiusA, radiusB);
+
+		// Short ray: already intersecting check
+		const __m256 a = Dot8(rayDirX, rayDirY, rayDirZ, rayDirX, rayDirY, rayDirZ);
+		const __m256 isShortRay = _mm256_cmp_ps(a, shortRaySqr, _CMP_LT_OQ);
+		const __m256 abLengthSqr = Dot8(sX, sY, sZ, sX, sY, sZ);
+		const __m256 slopRadius = _mm256_add_ps(radiusSum, shortRaySlop);
+		const __m256 isApart = _mm256_cmp_ps(abLengthSqr, _mm256_mul_ps(slopRadius, slopRadius), _CMP_GT_OQ);
+
+		// Ray cast against the summed radius (RaySphere)
+		const __m256 b = Dot8(sX, sY, sZ, rayDirX, rayDirY, rayDirZ);
+		const __m256 c = _mm256_sub_ps(abLengthSqr, _mm256_mul_ps(radiusSum, radiusSum));
+		const __m256 delta = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+		const __m256 inverseA = _mm256_div_ps(one, a);
+		const __m256 hasNoRoot = _mm256_cmp_ps(delta, zero, _CMP_LT_OQ);
+		const __m256 deltaRoot = _mm256_sqrt_ps(delta);
+
+		__m256 t0 = _mm256_mul_ps(_mm256_sub_ps(b, deltaRoot), inverseA);
+		__m256 t1 = _mm256_mul_ps(_mm256_add_ps(b, deltaRoot), inverseA);
+		t0 = _mm256_blendv_ps(t0, zero, isShortRay);
+		t1 = _mm256_blendv_ps(t1, zero, isShortRay);
+		__m256 isMiss = _mm256_blendv_ps(hasNoRoot, isApart, isShortRay);
+
+		// Change from [0, 1] to [0, dt], then keep the impacts inside this frame
+		t0 = _mm256_mul_ps(t0, dt8);
+		t1 = _mm256_mul_ps(t1, dt8);
+		isMiss = _mm256_or_ps(isMiss, _mm256_cmp_ps(t1, zero, _CMP_LT_OQ));
+
+		const __m256 toi = _mm256_blendv_ps(t0, zero, _mm256_cmp_ps(t0, zero, _CMP_LT_OQ));
+		isMiss = _mm256_or_ps(isMiss, _mm256_cmp_ps(toi, dt8, _CMP_GT_OQ));
+
+		// Contact points at the time of impact
+		const __m256 newPosAX = _mm256_add_ps(posAX, _mm256_mul_ps(velAX, toi));
+		const __m256 newPosAY = _mm256_add_ps(posAY, _mm256_mul_ps(velAY, toi));
+		const __m256 newPosAZ = _mm256_add_ps(posAZ, _mm256_mul_ps(velAZ, toi));
+		const __m256 newPosBX = _mm256_add_ps(posBX, _mm256_mul_ps(velBX, toi));
+		const __m256 newPosBY = _mm256_add_ps(posBY, _mm256_mul_ps(velBY, toi));
+		const __m256 newPosBZ = _mm256_add_ps(posBZ, _mm256_mul_ps(velBZ, toi));
+
+		__m256 abX = _mm256_sub_ps(newPosBX, newPosAX);
+		__m256 abY = _mm256_sub_ps(newPosBY, newPosAY);
+		__m256 abZ = _mm256_sub_ps(newPosBZ, newPosAZ);
+
+		// Vec3::Normalize leaves the vector alone when 1 / magnitude isn't finite
+		const __m256 invMag = _mm256_div_ps(one, _mm256_sqrt_ps(Dot8(abX, abY, abZ, abX, abY, abZ)));
+		const __m256 zeroTimesInvMag = _mm256_mul_ps(zero, invMag);
+		const __m256 isFinite = _mm256_cmp_ps(zeroTimesInvMag, zeroTimesInvMag, _CMP_EQ_OQ);
+		abX = _mm256_blendv_ps(abX, _mm256_mul_ps(abX, invMag), isFinite);
+		abY = _mm256_blendv_ps(abY, _mm256_mul_ps(abY, invMag), isFinite);
+		abZ = _mm256_blendv_ps(abZ, _mm256_mul_ps(abZ, invMag), isFinite);
+
+		_mm256_storeu_ps(batch.Get(SpherePairBatch::TIME_OF_IMPACT) + i, toi);
+		_mm256_storeu_ps(batch.Get(SpherePairBatch::PT_ON_A_X) + i, _mm256_add_ps(newPosAX, _mm256_mul_ps(abX, radiusA)));
+		_mm256_storeu_ps(batch.Get(SpherePairBatch::PT_ON_A_Y) + i, _mm256_add_ps(newPosAY, _mm256_mul_ps(abY, radiusA)));
+		_mm256_storeu_ps(batch.Get(SpherePairBatch::PT_ON_A_Z) + i, _mm256_add_ps(newPosAZ, _mm256_mul_ps(abZ, radiusA)));
+		_mm256_storeu_ps(batch.Get(SpherePairBatch::PT_ON_B_X) + i, _mm256_sub_ps(newPosBX, _mm256_mul_ps(abX, radiusB)));
+		_mm256_storeu_ps(batch.Get(SpherePairBatch::PT_ON_B_Y) + i, _mm256_sub_ps(newPosBY, _mm256_mul_ps(abY, radiusB)));
+		_mm256_storeu_ps(batch.Get(SpherePairBatch::PT_ON_B_Z) + i, _mm256_sub_ps(newPosBZ, _mm256_mul_ps(abZ, radiusB)));
+
+		// All ones for a miss, turn it into 0 / 1
+		const __m256i hit = _mm256_add_epi32(_mm256_castps_si256(isMiss), _mm256_set1_epi32(1));
+		_mm256_storeu_si256((__m256i*)(batch.hit.data() + i), hit);
+	}
+}
+
+#endif
+
+//^ AVX2 =======================================================================
+
+void SphereSphereDynamicBatch(SpherePairBatch& batch, const float dt, const SphereBatchMode mode)
+{
+#if defined(SPHERE_BATCH_AVX2)
+	if (mode == SphereBatchMode::SPHERE_BATCH_AUTO && SphereBatchHasAVX2()) {
+		SphereSphereDynamicAVX2(batch, dt);
+		return;
+	}
+#endif
+
+	SphereSphereDynamicReference(batch, dt);
+}
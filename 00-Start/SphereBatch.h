@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+
+
+/// <summary>
+/// Sphere pairs stored as a structure of arrays, so the continuous
+/// sphere-sphere test can run over several pairs per instruction.
+/// Every stream holds stride floats, stride being num rounded up to SIMD_WIDTH,
+/// the padding lanes are zeroed and their results must be ignored.
+/// </summary>
+struct SpherePairBatch
+{
+	enum Stream
+	{
+		// Inputs
+		POS_A_X, POS_A_Y, POS_A_Z,
+		POS_B_X, POS_B_Y, POS_B_Z,
+		VEL_A_X, VEL_A_Y, VEL_A_Z,
+		VEL_B_X, VEL_B_Y, VEL_B_Z,
+		RADIUS_A,
+		RADIUS_B,
+
+		// Outputs, only meaningful where hit is set
+		TIME_OF_IMPACT,
+		PT_ON_A_X, PT_ON_A_Y, PT_ON_A_Z,
+		PT_ON_B_X, PT_ON_B_Y, PT_ON_B_Z,
+
+		NUM_STREAMS
+	};
+
+	static const int SIMD_WIDTH = 8;
+
+	int num = 0;
+	int stride = 0;
+	std::vector<float> data;
+	std::vector<int> hit;
+
+	void Resize(const int numPairs);
+
+	float* Get(const Stream stream) { return data.data() + stream * stride; }
+	const float* Get(const Stream stream) const { return data.data() + stream * stride; }
+};
+
+enum class SphereBatchMode
+{
+	// AVX2 when the CPU supports it, reference otherwise
+	SPHERE_BATCH_AUTO,
+	// One pair at a time through Intersections::SphereSphereDynamic
+	SPHERE_BATCH_REFERENCE
+};
+
+/// <summary>
+/// Run Intersections::SphereSphereDynamic over every pair of the batch.
+/// The AVX2 path evaluates every branch of the scalar test and selects per lane,
+/// with the same operations in the same order, so it gives the reference results bit for bit
+/// (as long as the compiler isn't allowed to contract multiplies and adds into FMAs).
+/// </summary>
+void SphereSphereDynamicBatch(SpherePairBatch& batch, const float dt, const SphereBatchMode mode);
+
+bool SphereBatchHasAVX2();
+
+// Mode used by the sphere-sphere narrowphase kernel
+void SetSphereBatchMode(const SphereBatchMode mode);
+SphereBatchMode GetSphereBatchMode();
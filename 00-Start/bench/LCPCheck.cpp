@@ -0,0 +1,95 @@
+//
+//	LCPCheck.cpp
+//
+#include "Vector.h"
+#include "Matrix.h"
+#include "LCP.h"
+#include <stdio.h>
+
+/*
+====================================================
+Problem_t
+A small problem whose solution is known by hand
+====================================================
+*/
+struct Problem_t {
+	const char * name;
+	float A[ 2 ][ 2 ];
+	float b[ 2 ];
+	float lo[ 2 ];
+	float hi[ 2 ];
+	bool hasBounds;
+	float x[ 2 ];
+};
+
+/*
+====================================================
+main
+====================================================
+*/
+int main( int argc, char * argv[] ) {
+	const float inf = 1e30f;
+	const Problem_t problems[] = {
+		// Unbounded, x = A^-1 b
+		{ "unbounded", { { 4, 1 }, { 1, 3 } }, { 1, 2 }, { 0, 0 }, { 0, 0 }, false, { 1.0f / 11.0f, 7.0f / 11.0f } },
+		// The second row wants to go below zero, it stays there and the first row solves alone
+		{ "lower bound", { { 2, 1 }, { 1, 2 } }, { 1, -1 }, { 0, 0 }, { inf, inf }, true, { 0.5f, 0.0f } },
+		// The first row is held at its upper bound, the second solves against it
+		{ "upper bound", { { 4, 1 }, { 1, 3 } }, { 4, 0 }, { -inf, -inf }, { 0.5f, inf }, true, { 0.5f, -1.0f / 6.0f } },
+	};
+	const int numProblems = sizeof( problems ) / sizeof( problems[ 0 ] );
+
+	int numFailed = 0;
+	for ( int p = 0; p < numProblems; p++ ) {
+		const Problem_t & problem = problems[ p ];
+
+		MatN A( 2 );
+		VecN b( 2 );
+		VecN lo( 2 );
+		VecN hi( 2 );
+		for ( int i = 0; i < 2; i++ ) {
+			A.rows[ i ][ 0 ] = problem.A[ i ][ 0 ];
+			A.rows[ i ][ 1 ] = problem.A[ i ][ 1 ];
+			b[ i ] = problem.b[ i ];
+			lo[ i ] = problem.lo[ i ];
+			hi[ i ] = problem.hi[ i ];
+		}
+
+		LCPParms_t parms;
+		parms.maxIterations = 100;
+		parms.relaxation = 1.2f;
+		parms.residualTolerance = 1e-6f;
+		if ( problem.hasBounds ) {
+			parms.lo = &lo;
+			parms.hi = &hi;
+		}
+
+		LCPResult_t result;
+		const VecN x = LCP_ProjectedGaussSeidel( A, b, parms, &result );
+
+		const bool isSolved = fabsf( x[ 0 ] - problem.x[ 0 ] ) < 1e-4f && fabsf( x[ 1 ] - problem.x[ 1 ] ) < 1e-4f;
+		const bool isConverged = result.residual < 1e-4f && result.numIterations < parms.maxIterations;
+		printf( "%-12s x = ( %f, %f ) residual %g after %i iterations %s\n", problem.name, x[ 0 ], x[ 1 ], result.residual, result.numIterations, ( isSolved && isConverged ) ? "ok" : "FAILED" );
+		if ( !isSolved || !isConverged ) {
+			numFailed++;
+		}
+	}
+
+	// The plain solver runs N sweeps, enough to get near on a diagonally dominant system
+	MatN A( 2 );
+	VecN b( 2 );
+	A.rows[ 0 ][ 0 ] = 4;
+	A.rows[ 0 ][ 1 ] = 1;
+	A.rows[ 1 ][ 0 ] = 1;
+	A.rows[ 1 ][ 1 ] = 3;
+	b[ 0 ] = 1;
+	b[ 1 ] = 2;
+	const VecN x = LCP_GaussSeidel( A, b );
+	const bool isNear = fabsf( x[ 0 ] - 1.0f / 11.0f ) < 0.05f && fabsf( x[ 1 ] - 7.0f / 11.0f ) < 0.05f;
+	printf( "%-12s x = ( %f, %f ) %s\n", "plain", x[ 0 ], x[ 1 ], isNear ? "ok" : "FAILED" );
+	if ( !isNear ) {
+		numFailed++;
+	}
+
+	return ( 0 == numFailed ) ? 0 : 1;
+}
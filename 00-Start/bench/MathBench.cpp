@@ -0,0 +1,140 @@
+//
+//	MathBench.cpp
+//
+#include "Vector.h"
+#include "Matrix.h"
+#include "MatrixKernels.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+====================================================
+FillRandom
+====================================================
+*/
+static void FillRandom( MatMN & mat ) {
+	for ( int m = 0; m < mat.M; m++ ) {
+		for ( int n = 0; n < mat.N; n++ ) {
+			mat.rows[ m ][ n ] = (float)rand() / (float)RAND_MAX - 0.5f;
+		}
+	}
+}
+
+/*
+====================================================
+MultiplyReference
+The transpose and dot product MatMN::operator * used before the kernels
+====================================================
+*/
+static void MultiplyReference( const MatMN & a, const MatMN & b, MatMN & out ) {
+	const MatMN bT = b.Transpose();
+	for ( int i = 0; i < a.M; i++ ) {
+		for ( int j = 0; j < b.N; j++ ) {
+			out.rows[ i ][ j ] = a.rows[ i ].Dot( bT.rows[ j ] );
+		}
+	}
+}
+
+/*
+====================================================
+MaxDifference
+====================================================
+*/
+static float MaxDifference( const MatMN & a, const MatMN & b ) {
+	float maxDiff = 0.0f;
+	for ( int m = 0; m < a.M; m++ ) {
+		for ( int n = 0; n < a.N; n++ ) {
+			const float diff = fabsf( a.rows[ m ][ n ] - b.rows[ m ][ n ] );
+			maxDiff = ( diff > maxDiff ) ? diff : maxDiff;
+		}
+	}
+	return maxDiff;
+}
+
+/*
+====================================================
+TimeMs
+Best of the repeats, in milliseconds per call
+====================================================
+*/
+template< typename Function >
+static double TimeMs( const int numRepeats, const int numCalls, const Function & function ) {
+	double best = 1e30;
+	for ( int r = 0; r < numRepeats; r++ ) {
+		const auto start = std::chrono::high_resolution_clock::now();
+		for ( int c = 0; c < numCalls; c++ ) {
+			function();
+		}
+		const auto end = std::chrono::high_resolution_clock::now();
+		const double ms = std::chrono::duration< double, std::milli >( end - start ).count() / numCalls;
+		best = ( ms < best ) ? ms : best;
+	}
+	return best;
+}
+
+/*
+====================================================
+main
+
+--quick runs fewer repeats of the smaller sizes
+====================================================
+*/
+int main( int argc, char * argv[] ) {
+	bool isQuick = false;
+	for ( int i = 1; i < argc; i++ ) {
+		if ( 0 == strcmp( argv[ i ], "--quick" ) ) {
+			isQuick = true;
+		}
+	}
+
+	const int sizes[] = { 64, 128, 256, 512 };
+	const int numSizes = isQuick ? 2 : 4;
+	const int numRepeats = isQuick ? 2 : 5;
+
+	printf( "%6s %12s %12s %12s %12s %12s %12s\n", "n", "reference", "A*B", "A*B threads", "A*B^T", "A*x", "A^T*x" );
+	bool isCorrect = true;
+	for ( int s = 0; s < numSizes; s++ ) {
+		const int n = sizes[ s ];
+		const int numCalls = ( n <= 128 ) ? 50 : ( ( n <= 256 ) ? 5 : 1 );
+
+		MatMN a( n, n );
+		MatMN b( n, n );
+		MatMN out( n, n );
+		MatMN expected( n, n );
+		VecN x( n );
+		VecN y( n );
+		FillRandom( a );
+		FillRandom( b );
+		for ( int i = 0; i < n; i++ ) {
+			x[ i ] = (float)rand() / (float)RAND_MAX - 0.5f;
+		}
+
+		const double reference = TimeMs( numRepeats, numCalls, [ & ]() { MultiplyReference( a, b, expected ); } );
+
+		MatrixKernelsSetMaxThreads( 1 );
+		const double single = TimeMs( numRepeats, numCalls, [ & ]() { MatrixMultiply( a.rows, n, n, b.rows, n, out.rows ); } );
+		isCorrect = isCorrect && MaxDifference( out, expected ) < 1e-3f;
+
+		// Called back to back, as a solver would every step, so handing work to the threads is part of the cost
+		MatrixKernelsSetMaxThreads( 0 );
+		const double threaded = TimeMs( numRepeats, numCalls, [ & ]() { MatrixMultiply( a.rows, n, n, b.rows, n, out.rows ); } );
+		isCorrect = isCorrect && MaxDifference( out, expected ) < 1e-3f;
+
+		const MatMN bT = b.Transpose();
+		const double transposed = TimeMs( numRepeats, numCalls, [ & ]() { MatrixMultiplyTransposed( a.rows, n, n, bT.rows, n, out.rows ); } );
+		isCorrect = isCorrect && MaxDifference( out, expected ) < 1e-3f;
+
+		const double matVec = TimeMs( numRepeats, numCalls * 20, [ & ]() { MatrixVectorMultiply( a.rows, n, n, x, y ); } );
+		const double transposeVec = TimeMs( numRepeats, numCalls * 20, [ & ]() { MatrixTransposeVectorMultiply( a.rows, n, n, x, y ); } );
+
+		printf( "%6i %9.3f ms %9.3f ms %9.3f ms %9.3f ms %9.4f ms %9.4f ms\n", n, reference, single, threaded, transposed, matVec, transposeVec );
+	}
+
+	if ( !isCorrect ) {
+		printf( "ERROR: kernel results differ from the reference\n" );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,199 @@
+//
+//	AssetArchive.cpp
+//
+#include "AssetArchive.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+AssetArchive g_assetArchive;
+
+/*
+====================================================
+AssetArchive::AssetArchive
+====================================================
+*/
+AssetArchive::AssetArchive() :
+m_entries( NULL ),
+m_names( NULL ),
+m_numEntries( 0 ),
+m_modifiedTime( 0 ),
+m_isCheckingLooseFiles( false ) {
+}
+
+/*
+====================================================
+AssetArchive::Open
+====================================================
+*/
+bool AssetArchive::Open( const char * fileName ) {
+	Close();
+
+	// Everything in the archive is about to be loaded, so it may as well start coming in now
+	if ( !m_file.Open( fileName, true ) ) {
+		return false;
+	}
+
+	const unsigned char * data = m_file.Data();
+	const uint64_t size = m_file.Size();
+
+	AssetArchiveHeader_t header;
+	bool isValid = size >= sizeof( header );
+	if ( isValid ) {
+		memcpy( &header, data, sizeof( header ) );
+		isValid = ASSET_ARCHIVE_MAGIC == header.magic && ASSET_ARCHIVE_VERSION == header.version
+			&& 0 == header.entries % ASSET_ARCHIVE_ALIGNMENT && header.entries <= size
+			&& header.numEntries <= ( size - header.entries ) / sizeof( AssetArchiveEntry_t )
+			&& header.names <= size && header.namesSize <= size - header.names;
+	}
+
+	// Every name and every file has to be inside the archive, and the names in order for Find
+	const AssetArchiveEntry_t * entries = isValid ? (const AssetArchiveEntry_t *)( data + header.entries ) : NULL;
+	const char * names = isValid ? (const char *)( data + header.names ) : NULL;
+	for ( uint32_t i = 0; isValid && i < header.numEntries; i++ ) {
+		const AssetArchiveEntry_t & entry = entries[ i ];
+		isValid = (uint64_t)entry.name + entry.nameLength < header.namesSize && '\0' == names[ entry.name + entry.nameLength ]
+			&& 0 == entry.offset % ASSET_ARCHIVE_ALIGNMENT && entry.offset <= size && entry.size <= size - entry.offset
+			&& ( 0 == i || strcmp( names + entries[ i - 1 ].name, names + entry.name ) < 0 );
+	}
+
+	if ( !isValid ) {
+		printf( "ERROR: not a valid asset archive %s\n", fileName );
+		m_file.Close();
+		return false;
+	}
+
+	m_entries = entries;
+	m_names = names;
+	m_numEntries = header.numEntries;
+
+	// Without a time every loose file counts as newer, which is always safe
+	if ( !GetFileModifiedTime( fileName, m_modifiedTime ) ) {
+		m_modifiedTime = 0;
+	}
+	return true;
+}
+
+/*
+====================================================
+AssetArchive::Close
+====================================================
+*/
+void AssetArchive::Close() {
+	m_file.Close();
+	m_entries = NULL;
+	m_names = NULL;
+	m_numEntries = 0;
+	m_modifiedTime = 0;
+}
+
+/*
+====================================================
+AssetArchive::Find
+====================================================
+*/
+bool AssetArchive::Find( const char * name, const unsigned char ** data, size_t & size ) const {
+	const AssetArchiveEntry_t * end = m_entries + m_numEntries;
+	const AssetArchiveEntry_t * entry = std::lower_bound( m_entries, end, name, [ this ]( const AssetArchiveEntry_t & e, const char * key ) {
+		return strcmp( m_names + e.name, key ) < 0;
+	} );
+	if ( entry == end || 0 != strcmp( m_names + entry->name, name ) ) {
+		return false;
+	}
+
+	*data = m_file.Data() + entry->offset;
+	size = (size_t)entry->size;
+	return true;
+}
+
+/*
+====================================================
+AssetArchive::IsLooseFileNewer
+====================================================
+*/
+bool AssetArchive::IsLooseFileNewer( const char * name ) const {
+	if ( !m_isCheckingLooseFiles ) {
+		return false;
+	}
+	uint64_t time = 0;
+	return GetFileModifiedTime( name, time ) && time > m_modifiedTime;
+}
+
+/*
+====================================================
+AppendAligned
+Appends the bytes at the next aligned offset and returns that offset
+====================================================
+*/
+static uint64_t AppendAligned( std::vector< unsigned char > & buffer, const void * data, const size_t numBytes ) {
+	const uint64_t offset = ( buffer.size() + ASSET_ARCHIVE_ALIGNMENT - 1 ) / ASSET_ARCHIVE_ALIGNMENT * ASSET_ARCHIVE_ALIGNMENT;
+	buffer.resize( offset + numBytes, 0 );
+	if ( numBytes > 0 ) {
+		memcpy( buffer.data() + offset, data, numBytes );
+	}
+	return offset;
+}
+
+/*
+====================================================
+PackAssetArchive
+====================================================
+*/
+bool PackAssetArchive( const char * fileName, const char * const * directories, const int numDirectories ) {
+	std::vector< std::string > names;
+	for ( int i = 0; i < numDirectories; i++ ) {
+		std::vector< std::string > fileNames;
+		if ( !ListFiles( directories[ i ], fileNames ) ) {
+			printf( "ERROR: unable to list %s\n", directories[ i ] );
+			return false;
+		}
+		for ( int j = 0; j < fileNames.size(); j++ ) {
+			names.push_back( std::string( directories[ i ] ) + "/" + fileNames[ j ] );
+		}
+	}
+
+	// Sorted so the table of contents can be searched
+	std::sort( names.begin(), names.end() );
+	names.erase( std::unique( names.begin(), names.end() ), names.end() );
+
+	AssetArchiveHeader_t header;
+	memset( &header, 0, sizeof( header ) );
+	header.magic = ASSET_ARCHIVE_MAGIC;
+	header.version = ASSET_ARCHIVE_VERSION;
+	header.numEntries = (uint32_t)names.size();
+
+	std::vector< AssetArchiveEntry_t > entries( names.size() );
+	std::string nameTable;
+	for ( int i = 0; i < names.size(); i++ ) {
+		entries[ i ].name = (uint32_t)nameTable.size();
+		entries[ i ].nameLength = (uint32_t)names[ i ].size();
+		nameTable.append( names[ i ].c_str(), names[ i ].size() + 1 );
+	}
+	header.namesSize = nameTable.size();
+
+	std::vector< unsigned char > buffer;
+	AppendAligned( buffer, &header, sizeof( header ) );
+	header.entries = AppendAligned( buffer, entries.data(), entries.size() * sizeof( AssetArchiveEntry_t ) );
+	header.names = AppendAligned( buffer, nameTable.data(), nameTable.size() );
+
+	for ( int i = 0; i < names.size(); i++ ) {
+		FileView file;
+		if ( !file.Open( names[ i ].c_str() ) ) {
+			printf( "ERROR: unable to read %s\n", names[ i ].c_str() );
+			return false;
+		}
+		entries[ i ].offset = AppendAligned( buffer, file.Data(), file.Size() );
+		entries[ i ].size = file.Size();
+	}
+
+	memcpy( buffer.data(), &header, sizeof( header ) );
+	if ( !entries.empty() ) {
+		memcpy( buffer.data() + header.entries, entries.data(), entries.size() * sizeof( AssetArchiveEntry_t ) );
+	}
+	if ( !SaveFileData( fileName, buffer.data(), (unsigned int)buffer.size() ) ) {
+		return false;
+	}
+
+	printf( "Packed %i files into %s\n", (int)names.size(), fileName );
+	return true;
+}
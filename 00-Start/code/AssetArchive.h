@@ -0,0 +1,94 @@
+//
+//	AssetArchive.h
+//
+#pragma once
+#include "Fileio.h"
+#include <stdint.h>
+
+/*
+====================================================
+Asset archive
+
+Every asset file packed into one, so startup is one
+open and one mapping instead of an open per file, and
+a lookup of a file that isn't there costs nothing:
+
+	AssetArchiveHeader_t
+	AssetArchiveEntry_t[ numEntries ]	the table of contents, sorted by name
+	names								zero terminated, the entries point into them
+	file data						each file on an ASSET_ARCHIVE_ALIGNMENT boundary
+
+Files are named by their path relative to the
+application directory, as they would be opened loose.
+====================================================
+*/
+static const uint32_t ASSET_ARCHIVE_MAGIC = 0x4b415041;	// "APAK"
+static const uint32_t ASSET_ARCHIVE_VERSION = 1;
+static const uint64_t ASSET_ARCHIVE_ALIGNMENT = 16;
+
+struct AssetArchiveHeader_t {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numEntries;
+	uint32_t pad;
+
+	// Byte offsets from the start of the file
+	uint64_t entries;
+	uint64_t names;
+	uint64_t namesSize;
+};
+
+struct AssetArchiveEntry_t {
+	uint32_t name;			// offset into the names
+	uint32_t nameLength;	// without the zero
+	uint64_t offset;		// of the data from the start of the file
+	uint64_t size;
+};
+
+/*
+====================================================
+AssetArchive
+====================================================
+*/
+class AssetArchive {
+public:
+	AssetArchive();
+
+	// Checks the whole table of contents, an archive that doesn't check out isn't opened
+	bool Open( const char * fileName );
+	void Close();
+	bool IsOpen() const { return m_file.IsOpen(); }
+
+	// Points data at the file inside the mapped archive, valid until Close
+	bool Find( const char * name, const unsigned char ** data, size_t & size ) const;
+
+	// Whether the loose file of that name was written after the archive, so it
+	// was changed since it was packed and should be loaded instead.
+	// A file system call per name, so only with loose files checked, otherwise always false.
+	bool IsLooseFileNewer( const char * name ) const;
+
+	// For working on assets without repacking, off by default
+	void SetCheckLooseFiles( const bool isChecking ) { m_isCheckingLooseFiles = isChecking; }
+
+	int NumEntries() const { return (int)m_numEntries; }
+
+private:
+	AssetArchive( const AssetArchive & ) = delete;
+	AssetArchive & operator = ( const AssetArchive & ) = delete;
+
+	FileView m_file;
+	const AssetArchiveEntry_t * m_entries;
+	const char * m_names;
+	uint32_t m_numEntries;
+	uint64_t m_modifiedTime;
+	bool m_isCheckingLooseFiles;
+};
+
+// Opened by the application at startup, loaders look here before going to the loose files.
+// The archive isn't kept in the repository, the build packs it with --pack-assets.
+extern AssetArchive g_assetArchive;
+
+static const char * const ASSET_ARCHIVE_FILE = "data/assets.pak";
+
+// Packs every file directly in the directories, sub directories aren't followed
+bool PackAssetArchive( const char * fileName, const char * const * directories, const int numDirectories );
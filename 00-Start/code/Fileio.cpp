@@ -7,8 +7,18 @@
 #include <assert.h>
 #include <string.h>
 
+#if defined( _WIN32 )
 #include <direct.h>
+#include <windows.h>
 #define GetCurrentDir _getcwd
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define GetCurrentDir getcwd
+#endif
 
 static char g_ApplicationDirectory[ FILENAME_MAX ];
 static bool g_WasInitialized = false;
@@ -24,7 +34,7 @@ void InitializeFileSystem() {
 	}
 	g_WasInitialized = true;
 
-	const bool result = GetCurrentDir( g_ApplicationDirectory, sizeof( g_ApplicationDirectory ) );
+	const bool result = NULL != GetCurrentDir( g_ApplicationDirectory, sizeof( g_ApplicationDirectory ) );
 	assert( result );
 	if ( result ) {
 		printf( "ApplicationDirectory: %s\n", g_ApplicationDirectory );
@@ -47,7 +57,10 @@ void RelativePathToFullPath( const char * relativePathName, char * fullPath ) {
 /*
 ====================================================
 GetFileData
-Opens the file and stores it in data
+Opens the file and stores it in data, with a zero
+after the last byte.  The caller frees data.  Prefer
+FileView where a read-only view will do, it skips the
+copy.
 ====================================================
 */
 bool GetFileData( const char * fileNameLocal, unsigned char ** data, unsigned int & size ) {
@@ -66,11 +79,8 @@ bool GetFileData( const char * fileNameLocal, unsigned char ** data, unsigned in
 	
 	// get file size
 	fseek( file, 0, SEEK_END );
-	fflush( file );
-	size = ftell( file );
-	fflush( file );
+	size = (unsigned int)ftell( file );
 	rewind( file );
-	fflush( file );
 	
 	// create the data buffer
 	*data = (unsigned char*)malloc( ( size + 1 ) * sizeof( unsigned char ) );
@@ -81,13 +91,10 @@ bool GetFileData( const char * fileNameLocal, unsigned char ** data, unsigned in
 		fclose( file );
 		return false;
 	}
-
-	// zero out the memory
-	memset( *data, 0, ( size + 1 ) * sizeof( unsigned char ) );
 	
-	// read the data
+	// read the data, the read fills the buffer so only the terminator needs setting
 	unsigned int bytesRead = (unsigned int)fread( *data, sizeof( unsigned char ), size, file );
-    fflush( file );
+	( *data )[ size ] = 0;
     
     assert( bytesRead == size );
 	
@@ -95,9 +102,8 @@ bool GetFileData( const char * fileNameLocal, unsigned char ** data, unsigned in
 	if ( bytesRead != size ) {
 		printf( "ERROR: reading file went wrong %s\n", fileName );
 		fclose( file );
-		if ( *data != NULL ) {
-			free( *data );
-		}
+		free( *data );
+		*data = NULL;
 		return false;
 	}
 	
@@ -139,4 +145,242 @@ bool SaveFileData( const char * fileNameLocal, const void * data, unsigned int s
 	fclose( file );
 	printf( "Write file was success %s\n", fileName );
 	return true;
-}
\ No newline at end of file
+}
+
+/*
+====================================================
+ListFiles
+====================================================
+*/
+bool ListFiles( const char * directoryLocal, std::vector< std::string > & fileNames ) {
+	InitializeFileSystem();
+
+	char directory[ 2048 ];
+	sprintf( directory, "%s/%s", g_ApplicationDirectory, directoryLocal );
+
+	fileNames.clear();
+
+#if defined( _WIN32 )
+	char pattern[ 2048 ];
+	sprintf( pattern, "%s/*", directory );
+
+	WIN32_FIND_DATAA found;
+	HANDLE find = FindFirstFileA( pattern, &found );
+	if ( INVALID_HANDLE_VALUE == find ) {
+		return false;
+	}
+	do {
+		if ( 0 == ( found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) ) {
+			fileNames.push_back( found.cFileName );
+		}
+	} while ( FindNextFileA( find, &found ) );
+	FindClose( find );
+#else
+	DIR * dir = opendir( directory );
+	if ( NULL == dir ) {
+		return false;
+	}
+	for ( struct dirent * entry = readdir( dir ); NULL != entry; entry = readdir( dir ) ) {
+		char path[ 4096 ];
+		snprintf( path, sizeof( path ), "%s/%s", directory, entry->d_name );
+
+		struct stat status;
+		if ( 0 == stat( path, &status ) && S_ISREG( status.st_mode ) ) {
+			fileNames.push_back( entry->d_name );
+		}
+	}
+	closedir( dir );
+#endif
+	return true;
+}
+
+/*
+====================================================
+GetFileModifiedTime
+====================================================
+*/
+bool GetFileModifiedTime( const char * fileNameLocal, uint64_t & time ) {
+	InitializeFileSystem();
+
+	char fileName[ 2048 ];
+	sprintf( fileName, "%s/%s", g_ApplicationDirectory, fileNameLocal );
+
+#if defined( _WIN32 )
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if ( !GetFileAttributesExA( fileName, GetFileExInfoStandard, &attributes ) ) {
+		return false;
+	}
+	time = ( (uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32 ) | attributes.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat status;
+	if ( 0 != stat( fileName, &status ) ) {
+		return false;
+	}
+	time = (uint64_t)status.st_mtime;
+#endif
+	return true;
+}
+
+/*
+====================================================
+FileView::FileView
+====================================================
+*/
+FileView::FileView() :
+m_data( NULL ),
+m_size( 0 ),
+m_file( NULL ),
+m_mapping( NULL ) {
+}
+
+/*
+====================================================
+FileView::~FileView
+====================================================
+*/
+FileView::~FileView() {
+	Close();
+}
+
+/*
+====================================================
+FileView::FileView
+====================================================
+*/
+FileView::FileView( FileView && rhs ) :
+m_data( rhs.m_data ),
+m_size( rhs.m_size ),
+m_file( rhs.m_file ),
+m_mapping( rhs.m_mapping ) {
+	rhs.m_data = NULL;
+	rhs.m_size = 0;
+	rhs.m_file = NULL;
+	rhs.m_mapping = NULL;
+}
+
+/*
+====================================================
+FileView::operator =
+====================================================
+*/
+FileView & FileView::operator = ( FileView && rhs ) {
+	if ( this != &rhs ) {
+		Close();
+		m_data = rhs.m_data;
+		m_size = rhs.m_size;
+		m_file = rhs.m_file;
+		m_mapping = rhs.m_mapping;
+		rhs.m_data = NULL;
+		rhs.m_size = 0;
+		rhs.m_file = NULL;
+		rhs.m_mapping = NULL;
+	}
+	return *this;
+}
+
+/*
+====================================================
+FileView::Open
+====================================================
+*/
+bool FileView::Open( const char * fileNameLocal, const bool prefetch ) {
+	Close();
+	InitializeFileSystem();
+
+	char fileName[ 2048 ];
+	sprintf( fileName, "%s/%s", g_ApplicationDirectory, fileNameLocal );
+
+#if defined( _WIN32 )
+	HANDLE file = CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( INVALID_HANDLE_VALUE == file ) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx( file, &size ) || 0 == size.QuadPart ) {
+		// Empty files can't be mapped
+		CloseHandle( file );
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( NULL == mapping ) {
+		CloseHandle( file );
+		return false;
+	}
+
+	void * data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if ( NULL == data ) {
+		printf( "ERROR: mapping file went wrong %s\n", fileName );
+		CloseHandle( mapping );
+		CloseHandle( file );
+		return false;
+	}
+
+#if _WIN32_WINNT >= 0x0602
+	if ( prefetch ) {
+		// Queues the reads and returns, a hint only so failure doesn't matter
+		WIN32_MEMORY_RANGE_ENTRY range;
+		range.VirtualAddress = data;
+		range.NumberOfBytes = (SIZE_T)size.QuadPart;
+		PrefetchVirtualMemory( GetCurrentProcess(), 1, &range, 0 );
+	}
+#endif
+
+	m_data = (const unsigned char *)data;
+	m_size = (size_t)size.QuadPart;
+	m_file = file;
+	m_mapping = mapping;
+#else
+	const int file = open( fileName, O_RDONLY );
+	if ( file < 0 ) {
+		return false;
+	}
+
+	struct stat status;
+	if ( fstat( file, &status ) != 0 || 0 == status.st_size ) {
+		close( file );
+		return false;
+	}
+
+	void * data = mmap( NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+	close( file );
+	if ( MAP_FAILED == data ) {
+		printf( "ERROR: mapping file went wrong %s\n", fileName );
+		return false;
+	}
+
+	if ( prefetch ) {
+		// Starts the read ahead and returns, a hint only so failure doesn't matter
+		madvise( data, (size_t)status.st_size, MADV_WILLNEED );
+	}
+
+	m_data = (const unsigned char *)data;
+	m_size = (size_t)status.st_size;
+#endif
+	return true;
+}
+
+/*
+====================================================
+FileView::Close
+====================================================
+*/
+void FileView::Close() {
+	if ( NULL == m_data ) {
+		return;
+	}
+
+#if defined( _WIN32 )
+	UnmapViewOfFile( m_data );
+	CloseHandle( (HANDLE)m_mapping );
+	CloseHandle( (HANDLE)m_file );
+#else
+	munmap( (void *)m_data, m_size );
+#endif
+
+	m_data = NULL;
+	m_size = 0;
+	m_file = NULL;
+	m_mapping = NULL;
+}
@@ -2,6 +2,55 @@
 //	Fileio.h
 //
 #pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
 
+void RelativePathToFullPath( const char * relativePathName, char * fullPath );
 bool GetFileData( const char * fileName, unsigned char ** data, unsigned int & size );
-bool SaveFileData( const char * fileName, const void * data, unsigned int size );
\ No newline at end of file
+bool SaveFileData( const char * fileName, const void * data, unsigned int size );
+
+// Names of the files directly in the directory, not of the directories in it
+bool ListFiles( const char * directory, std::vector< std::string > & fileNames );
+
+// Last time the file was written, only meaningful compared with another from here
+bool GetFileModifiedTime( const char * fileName, uint64_t & time );
+
+/*
+====================================================
+FileView
+
+Read-only view of a whole file mapped into memory,
+unmapped when the view goes away.  Nothing is read up
+front, pages come in from disk the first time they are
+touched.  With prefetch the OS is asked to start
+reading the whole file in the background right away,
+Open still returns at once.
+====================================================
+*/
+class FileView {
+public:
+	FileView();
+	~FileView();
+	FileView( FileView && rhs );
+	FileView & operator = ( FileView && rhs );
+
+	bool Open( const char * fileName, const bool prefetch = false );
+	void Close();
+	bool IsOpen() const { return NULL != m_data; }
+
+	const unsigned char * Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+
+private:
+	FileView( const FileView & ) = delete;
+	FileView & operator = ( const FileView & ) = delete;
+
+	const unsigned char * m_data;
+	size_t m_size;
+
+	// Platform handles, kept until Close
+	void * m_file;
+	void * m_mapping;
+};
@@ -22,4 +22,124 @@ VecN LCP_GaussSeidel( const MatN & A, const VecN & b ) {
 		}
 	}
 	return x;
-}
\ No newline at end of file
+}
+
+/*
+====================================================
+ProjectedResidual
+Largest | b - A x | over the rows, leaving out rows held at a bound
+by a residual that pushes further into it: those are complementary
+====================================================
+*/
+static float ProjectedResidual( const MatN & A, const VecN & b, const VecN & x, const VecN * lo, const VecN * hi ) {
+	float residual = 0.0f;
+	for ( int i = 0; i < b.N; i++ ) {
+		const float r = b[ i ] - A.rows[ i ].Dot( x );
+		if ( NULL != lo && x[ i ] <= ( *lo )[ i ] && r <= 0.0f ) {
+			continue;
+		}
+		if ( NULL != hi && x[ i ] >= ( *hi )[ i ] && r >= 0.0f ) {
+			continue;
+		}
+		if ( fabsf( r ) > residual ) {
+			residual = fabsf( r );
+		}
+	}
+	return residual;
+}
+
+/*
+====================================================
+LCP_ProjectedGaussSeidel
+
+Gauss-Seidel with the solution clamped to [ lo, hi ] after
+every row update.  The residual of a row is already needed
+to compute its update, so the convergence checks come
+for free with each sweep.  That estimate only decides the early
+exit, each row's residual is taken before the row is updated.
+====================================================
+*/
+VecN LCP_ProjectedGaussSeidel( const MatN & A, const VecN & b, const LCPParms_t & parms, LCPResult_t * result ) {
+	const int N = b.N;
+	VecN x( N );
+	if ( NULL != parms.x0 && parms.x0->N == N ) {
+		x = *parms.x0;
+	} else {
+		x.Zero();
+	}
+
+	const VecN * lo = ( NULL != parms.lo && parms.lo->N == N ) ? parms.lo : NULL;
+	const VecN * hi = ( NULL != parms.hi && parms.hi->N == N ) ? parms.hi : NULL;
+
+	// Clamp the warm start, it may come from a different set of bounds
+	for ( int i = 0; i < N; i++ ) {
+		if ( NULL != lo && x[ i ] < ( *lo )[ i ] ) {
+			x[ i ] = ( *lo )[ i ];
+		}
+		if ( NULL != hi && x[ i ] > ( *hi )[ i ] ) {
+			x[ i ] = ( *hi )[ i ];
+		}
+	}
+
+	const int maxIterations = ( parms.maxIterations > 0 ) ? parms.maxIterations : N;
+	const float omega = parms.relaxation;
+
+	int iter = 0;
+	float residual = 0.0f;
+	float maxDelta = 0.0f;
+	while ( iter < maxIterations ) {
+		residual = 0.0f;
+		maxDelta = 0.0f;
+
+		for ( int i = 0; i < N; i++ ) {
+			const float r = b[ i ] - A.rows[ i ].Dot( x );
+			float dx = omega * r / A.rows[ i ][ i ];
+			if ( dx * 0.0f != dx * 0.0f ) {
+				// Singular row, leave it alone
+				continue;
+			}
+
+			float xi = x[ i ] + dx;
+			bool clamped = false;
+			if ( NULL != lo && xi < ( *lo )[ i ] ) {
+				xi = ( *lo )[ i ];
+				clamped = true;
+			}
+			if ( NULL != hi && xi > ( *hi )[ i ] ) {
+				xi = ( *hi )[ i ];
+				clamped = true;
+			}
+
+			// A row pinned to its bound is complementary as long as the
+			// residual pushes further into the bound, so it doesn't count.
+			const bool isComplementary = clamped && ( xi == x[ i ] );
+			if ( !isComplementary && fabsf( r ) > residual ) {
+				residual = fabsf( r );
+			}
+
+			dx = xi - x[ i ];
+			if ( fabsf( dx ) > maxDelta ) {
+				maxDelta = fabsf( dx );
+			}
+			x[ i ] = xi;
+		}
+
+		iter++;
+
+		if ( maxDelta <= parms.maxDeltaTolerance ) {
+			break;
+		}
+		if ( residual <= parms.residualTolerance ) {
+			break;
+		}
+	}
+
+	if ( NULL != result ) {
+		// The residual tracked in the sweep was taken before each row moved, the
+		// one reported is for the x returned.  Only worth a product when asked for.
+		result->numIterations = iter;
+		result->residual = ProjectedResidual( A, b, x, lo, hi );
+		result->maxDelta = maxDelta;
+	}
+	return x;
+}
@@ -11,4 +11,51 @@
 LCP_GaussSeidel
 ====================================================
 */
-VecN LCP_GaussSeidel( const MatN & A, const VecN & b );
\ No newline at end of file
+VecN LCP_GaussSeidel( const MatN & A, const VecN & b );
+
+/*
+====================================================
+LCPParms_t
+
+Settings for the projected Gauss-Seidel solver.
+Any of the bound/warm start vectors may be NULL.
+====================================================
+*/
+struct LCPParms_t {
+	LCPParms_t() {
+		maxIterations = 0;
+		relaxation = 1.0f;
+		maxDeltaTolerance = 0.0f;
+		residualTolerance = 0.0f;
+		lo = NULL;
+		hi = NULL;
+		x0 = NULL;
+	}
+
+	int maxIterations;			// zero means N iterations, like LCP_GaussSeidel
+	float relaxation;			// successive over-relaxation factor, in ( 0, 2 )
+	float maxDeltaTolerance;	// exit once no component moves more than this in a sweep
+	float residualTolerance;	// exit once the projected residual drops below this
+
+	const VecN * lo;			// per row lower bound, NULL means unbounded
+	const VecN * hi;			// per row upper bound, NULL means unbounded
+	const VecN * x0;			// warm start, NULL means start from zero
+};
+
+/*
+====================================================
+LCPResult_t
+====================================================
+*/
+struct LCPResult_t {
+	int numIterations;
+	float residual;		// largest projected residual | b - A x | of the returned x, rows complementary at a bound excluded
+	float maxDelta;		// largest change of a component in the last sweep
+};
+
+/*
+====================================================
+LCP_ProjectedGaussSeidel
+====================================================
+*/
+VecN LCP_ProjectedGaussSeidel( const MatN & A, const VecN & b, const LCPParms_t & parms, LCPResult_t * result = NULL );
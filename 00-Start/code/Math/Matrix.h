@@ -3,6 +3,7 @@
 //
 #pragma once
 #include "Vector.h"
+#include "MatrixKernels.h"
 
 /*
 ====================================================
@@ -545,19 +546,28 @@ MatMN
 */
 class MatMN {
 public:
-	MatMN() : M( 0 ), N( 0 ) {}
+	MatMN() : M( 0 ), N( 0 ), rows( NULL ) {}
 	MatMN( int M, int N );
-	MatMN( const MatMN & rhs ) {
+	MatMN( const MatMN & rhs ) : M( 0 ), N( 0 ), rows( NULL ) {
 		*this = rhs;
 	}
+	MatMN( MatMN && rhs ) : M( rhs.M ), N( rhs.N ), rows( rhs.rows ) {
+		rhs.M = 0;
+		rhs.N = 0;
+		rhs.rows = NULL;
+	}
 	~MatMN() { delete[] rows; }
 
 	const MatMN & operator = ( const MatMN & rhs );
+	const MatMN & operator = ( MatMN && rhs );
 	const MatMN & operator *= ( float rhs );
 	VecN operator * ( const VecN & rhs ) const;
 	MatMN operator * ( const MatMN & rhs ) const;
 	MatMN operator * ( const float rhs ) const;
 
+	MatMN MultiplyTransposed( const MatMN & rhs ) const;	// this * rhs^T, without building the transpose
+	VecN TransposeMultiply( const VecN & rhs ) const;		// this^T * rhs, without building the transpose
+
 	void Zero();
 	MatMN Transpose() const;
 
@@ -572,20 +582,45 @@ inline MatMN::MatMN( int _M, int _N ) {
 	N = _N;
 	rows = new VecN[ M ];
 	for ( int m = 0; m < M; m++ ) {
-		rows[ m ] = VecN( N );
+		rows[ m ].Resize( N );
 	}
 }
 
 inline const MatMN & MatMN::operator = ( const MatMN & rhs ) {
+	if ( this == &rhs ) {
+		return *this;
+	}
+
+	// Only reallocate the row array when the row count changes,
+	// the rows themselves reuse their storage when they can
+	if ( M != rhs.M ) {
+		delete[] rows;
+		rows = ( rhs.M > 0 ) ? new VecN[ rhs.M ] : NULL;
+	}
 	M = rhs.M;
 	N = rhs.N;
-	rows = new VecN[ M ];
 	for ( int m = 0; m < M; m++ ) {
 		rows[ m ] = rhs.rows[ m ];
 	}
 	return *this;
 }
 
+inline const MatMN & MatMN::operator = ( MatMN && rhs ) {
+	if ( this == &rhs ) {
+		return *this;
+	}
+
+	delete[] rows;
+	M = rhs.M;
+	N = rhs.N;
+	rows = rhs.rows;
+
+	rhs.M = 0;
+	rhs.N = 0;
+	rhs.rows = NULL;
+	return *this;
+}
+
 inline const MatMN & MatMN::operator *= ( float rhs ) {
 	for ( int m = 0; m < M; m++ ) {
 		rows[ m ] *= rhs;
@@ -600,26 +635,40 @@ inline VecN MatMN::operator * ( const VecN & rhs ) const {
 	}
 
 	VecN tmp( M );
-	for ( int m = 0; m < M; m++ ) {
-		tmp[ m ] = rhs.Dot( rows[ m ] );
-	}
+	MatrixVectorMultiply( rows, M, N, rhs, tmp );
 	return tmp;
 }
 
 inline MatMN MatMN::operator * ( const MatMN & rhs ) const {
 	// Check that the incoming matrix of the correct dimension
-	if ( rhs.M != N && rhs.N != M ) {
+	if ( rhs.M != N ) {
 		return rhs;
 	}
 
-	MatMN tranposedRHS = rhs.Transpose();
-
 	MatMN tmp( M, rhs.N );
-	for ( int m = 0; m < M; m++ ) {
-		for ( int n = 0; n < rhs.N; n++ ) {
-			tmp.rows[ m ][ n ] = rows[ m ].Dot( tranposedRHS.rows[ n ] );
-		}
+	MatrixMultiply( rows, M, N, rhs.rows, rhs.N, tmp.rows );
+	return tmp;
+}
+
+inline MatMN MatMN::MultiplyTransposed( const MatMN & rhs ) const {
+	// Check that the incoming matrix of the correct dimension
+	if ( rhs.N != N ) {
+		return rhs;
+	}
+
+	MatMN tmp( M, rhs.M );
+	MatrixMultiplyTransposed( rows, M, N, rhs.rows, rhs.M, tmp.rows );
+	return tmp;
+}
+
+inline VecN MatMN::TransposeMultiply( const VecN & rhs ) const {
+	// Check that the incoming vector is of the correct dimension
+	if ( rhs.N != M ) {
+		return rhs;
 	}
+
+	VecN tmp( N );
+	MatrixTransposeVectorMultiply( rows, M, N, rhs, tmp );
 	return tmp;
 }
 
@@ -656,17 +705,22 @@ MatN
 */
 class MatN {
 public:
-	MatN() : numDimensions( 0 ) {}
+	MatN() : numDimensions( 0 ), rows( NULL ) {}
 	MatN( int N );
-	MatN( const MatN & rhs ) {
+	MatN( const MatN & rhs ) : numDimensions( 0 ), rows( NULL ) {
 		*this = rhs;
 	}
-	MatN( const MatMN & rhs ) {
+	MatN( MatN && rhs ) : numDimensions( rhs.numDimensions ), rows( rhs.rows ) {
+		rhs.numDimensions = 0;
+		rhs.rows = NULL;
+	}
+	MatN( const MatMN & rhs ) : numDimensions( 0 ), rows( NULL ) {
 		*this = rhs;
 	}
 	~MatN() { delete[] rows; }
 
 	const MatN & operator = ( const MatN & rhs );
+	const MatN & operator = ( MatN && rhs );
 	const MatN & operator = ( const MatMN & rhs );
 
 	void Identity();
@@ -674,8 +728,8 @@ public:
 	void Transpose();
 
 	void operator *= ( float rhs );
-	VecN operator * ( const VecN & rhs );
-	MatN operator * ( const MatN & rhs );
+	VecN operator * ( const VecN & rhs ) const;
+	MatN operator * ( const MatN & rhs ) const;
 
 public:
 	int		numDimensions;
@@ -686,26 +740,50 @@ inline MatN::MatN( int N ) {
 	numDimensions = N;
 	rows = new VecN[ N ];
 	for ( int i = 0; i < N; i++ ) {
-		rows[ i ] = VecN( N );
+		rows[ i ].Resize( N );
 	}
 }
 
 inline const MatN & MatN::operator = ( const MatN & rhs ) {
+	if ( this == &rhs ) {
+		return *this;
+	}
+
+	if ( numDimensions != rhs.numDimensions ) {
+		delete[] rows;
+		rows = ( rhs.numDimensions > 0 ) ? new VecN[ rhs.numDimensions ] : NULL;
+	}
 	numDimensions = rhs.numDimensions;
-	rows = new VecN[ numDimensions ];
 	for ( int i = 0; i < numDimensions; i++ ) {
 		rows[ i ] = rhs.rows[ i ];
 	}
 	return *this;
 }
 
+inline const MatN & MatN::operator = ( MatN && rhs ) {
+	if ( this == &rhs ) {
+		return *this;
+	}
+
+	delete[] rows;
+	numDimensions = rhs.numDimensions;
+	rows = rhs.rows;
+
+	rhs.numDimensions = 0;
+	rhs.rows = NULL;
+	return *this;
+}
+
 inline const MatN & MatN::operator = ( const MatMN & rhs ) {
 	if ( rhs.M != rhs.N ) {
 		return *this;
 	}
 
+	if ( numDimensions != rhs.N ) {
+		delete[] rows;
+		rows = ( rhs.N > 0 ) ? new VecN[ rhs.N ] : NULL;
+	}
 	numDimensions = rhs.N;
-	rows = new VecN[ numDimensions ];
 	for ( int i = 0; i < numDimensions; i++ ) {
 		rows[ i ] = rhs.rows[ i ];
 	}
@@ -734,7 +812,7 @@ inline void MatN::Transpose() {
 		}
 	}
 
-	*this = tmp;
+	*this = static_cast< MatN && >( tmp );
 }
 
 inline void MatN::operator *= ( float rhs ) {
@@ -743,25 +821,14 @@ inline void MatN::operator *= ( float rhs ) {
 	}
 }
 
-inline VecN MatN::operator * ( const VecN & rhs ) {
+inline VecN MatN::operator * ( const VecN & rhs ) const {
 	VecN tmp( numDimensions );
-
-	for ( int i = 0; i < numDimensions; i++ ) {
-		tmp[ i ] = rows[ i ].Dot( rhs );
-	}
-
+	MatrixVectorMultiply( rows, numDimensions, numDimensions, rhs, tmp );
 	return tmp;
 }
 
-inline MatN MatN::operator * ( const MatN & rhs ) {
+inline MatN MatN::operator * ( const MatN & rhs ) const {
 	MatN tmp( numDimensions );
-	tmp.Zero();
-
-	for ( int i = 0; i < numDimensions; i++ ) {
-		for ( int j = 0; j < numDimensions; j++ ) {
-			tmp.rows[ i ][ j ] += rows[ i ][ j ] * rhs.rows[ j ][ i ];
-		}
-	}
-
+	MatrixMultiply( rows, numDimensions, numDimensions, rhs.rows, numDimensions, tmp.rows );
 	return tmp;
 }
\ No newline at end of file
@@ -0,0 +1,332 @@
+//
+//	MatrixKernels.cpp
+//
+#include "MatrixKernels.h"
+#include "Vector.h"
+#include <atomic>
+#include <condition_variable>
+#include <stdint.h>
+#include <string.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined( _M_X64 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define MATRIX_KERNELS_SSE
+#endif
+
+static int g_maxThreads = 0;
+
+// Below this many multiply-adds handing rows to the workers costs more than it saves
+static const long long THREADING_MIN_WORK = 64 * 64 * 64;
+
+// Block sizes chosen so that a block of b rows (BLOCK_K x BLOCK_N floats)
+// sits comfortably in a 32KB L1 data cache
+static const int BLOCK_K = 32;
+static const int BLOCK_N = 128;
+
+/*
+====================================================
+MatrixKernelsSetMaxThreads
+====================================================
+*/
+void MatrixKernelsSetMaxThreads( const int maxThreads ) {
+	g_maxThreads = maxThreads;
+}
+
+/*
+====================================================
+DotProduct
+====================================================
+*/
+static float DotProduct( const float * a, const float * b, const int num ) {
+	int i = 0;
+	float sum = 0.0f;
+#if defined( MATRIX_KERNELS_SSE )
+	__m128 sum4 = _mm_setzero_ps();
+	for ( ; i + 4 <= num; i += 4 ) {
+		sum4 = _mm_add_ps( sum4, _mm_mul_ps( _mm_loadu_ps( a + i ), _mm_loadu_ps( b + i ) ) );
+	}
+	float lanes[ 4 ];
+	_mm_storeu_ps( lanes, sum4 );
+	sum = ( lanes[ 0 ] + lanes[ 1 ] ) + ( lanes[ 2 ] + lanes[ 3 ] );
+#endif
+	for ( ; i < num; i++ ) {
+		sum += a[ i ] * b[ i ];
+	}
+	return sum;
+}
+
+/*
+====================================================
+MultiplyAdd
+out += a * s
+====================================================
+*/
+static void MultiplyAdd( float * out, const float * a, const float s, const int num ) {
+	int i = 0;
+#if defined( MATRIX_KERNELS_SSE )
+	const __m128 s4 = _mm_set1_ps( s );
+	for ( ; i + 4 <= num; i += 4 ) {
+		const __m128 o = _mm_loadu_ps( out + i );
+		_mm_storeu_ps( out + i, _mm_add_ps( o, _mm_mul_ps( _mm_loadu_ps( a + i ), s4 ) ) );
+	}
+#endif
+	for ( ; i < num; i++ ) {
+		out[ i ] += a[ i ] * s;
+	}
+}
+
+/*
+====================================================
+KernelWorkers
+
+Threads started on first use and kept for the life of
+the process, so a kernel called every step doesn't pay
+for starting threads.  A job is a range of rows split
+into chunks, the workers and the calling thread take
+chunks until there are none left.  One job runs at a
+time, callers on other threads wait their turn.
+====================================================
+*/
+class KernelWorkers {
+public:
+	typedef void ( *Function_t )( const void * kernel, const int rowBegin, const int rowEnd );
+
+	KernelWorkers() : m_generation( 0 ), m_isStopping( false ), m_claims( 0 ), m_numDone( 0 ) {
+		memset( &m_job, 0, sizeof( m_job ) );
+	}
+	~KernelWorkers() {
+		{
+			std::lock_guard< std::mutex > guard( m_lock );
+			m_isStopping = true;
+		}
+		m_wake.notify_all();
+		for ( int i = 0; i < (int)m_threads.size(); i++ ) {
+			m_threads[ i ].join();
+		}
+	}
+
+	void Run( const Function_t function, const void * kernel, const int numRows, const int numChunks ) {
+		std::lock_guard< std::mutex > jobGuard( m_jobLock );
+
+		// Grows to the most chunks ever asked for, the caller takes chunks too
+		while ( (int)m_threads.size() < numChunks - 1 ) {
+			m_threads.push_back( std::thread( &KernelWorkers::WorkerThread, this ) );
+		}
+
+		Job_t job;
+		job.function = function;
+		job.kernel = kernel;
+		job.numRows = numRows;
+		job.numChunks = numChunks;
+		job.rowsPerChunk = ( numRows + numChunks - 1 ) / numChunks;
+
+		uint32_t generation;
+		{
+			std::lock_guard< std::mutex > guard( m_lock );
+			m_job = job;
+			m_numDone = 0;
+			generation = ++m_generation;
+			m_claims = (uint64_t)generation << 32;
+		}
+		m_wake.notify_all();
+
+		RunChunks( job, generation );
+
+		std::unique_lock< std::mutex > guard( m_lock );
+		m_done.wait( guard, [ & ]() { return m_numDone == job.numChunks; } );
+	}
+
+private:
+	struct Job_t {
+		Function_t function;
+		const void * kernel;
+		int numRows;
+		int rowsPerChunk;
+		int numChunks;
+	};
+
+	// The job's generation is in the top half of each claim, so a thread
+	// still finishing an earlier job can't take a chunk of this one
+	bool ClaimChunk( const Job_t & job, const uint32_t generation, int & chunk ) {
+		uint64_t claims = m_claims.load();
+		while ( (uint32_t)( claims >> 32 ) == generation && (int)( claims & 0xffffffff ) < job.numChunks ) {
+			if ( m_claims.compare_exchange_weak( claims, claims + 1 ) ) {
+				chunk = (int)( claims & 0xffffffff );
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void RunChunks( const Job_t & job, const uint32_t generation ) {
+		int numDone = 0;
+		int chunk;
+		while ( ClaimChunk( job, generation, chunk ) ) {
+			const int begin = chunk * job.rowsPerChunk;
+			const int end = ( begin + job.rowsPerChunk < job.numRows ) ? begin + job.rowsPerChunk : job.numRows;
+			if ( begin < end ) {
+				job.function( job.kernel, begin, end );
+			}
+			numDone++;
+		}
+		if ( numDone > 0 ) {
+			std::lock_guard< std::mutex > guard( m_lock );
+			m_numDone += numDone;
+			if ( m_numDone == job.numChunks ) {
+				m_done.notify_all();
+			}
+		}
+	}
+
+	void WorkerThread() {
+		uint32_t generation = 0;
+		while ( true ) {
+			Job_t job;
+			{
+				std::unique_lock< std::mutex > guard( m_lock );
+				m_wake.wait( guard, [ & ]() { return m_isStopping || m_generation != generation; } );
+				if ( m_isStopping ) {
+					return;
+				}
+				generation = m_generation;
+				job = m_job;
+			}
+			RunChunks( job, generation );
+		}
+	}
+
+	std::mutex m_jobLock;	// held by the caller for the whole job
+	std::mutex m_lock;		// guards the job, the generation and the done count
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	std::vector< std::thread > m_threads;
+	uint32_t m_generation;
+	bool m_isStopping;
+
+	Job_t m_job;
+	std::atomic< uint64_t > m_claims;
+	int m_numDone;
+};
+
+/*
+====================================================
+ParallelRows
+Calls kernel( rowBegin, rowEnd ) over [ 0, numRows ) split into contiguous chunks
+====================================================
+*/
+template< typename Kernel >
+static void ParallelRows( const int numRows, const long long work, const Kernel & kernel ) {
+	if ( work < THREADING_MIN_WORK || 1 == g_maxThreads ) {
+		kernel( 0, numRows );
+		return;
+	}
+
+	int numThreads = g_maxThreads;
+	if ( numThreads <= 0 ) {
+		static const int numHardwareThreads = (int)std::thread::hardware_concurrency();
+		numThreads = numHardwareThreads;
+	}
+	if ( numThreads > numRows ) {
+		numThreads = numRows;
+	}
+	if ( numThreads <= 1 ) {
+		kernel( 0, numRows );
+		return;
+	}
+
+	// Each row still goes to exactly one thread, whichever takes its chunk
+	static KernelWorkers workers;
+	struct Call_t {
+		static void Run( const void * k, const int rowBegin, const int rowEnd ) {
+			( *(const Kernel *)k )( rowBegin, rowEnd );
+		}
+	};
+	workers.Run( &Call_t::Run, &kernel, numRows, numThreads );
+}
+
+/*
+====================================================
+MatrixMultiply
+====================================================
+*/
+void MatrixMultiply( const VecN * a, const int M, const int K, const VecN * b, const int N, VecN * out ) {
+	for ( int i = 0; i < M; i++ ) {
+		out[ i ].Zero();
+	}
+
+	// i-k-j ordering: each a( i, k ) is broadcast against a contiguous
+	// run of row k of b and accumulated into a contiguous run of row i.
+	// The k and j loops are blocked so the touched part of b stays in cache.
+	auto kernel = [ = ]( const int rowBegin, const int rowEnd ) {
+		for ( int j0 = 0; j0 < N; j0 += BLOCK_N ) {
+			const int numJ = ( j0 + BLOCK_N < N ) ? BLOCK_N : N - j0;
+
+			for ( int k0 = 0; k0 < K; k0 += BLOCK_K ) {
+				const int k1 = ( k0 + BLOCK_K < K ) ? k0 + BLOCK_K : K;
+
+				for ( int i = rowBegin; i < rowEnd; i++ ) {
+					const float * rowA = a[ i ].data;
+					float * rowOut = out[ i ].data + j0;
+					for ( int k = k0; k < k1; k++ ) {
+						MultiplyAdd( rowOut, b[ k ].data + j0, rowA[ k ], numJ );
+					}
+				}
+			}
+		}
+	};
+	ParallelRows( M, (long long)M * N * K, kernel );
+}
+
+/*
+====================================================
+MatrixMultiplyTransposed
+====================================================
+*/
+void MatrixMultiplyTransposed( const VecN * a, const int M, const int K, const VecN * b, const int N, VecN * out ) {
+	// Both operands are read along their rows, so this is a grid of dot products.
+	// Blocking over the rows of b keeps them hot while sweeping the rows of a.
+	const int BLOCK_ROWS = 16;
+	auto kernel = [ = ]( const int rowBegin, const int rowEnd ) {
+		for ( int j0 = 0; j0 < N; j0 += BLOCK_ROWS ) {
+			const int j1 = ( j0 + BLOCK_ROWS < N ) ? j0 + BLOCK_ROWS : N;
+
+			for ( int i = rowBegin; i < rowEnd; i++ ) {
+				for ( int j = j0; j < j1; j++ ) {
+					out[ i ].data[ j ] = DotProduct( a[ i ].data, b[ j ].data, K );
+				}
+			}
+		}
+	};
+	ParallelRows( M, (long long)M * N * K, kernel );
+}
+
+/*
+====================================================
+MatrixVectorMultiply
+====================================================
+*/
+void MatrixVectorMultiply( const VecN * a, const int M, const int N, const VecN & x, VecN & out ) {
+	auto kernel = [ & ]( const int rowBegin, const int rowEnd ) {
+		for ( int i = rowBegin; i < rowEnd; i++ ) {
+			out.data[ i ] = DotProduct( a[ i ].data, x.data, N );
+		}
+	};
+	ParallelRows( M, (long long)M * N, kernel );
+}
+
+/*
+====================================================
+MatrixTransposeVectorMultiply
+====================================================
+*/
+void MatrixTransposeVectorMultiply( const VecN * a, const int M, const int N, const VecN & x, VecN & out ) {
+	// Accumulate scaled rows of a rather than walking its columns.
+	// Every output element depends on every row, so this one stays single threaded.
+	out.Zero();
+	for ( int i = 0; i < M; i++ ) {
+		MultiplyAdd( out.data, a[ i ].data, x.data[ i ], N );
+	}
+}
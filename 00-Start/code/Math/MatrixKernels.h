@@ -0,0 +1,35 @@
+//
+//	MatrixKernels.h
+//
+#pragma once
+
+class VecN;
+
+/*
+====================================================
+Matrix kernels
+
+Dense kernels over row-major matrices stored as arrays of VecN rows,
+which is the layout used by MatMN and MatN.  Inner loops always walk
+rows contiguously, never down a column.  Outputs must not alias inputs.
+
+Large products are split by output rows across a pool of worker threads
+started on first use.  Every output element is computed by exactly one
+thread in a fixed order, so the result doesn't depend on the thread count.
+====================================================
+*/
+
+// out( M x N ) = a( M x K ) * b( K x N )
+void MatrixMultiply( const VecN * a, const int M, const int K, const VecN * b, const int N, VecN * out );
+
+// out( M x N ) = a( M x K ) * transpose( b( N x K ) )
+void MatrixMultiplyTransposed( const VecN * a, const int M, const int K, const VecN * b, const int N, VecN * out );
+
+// out( M ) = a( M x N ) * x( N )
+void MatrixVectorMultiply( const VecN * a, const int M, const int N, const VecN & x, VecN & out );
+
+// out( N ) = transpose( a( M x N ) ) * x( M )
+void MatrixTransposeVectorMultiply( const VecN * a, const int M, const int N, const VecN & x, VecN & out );
+
+// Upper limit on worker threads, zero means use every hardware thread and one disables threading
+void MatrixKernelsSetMaxThreads( const int maxThreads );
@@ -13,10 +13,10 @@
 class Quat {
 public:
 	Quat();	
-	Quat( const Quat & rhs );
+	Quat( const Quat & rhs ) = default;	// defaulted, so bodies can be copied as plain bytes
 	Quat( float X, float Y, float Z, float W );
 	Quat( Vec3 n, const float angleRadians );
-	const Quat & operator = ( const Quat & rhs );
+	Quat & operator = ( const Quat & rhs ) = default;
 	
 	Quat &	operator *= ( const float & rhs );
 	Quat &	operator *= ( const Quat & rhs );
@@ -49,13 +49,6 @@ z( 0 ),
 w( 1 ) {
 }
 
-inline Quat::Quat( const Quat &rhs ) :
-x( rhs.x ),
-y( rhs.y ),
-z( rhs.z ),
-w( rhs.w ) {
-}
-
 inline Quat::Quat( float X, float Y, float Z, float W ) :
 x( X ),
 y( Y ),
@@ -75,14 +68,6 @@ inline Quat::Quat( Vec3 n, const float angleRadians ) {
 	z = n.z * halfSine;
 }
 
-inline const Quat & Quat::operator = ( const Quat & rhs ) {
-	x = rhs.x;
-	y = rhs.y;
-	z = rhs.z;
-	w = rhs.w;
-	return *this;
-}
-
 inline Quat & Quat::operator *= ( const float & rhs ) {
     x *= rhs;
     y *= rhs;
@@ -192,10 +192,10 @@ class Vec3 {
 public:
 	Vec3();
 	Vec3( float value );
-	Vec3( const Vec3 & rhs );
+	Vec3( const Vec3 & rhs ) = default;	// defaulted, so bodies can be copied as plain bytes
 	Vec3( float X, float Y, float Z );
 	Vec3( const float * xyz );
-	Vec3 & operator = ( const Vec3 & rhs );
+	Vec3 & operator = ( const Vec3 & rhs ) = default;
 	Vec3 & operator = ( const float * rhs );
     
 	bool			operator == ( const Vec3 & rhs ) const;
@@ -242,12 +242,6 @@ y( value ),
 z( value ) {
 }
 
-inline Vec3::Vec3( const Vec3 &rhs ) :
-x( rhs.x ),
-y( rhs.y ),
-z( rhs.z ) {
-}
-
 inline Vec3::Vec3( float X, float Y, float Z ) :
 x( X ),
 y( Y ),
@@ -260,13 +254,6 @@ y( xyz[ 1 ] ),
 z( xyz[ 2 ] ) {
 }
 
-inline Vec3 & Vec3::operator = ( const Vec3 & rhs ) {
-	x = rhs.x;
-	y = rhs.y;
-	z = rhs.z;
-	return *this;
-}
-
 inline Vec3& Vec3::operator=( const float * rhs ) {
 	x = rhs[ 0 ];
 	y = rhs[ 1 ];
@@ -664,99 +651,218 @@ inline bool Vec4::IsValid() const {
 	return true;
 }
 
+/*
+ ================================
+ VecNExpr
+
+ Lazy element-wise expression over VecN.  Nothing is evaluated
+ until the expression is assigned to (or dotted with) a VecN, so a
+ chain like a + b * s - c runs as a single loop with no temporaries.
+ ================================
+ */
+template< typename E >
+class VecNExpr {
+public:
+	float	operator[] ( const int idx ) const { return static_cast< const E & >( *this )[ idx ]; }
+	int		Size() const { return static_cast< const E & >( *this ).Size(); }
+};
+
+class VecN;
+
+// Leaf vectors are held by reference, intermediate nodes by value,
+// so an expression never points at an expired temporary node.
+template< typename E > struct VecNOperand { typedef const E Type; };
+template<> struct VecNOperand< VecN > { typedef const VecN & Type; };
+
+template< typename L, typename R >
+class VecNSum : public VecNExpr< VecNSum< L, R > > {
+public:
+	VecNSum( const L & l, const R & r ) : lhs( l ), rhs( r ) { assert( l.Size() == r.Size() ); }
+	float	operator[] ( const int idx ) const { return lhs[ idx ] + rhs[ idx ]; }
+	int		Size() const { return lhs.Size(); }
+
+private:
+	typename VecNOperand< L >::Type lhs;
+	typename VecNOperand< R >::Type rhs;
+};
+
+template< typename L, typename R >
+class VecNDifference : public VecNExpr< VecNDifference< L, R > > {
+public:
+	VecNDifference( const L & l, const R & r ) : lhs( l ), rhs( r ) { assert( l.Size() == r.Size() ); }
+	float	operator[] ( const int idx ) const { return lhs[ idx ] - rhs[ idx ]; }
+	int		Size() const { return lhs.Size(); }
+
+private:
+	typename VecNOperand< L >::Type lhs;
+	typename VecNOperand< R >::Type rhs;
+};
+
+template< typename E >
+class VecNScaled : public VecNExpr< VecNScaled< E > > {
+public:
+	VecNScaled( const E & e, const float s ) : expr( e ), scale( s ) {}
+	float	operator[] ( const int idx ) const { return expr[ idx ] * scale; }
+	int		Size() const { return expr.Size(); }
+
+private:
+	typename VecNOperand< E >::Type expr;
+	float scale;
+};
+
+template< typename L, typename R >
+inline VecNSum< L, R > operator + ( const VecNExpr< L > & lhs, const VecNExpr< R > & rhs ) {
+	return VecNSum< L, R >( static_cast< const L & >( lhs ), static_cast< const R & >( rhs ) );
+}
+
+template< typename L, typename R >
+inline VecNDifference< L, R > operator - ( const VecNExpr< L > & lhs, const VecNExpr< R > & rhs ) {
+	return VecNDifference< L, R >( static_cast< const L & >( lhs ), static_cast< const R & >( rhs ) );
+}
+
+template< typename E >
+inline VecNScaled< E > operator * ( const VecNExpr< E > & lhs, const float rhs ) {
+	return VecNScaled< E >( static_cast< const E & >( lhs ), rhs );
+}
+
+template< typename E >
+inline VecNScaled< E > operator * ( const float lhs, const VecNExpr< E > & rhs ) {
+	return VecNScaled< E >( static_cast< const E & >( rhs ), lhs );
+}
+
 /*
  ================================
  VecN
+
+ Vectors of up to LOCAL_SIZE elements live inside the object,
+ larger ones are heap allocated.  Storage is reused whenever
+ the new size fits in the current capacity.
  ================================
  */
-class VecN {
+class VecN : public VecNExpr< VecN > {
 public:
-	VecN() : N( 0 ), data( NULL ) {}
+	VecN() : N( 0 ), data( localData ), capacity( LOCAL_SIZE ) {}
 	VecN( int _N );
 	VecN( const VecN & rhs );
+	VecN( VecN && rhs );
+	template< typename E > VecN( const VecNExpr< E > & rhs );
 	VecN & operator = ( const VecN & rhs );
-	~VecN() { delete[] data; }
+	VecN & operator = ( VecN && rhs );
+	template< typename E > VecN & operator = ( const VecNExpr< E > & rhs );
+	~VecN() { Free(); }
 
 	float			operator[] ( const int idx ) const { return data[ idx ]; }
 	float &			operator[] ( const int idx ) { return data[ idx ]; }
 	const VecN &	operator *= ( float rhs );
-	VecN			operator * ( float rhs ) const;
-	VecN			operator + ( const VecN & rhs ) const;
-	VecN			operator - ( const VecN & rhs ) const;
-	const VecN &	operator += ( const VecN & rhs );
-	const VecN &	operator -= ( const VecN & rhs );
+	template< typename E > const VecN & operator += ( const VecNExpr< E > & rhs );
+	template< typename E > const VecN & operator -= ( const VecNExpr< E > & rhs );
 
 	float Dot( const VecN & rhs ) const;
+	template< typename E > float Dot( const VecNExpr< E > & rhs ) const;
 	void Zero();
+	void Resize( int _N );
+	int Size() const { return N; }
 	
 public:
 	int		N;
 	float *	data;
+
+private:
+	void Free();
+
+	enum { LOCAL_SIZE = 16 };
+
+	int		capacity;
+	float	localData[ LOCAL_SIZE ];
 };
 
-inline VecN::VecN( int _N ) {
-	N = _N;
-	data = new float[ _N ];
+inline VecN::VecN( int _N ) : N( 0 ), data( localData ), capacity( LOCAL_SIZE ) {
+	Resize( _N );
 }
 
-inline VecN::VecN( const VecN & rhs ) {
-	N = rhs.N;
-	data = new float[ N ];
+inline VecN::VecN( const VecN & rhs ) : N( 0 ), data( localData ), capacity( LOCAL_SIZE ) {
+	Resize( rhs.N );
 	for ( int i = 0; i < N; i++ ) {
 		data[ i ] = rhs.data[ i ];
 	}
 }
 
+inline VecN::VecN( VecN && rhs ) : N( 0 ), data( localData ), capacity( LOCAL_SIZE ) {
+	*this = static_cast< VecN && >( rhs );
+}
+
+template< typename E >
+inline VecN::VecN( const VecNExpr< E > & rhs ) : N( 0 ), data( localData ), capacity( LOCAL_SIZE ) {
+	*this = rhs;
+}
+
 inline VecN & VecN::operator = ( const VecN & rhs ) {
-	delete[] data;
+	if ( this == &rhs ) {
+		return *this;
+	}
 
-	N = rhs.N;
-	data = new float[ N ];
+	Resize( rhs.N );
 	for ( int i = 0; i < N; i++ ) {
 		data[ i ] = rhs.data[ i ];
 	}
 	return *this;
 }
 
-inline const VecN & VecN::operator *= ( float rhs ) {
-	for ( int i = 0; i < N; i++ ) {
-		data[ i ] *= rhs;
+inline VecN & VecN::operator = ( VecN && rhs ) {
+	if ( this == &rhs ) {
+		return *this;
 	}
-	return *this;
-}
 
-inline VecN VecN::operator * ( float rhs ) const {
-	VecN tmp = *this;
-	tmp *= rhs;
-	return tmp;
+	if ( rhs.data == rhs.localData ) {
+		// Nothing to steal, the elements live inside rhs
+		*this = static_cast< const VecN & >( rhs );
+		return *this;
+	}
+
+	Free();
+	N = rhs.N;
+	data = rhs.data;
+	capacity = rhs.capacity;
+
+	rhs.N = 0;
+	rhs.data = rhs.localData;
+	rhs.capacity = LOCAL_SIZE;
+	return *this;
 }
 
-inline VecN VecN::operator + ( const VecN & rhs ) const {
-	VecN tmp = *this;
-	for ( int i = 0; i < N; i++ ) {
-		tmp.data[ i ] += rhs.data[ i ];
+template< typename E >
+inline VecN & VecN::operator = ( const VecNExpr< E > & rhs ) {
+	// Element i of an expression only reads element i of its operands,
+	// so evaluating in place is safe even when this vector is one of them.
+	const int size = rhs.Size();
+	Resize( size );
+	for ( int i = 0; i < size; i++ ) {
+		data[ i ] = rhs[ i ];
 	}
-	return tmp;
+	return *this;
 }
 
-inline VecN VecN::operator - ( const VecN & rhs ) const {
-	VecN tmp = *this;
+inline const VecN & VecN::operator *= ( float rhs ) {
 	for ( int i = 0; i < N; i++ ) {
-		tmp.data[ i ] -= rhs.data[ i ];
+		data[ i ] *= rhs;
 	}
-	return tmp;
+	return *this;
 }
 
-inline const VecN & VecN::operator += ( const VecN & rhs ) {
+template< typename E >
+inline const VecN & VecN::operator += ( const VecNExpr< E > & rhs ) {
+	assert( rhs.Size() == N );
 	for ( int i = 0; i < N; i++ ) {
-		data[ i ] += rhs.data[ i ];
+		data[ i ] += rhs[ i ];
 	}
 	return *this;
 }
 
-inline const VecN & VecN::operator -= ( const VecN & rhs ) {
+template< typename E >
+inline const VecN & VecN::operator -= ( const VecNExpr< E > & rhs ) {
+	assert( rhs.Size() == N );
 	for ( int i = 0; i < N; i++ ) {
-		data[ i ] -= rhs.data[ i ];
+		data[ i ] -= rhs[ i ];
 	}
 	return *this;
 }
@@ -769,8 +875,34 @@ inline float VecN::Dot( const VecN & rhs ) const {
 	return sum;
 }
 
+template< typename E >
+inline float VecN::Dot( const VecNExpr< E > & rhs ) const {
+	float sum = 0;
+	for ( int i = 0; i < N; i++ ) {
+		sum += data[ i ] * rhs[ i ];
+	}
+	return sum;
+}
+
 inline void VecN::Zero() {
 	for ( int i = 0; i < N; i++ ) {
 		data[ i ] = 0.0f;
 	}
-}
\ No newline at end of file
+}
+
+inline void VecN::Resize( int _N ) {
+	if ( _N > capacity ) {
+		Free();
+		data = new float[ _N ];
+		capacity = _N;
+	}
+	N = _N;
+}
+
+inline void VecN::Free() {
+	if ( data != localData ) {
+		delete[] data;
+	}
+	data = localData;
+	capacity = LOCAL_SIZE;
+}
@@ -3,7 +3,11 @@
 //
 #include "DeviceContext.h"
 #include "Fence.h"
+#include "../Fileio.h"
 #include <assert.h>
+#include <string.h>
+
+static const char * const PIPELINE_CACHE_FILE = "pipeline.cache";
 
 /*
 ================================================================================================
@@ -272,6 +276,12 @@ DeviceContext::Cleanup
 void DeviceContext::Cleanup() {
 	m_swapChain.Cleanup( this );
 
+	SavePipelineCache();
+	if ( VK_NULL_HANDLE != m_vkPipelineCache ) {
+		vkDestroyPipelineCache( m_vkDevice, m_vkPipelineCache, nullptr );
+		m_vkPipelineCache = VK_NULL_HANDLE;
+	}
+
 	// Destroy Command Buffers
 	vkFreeCommandBuffers( m_vkDevice, m_vkCommandPool, (uint32_t)m_vkCommandBuffers.size(), m_vkCommandBuffers.data() );
 	vkDestroyCommandPool( m_vkDevice, m_vkCommandPool, nullptr );
@@ -303,6 +313,12 @@ bool DeviceContext::CreateDevice() {
 		return false;
 	}
 
+	if ( !CreatePipelineCache() ) {
+		printf( "ERROR: Failed to create pipeline cache\n" );
+		assert( 0 );
+		return false;
+	}
+
 	return true;
 }
 
@@ -514,6 +530,110 @@ bool DeviceContext::CreateLogicalDevice() {
 	return true;
 }
 
+/*
+====================================================
+IsPipelineCacheCompatible
+Drivers are meant to reject data that isn't theirs, not all of them do
+====================================================
+*/
+static bool IsPipelineCacheCompatible( const unsigned char * data, const size_t size, const VkPhysicalDeviceProperties & properties ) {
+	// The header every driver starts its cache data with
+	uint32_t headerLength;
+	uint32_t headerVersion;
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint8_t pipelineCacheUUID[ VK_UUID_SIZE ];
+
+	if ( size < sizeof( uint32_t ) * 4 + VK_UUID_SIZE ) {
+		return false;
+	}
+	memcpy( &headerLength, data + 0, sizeof( uint32_t ) );
+	memcpy( &headerVersion, data + 4, sizeof( uint32_t ) );
+	memcpy( &vendorID, data + 8, sizeof( uint32_t ) );
+	memcpy( &deviceID, data + 12, sizeof( uint32_t ) );
+	memcpy( pipelineCacheUUID, data + 16, VK_UUID_SIZE );
+
+	if ( headerLength < sizeof( uint32_t ) * 4 + VK_UUID_SIZE || headerLength > size ) {
+		return false;
+	}
+	if ( VK_PIPELINE_CACHE_HEADER_VERSION_ONE != headerVersion ) {
+		return false;
+	}
+
+	// A new driver changes the UUID, its cache starts over
+	return vendorID == properties.vendorID && deviceID == properties.deviceID && 0 == memcmp( pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE );
+}
+
+/*
+====================================================
+DeviceContext::CreatePipelineCache
+Starts from the cache the last run saved, if this device and driver saved it
+====================================================
+*/
+bool DeviceContext::CreatePipelineCache() {
+	const VkPhysicalDeviceProperties & properties = m_physicalDevices[ m_deviceIndex ].m_vkDeviceProperties;
+
+	FileView file;
+	bool isCompatible = false;
+	if ( file.Open( PIPELINE_CACHE_FILE ) ) {
+		isCompatible = IsPipelineCacheCompatible( file.Data(), file.Size(), properties );
+		if ( !isCompatible ) {
+			printf( "Pipeline cache was saved by another device or driver, starting over\n" );
+		}
+	}
+
+	VkPipelineCacheCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	if ( isCompatible ) {
+		createInfo.initialDataSize = file.Size();
+		createInfo.pInitialData = file.Data();
+	}
+
+	m_vkPipelineCache = VK_NULL_HANDLE;
+	VkResult result = vkCreatePipelineCache( m_vkDevice, &createInfo, nullptr, &m_vkPipelineCache );
+	if ( VK_SUCCESS != result && isCompatible ) {
+		// The data is only a head start, an empty cache does too
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = NULL;
+		result = vkCreatePipelineCache( m_vkDevice, &createInfo, nullptr, &m_vkPipelineCache );
+	}
+	if ( VK_SUCCESS != result ) {
+		m_vkPipelineCache = VK_NULL_HANDLE;
+		return false;
+	}
+
+	if ( isCompatible ) {
+		printf( "Pipeline cache loaded: %i bytes\n", (int)file.Size() );
+	}
+	return true;
+}
+
+/*
+====================================================
+DeviceContext::SavePipelineCache
+====================================================
+*/
+void DeviceContext::SavePipelineCache() {
+	if ( VK_NULL_HANDLE == m_vkPipelineCache ) {
+		return;
+	}
+
+	size_t size = 0;
+	VkResult result = vkGetPipelineCacheData( m_vkDevice, m_vkPipelineCache, &size, NULL );
+	if ( VK_SUCCESS != result || 0 == size ) {
+		return;
+	}
+
+	std::vector< unsigned char > data( size );
+	result = vkGetPipelineCacheData( m_vkDevice, m_vkPipelineCache, &size, data.data() );
+	if ( VK_SUCCESS != result ) {
+		printf( "ERROR: Failed to get pipeline cache data\n" );
+		return;
+	}
+
+	SaveFileData( PIPELINE_CACHE_FILE, data.data(), (unsigned int)size );
+}
+
 /*
 ====================================================
 DeviceContext::FindMemoryType
@@ -76,6 +76,14 @@ public:
 
 	uint32_t FindMemoryTypeIndex( uint32_t typeFilter, VkMemoryPropertyFlags properties );
 
+	//
+	//	Pipeline cache, shared by every pipeline and kept on disk between runs
+	//
+	bool CreatePipelineCache();
+	void SavePipelineCache();
+
+	VkPipelineCache m_vkPipelineCache;
+
 	static const std::vector< const char * > m_deviceExtensions;
 	std::vector< const char * > m_validationLayers;
 
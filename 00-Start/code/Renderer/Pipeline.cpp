@@ -203,9 +203,7 @@ bool Pipeline::Create( DeviceContext * device, const CreateParms_t & parms ) {
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-	VkPipelineCache pipelineCache = VK_NULL_HANDLE;
-
-	result = vkCreateGraphicsPipelines( device->m_vkDevice, pipelineCache, 1, &pipelineInfo, nullptr, &m_vkPipeline );
+	result = vkCreateGraphicsPipelines( device->m_vkDevice, device->m_vkPipelineCache, 1, &pipelineInfo, nullptr, &m_vkPipeline );
 	if ( VK_SUCCESS != result ) {
 		printf( "ERROR: Failed to create pipeline\n" );
 		assert( 0 );
@@ -261,7 +259,7 @@ bool Pipeline::CreateCompute( DeviceContext * device, const CreateParms_t & parm
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;	
 	
 
-	result = vkCreateComputePipelines( device->m_vkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_vkPipeline );
+	result = vkCreateComputePipelines( device->m_vkDevice, device->m_vkPipelineCache, 1, &pipelineInfo, nullptr, &m_vkPipeline );
 	if ( VK_SUCCESS != result ) {
 		printf( "ERROR: Failed to create pipeline\n" );
 		assert( 0 );
@@ -342,10 +342,10 @@ void FillCubeTessellated(Model& model, int numDivisions) {
 
 /*
 ====================================================
-FillSphere
+SphereTessellation
 ====================================================
 */
-void FillSphere(Model& model, const float radius) {
+int SphereTessellation(const float radius) {
 	float t = radius;
 	if (t < 0.0f) {
 		t = 0.0f;
@@ -357,7 +357,16 @@ void FillSphere(Model& model, const float radius) {
 	float min = 5;
 	float max = 30;
 	float s = min * (1.0f - t) + max * t;
-	FillCubeTessellated(model, (int)s);
+	return (int)s;
+}
+
+/*
+====================================================
+FillSphere
+====================================================
+*/
+void FillSphere(Model& model, const float radius) {
+	FillCubeTessellated(model, SphereTessellation(radius));
 
 	// Project the tessellated cube onto a sphere
 	for (int i = 0; i < model.m_vertices.size(); i++) {
@@ -407,8 +416,6 @@ bool Model::BuildFromShape(const Shape* shape) {
 			}
 		}
 	}
-
-	/*
 	else if (shape->GetType() == Shape::ShapeType::SHAPE_BOX) {
 		const ShapeBox* shapeBox = (const ShapeBox*)shape;
 
@@ -416,25 +423,43 @@ bool Model::BuildFromShape(const Shape* shape) {
 		m_indices.clear();
 
 		FillCubeTessellated(*this, 0);
-		Vec3 halfdim = (shapeBox->m_bounds.maxs - shapeBox->m_bounds.mins) * 0.5f;
-		Vec3 center = (shapeBox->m_bounds.maxs + shapeBox->m_bounds.mins) * 0.5f;
+		const Vec3 halfdim = shapeBox->halfExtents;
 		for (int v = 0; v < m_vertices.size(); v++) {
 			for (int i = 0; i < 3; i++) {
 				m_vertices[v].xyz[i] *= halfdim[i];
-				m_vertices[v].xyz[i] += center[i];
 			}
 		}
 	}
+	else if (shape->GetType() == Shape::ShapeType::SHAPE_CAPSULE) {
+		const ShapeCapsule* shapeCapsule = (const ShapeCapsule*)shape;
+
+		m_vertices.clear();
+		m_indices.clear();
+
+		// A sphere pulled apart at its equator, the stretched band is the cylinder
+		FillSphere(*this, shapeCapsule->radius);
+		for (int v = 0; v < m_vertices.size(); v++) {
+			for (int i = 0; i < 3; i++) {
+				m_vertices[v].xyz[i] *= shapeCapsule->radius;
+			}
+			if (m_vertices[v].xyz[2] > 0.0f) {
+				m_vertices[v].xyz[2] += shapeCapsule->halfHeight;
+			}
+			else if (m_vertices[v].xyz[2] < 0.0f) {
+				m_vertices[v].xyz[2] -= shapeCapsule->halfHeight;
+			}
+		}
+	}
+
 	else if (shape->GetType() == Shape::ShapeType::SHAPE_CONVEX) {
 		const ShapeConvex* shapeConvex = (const ShapeConvex*)shape;
 
 		m_vertices.clear();
 		m_indices.clear();
 
-		// Build the connected convex hull from the points
-		std::vector< Vec3 > hullPts;
-		std::vector< tri_t > hullTris;
-		BuildConvexHull(shapeConvex->m_points, hullPts, hullTris);
+		// The shape already holds the connected hull of its points
+		const std::vector< Vec3 >& hullPts = shapeConvex->points;
+		const std::vector< tri_t >& hullTris = shapeConvex->triangles;
 
 		// Calculate smoothed normals
 		std::vector< Vec3 > normals;
@@ -488,7 +513,144 @@ bool Model::BuildFromShape(const Shape* shape) {
 			m_indices.push_back(hullTris[i].c);
 		}
 	}
-		*/
+
+	else if (shape->GetType() == Shape::ShapeType::SHAPE_MESH) {
+		const ShapeMesh* shapeMesh = (const ShapeMesh*)shape;
+
+		m_vertices.clear();
+		m_indices.clear();
+
+		const std::vector< Vec3 >& meshPts = shapeMesh->vertices;
+		const std::vector< tri_t >& meshTris = shapeMesh->triangles;
+
+		// Calculate smoothed normals, area weighted, in a single pass over the triangles
+		std::vector< Vec3 > normals(meshPts.size(), Vec3(0.0f));
+		for (int t = 0; t < meshTris.size(); t++) {
+			const tri_t& tri = meshTris[t];
+
+			const Vec3& a = meshPts[tri.a];
+			const Vec3& b = meshPts[tri.b];
+			const Vec3& c = meshPts[tri.c];
+
+			const Vec3 norm = (b - a).Cross(c - a);
+			normals[tri.a] += norm;
+			normals[tri.b] += norm;
+			normals[tri.c] += norm;
+		}
+
+		m_vertices.reserve(meshPts.size());
+		for (int i = 0; i < meshPts.size(); i++) {
+			vert_t vert;
+			memset(&vert, 0, sizeof(vert_t));
+
+			vert.xyz[0] = meshPts[i].x;
+			vert.xyz[1] = meshPts[i].y;
+			vert.xyz[2] = meshPts[i].z;
+
+			Vec3 norm = normals[i];
+			norm.Normalize();
+
+			vert.norm[0] = FloatToByte_n11(norm[0]);
+			vert.norm[1] = FloatToByte_n11(norm[1]);
+			vert.norm[2] = FloatToByte_n11(norm[2]);
+			vert.norm[3] = FloatToByte_n11(0.0f);
+
+			m_vertices.push_back(vert);
+		}
+
+		m_indices.reserve(meshTris.size() * 3);
+		for (int i = 0; i < meshTris.size(); i++) {
+			m_indices.push_back(meshTris[i].a);
+			m_indices.push_back(meshTris[i].b);
+			m_indices.push_back(meshTris[i].c);
+		}
+	}
+
+	else if (shape->GetType() == Shape::ShapeType::SHAPE_HEIGHTFIELD) {
+		const ShapeHeightfield* shapeHeightfield = (const ShapeHeightfield*)shape;
+		const HeightfieldGrid& grid = shapeHeightfield->grid;
+
+		m_vertices.clear();
+		m_indices.clear();
+
+		const int numX = grid.NumX();
+		const int numY = grid.NumY();
+
+		// Normals from the central differences of the heights
+		m_vertices.reserve(numX * numY);
+		for (int j = 0; j < numY; j++) {
+			for (int i = 0; i < numX; i++) {
+				const Vec3 pt = grid.GetPoint(i, j);
+				const Vec3 dx = grid.GetPoint(i < numX - 1 ? i + 1 : i, j) - grid.GetPoint(i > 0 ? i - 1 : i, j);
+				const Vec3 dy = grid.GetPoint(i, j < numY - 1 ? j + 1 : j) - grid.GetPoint(i, j > 0 ? j - 1 : j);
+
+				Vec3 norm = dx.Cross(dy);
+				norm.Normalize();
+
+				vert_t vert;
+				memset(&vert, 0, sizeof(vert_t));
+
+				vert.xyz[0] = pt.x;
+				vert.xyz[1] = pt.y;
+				vert.xyz[2] = pt.z;
+
+				vert.norm[0] = FloatToByte_n11(norm[0]);
+				vert.norm[1] = FloatToByte_n11(norm[1]);
+				vert.norm[2] = FloatToByte_n11(norm[2]);
+				vert.norm[3] = FloatToByte_n11(0.0f);
+
+				m_vertices.push_back(vert);
+			}
+		}
+
+		// Same split of the cells as the collision triangles
+		m_indices.reserve((numX - 1) * (numY - 1) * 6);
+		for (int j = 0; j < numY - 1; j++) {
+			for (int i = 0; i < numX - 1; i++) {
+				const unsigned int v00 = j * numX + i;
+				const unsigned int v10 = v00 + 1;
+				const unsigned int v01 = v00 + numX;
+				const unsigned int v11 = v01 + 1;
+
+				m_indices.push_back(v00);
+				m_indices.push_back(v10);
+				m_indices.push_back(v11);
+
+				m_indices.push_back(v00);
+				m_indices.push_back(v11);
+				m_indices.push_back(v01);
+			}
+		}
+	}
+	else if (shape->GetType() == Shape::ShapeType::SHAPE_COMPOUND) {
+		const ShapeCompound* shapeCompound = (const ShapeCompound*)shape;
+
+		m_vertices.clear();
+		m_indices.clear();
+
+		// The model of every child, moved to its place in the compound
+		for (int c = 0; c < shapeCompound->children.size(); c++) {
+			const CompoundChild& child = shapeCompound->children[c];
+
+			Model childModel;
+			childModel.BuildFromShape(child.shape);
+
+			const unsigned int firstVertex = (unsigned int)m_vertices.size();
+			for (int v = 0; v < childModel.m_vertices.size(); v++) {
+				vert_t vert = childModel.m_vertices[v];
+
+				const Vec3 xyz = child.orientation.RotatePoint(Vec3(vert.xyz[0], vert.xyz[1], vert.xyz[2])) + child.position;
+				Vec3ToFloat3(xyz, vert.xyz);
+				Vec3ToByte4(child.orientation.RotatePoint(Byte4ToVec3(vert.norm)), vert.norm);
+				Vec3ToByte4(child.orientation.RotatePoint(Byte4ToVec3(vert.tang)), vert.tang);
+
+				m_vertices.push_back(vert);
+			}
+			for (int i = 0; i < childModel.m_indices.size(); i++) {
+				m_indices.push_back(childModel.m_indices[i] + firstVertex);
+			}
+		}
+	}
 	return true;
 
 	}
@@ -551,4 +713,104 @@ bool Model::BuildFromShape(const Shape* shape) {
 
 		// Issue draw command
 		vkCmdDrawIndexed(vkCommandBUffer, (uint32_t)m_indices.size(), 1, 0, 0, 0);
-	}
\ No newline at end of file
+	}
+
+/*
+====================================================
+MeshCache::Key_t::operator ==
+====================================================
+*/
+bool MeshCache::Key_t::operator == (const Key_t& rhs) const {
+	return type == rhs.type && tessellation == rhs.tessellation && shape == rhs.shape
+		&& size[0] == rhs.size[0] && size[1] == rhs.size[1] && size[2] == rhs.size[2];
+}
+
+/*
+====================================================
+MeshCache::KeyHash_t::operator()
+====================================================
+*/
+size_t MeshCache::KeyHash_t::operator()(const Key_t& key) const {
+	uint32_t words[5];
+	words[0] = (uint32_t)key.type;
+	words[1] = (uint32_t)key.tessellation;
+	memcpy(&words[2], key.size, sizeof(key.size));
+
+	size_t hash = std::hash<const Shape*>()(key.shape);
+	for (int i = 0; i < 5; i++) {
+		hash ^= std::hash<uint32_t>()(words[i]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
+/*
+====================================================
+MeshCache::MakeKey
+====================================================
+*/
+MeshCache::Key_t MeshCache::MakeKey(const Shape* shape) {
+	Key_t key;
+	memset(&key, 0, sizeof(key));
+	key.type = (int)shape->GetType();
+
+	// Sizes are what BuildFromShape scales the unit meshes by
+	if (shape->GetType() == Shape::ShapeType::SHAPE_SPHERE) {
+		const ShapeSphere* shapeSphere = (const ShapeSphere*)shape;
+		key.tessellation = SphereTessellation(shapeSphere->radius);
+		key.size[0] = shapeSphere->radius;
+	}
+	else if (shape->GetType() == Shape::ShapeType::SHAPE_BOX) {
+		const ShapeBox* shapeBox = (const ShapeBox*)shape;
+		key.tessellation = 1;
+		key.size[0] = shapeBox->halfExtents.x;
+		key.size[1] = shapeBox->halfExtents.y;
+		key.size[2] = shapeBox->halfExtents.z;
+	}
+	else if (shape->GetType() == Shape::ShapeType::SHAPE_CAPSULE) {
+		const ShapeCapsule* shapeCapsule = (const ShapeCapsule*)shape;
+		key.tessellation = SphereTessellation(shapeCapsule->radius);
+		key.size[0] = shapeCapsule->radius;
+		key.size[1] = shapeCapsule->halfHeight;
+	}
+	else {
+		key.shape = shape;
+	}
+	return key;
+}
+
+/*
+====================================================
+MeshCache::GetModel
+====================================================
+*/
+Model* MeshCache::GetModel(DeviceContext* device, const Shape* shape) {
+	if (NULL == shape) {
+		return NULL;
+	}
+
+	const Key_t key = MakeKey(shape);
+	auto it = m_models.find(key);
+	if (it != m_models.end()) {
+		return it->second;
+	}
+
+	Model* model = new Model();
+	model->BuildFromShape(shape);
+	model->MakeVBO(device);
+
+	m_models[key] = model;
+	return model;
+}
+
+/*
+====================================================
+MeshCache::Cleanup
+====================================================
+*/
+void MeshCache::Cleanup(DeviceContext& deviceContext) {
+	for (auto it = m_models.begin(); it != m_models.end(); it++) {
+		it->second->Cleanup(deviceContext);
+		delete it->second;
+	}
+	m_models.clear();
+}
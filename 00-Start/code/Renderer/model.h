@@ -5,6 +5,7 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <array>
+#include <unordered_map>
 #include "DeviceContext.h"
 #include "Buffer.h"
 #include "../Math/Vector.h"
@@ -95,6 +96,47 @@ public:
 void FillCube( Model & model );
 void FillFullScreenQuad( Model & model );
 
+// Divisions per cube face of the sphere FillSphere builds for the radius
+int SphereTessellation( const float radius );
+
+/*
+====================================================
+MeshCache
+
+Bodies with the same shape draw from the same buffers.
+Spheres, boxes and capsules are keyed by their type,
+tessellation level and size, so equal ones share even
+when they are different Shapes.  Every other shape is
+keyed by the shape itself, the registry already hands
+out one shape per distinct set of points.
+====================================================
+*/
+class MeshCache {
+public:
+	// Built and uploaded the first time it's asked for
+	Model * GetModel( DeviceContext * device, const Shape * shape );
+	void Cleanup( DeviceContext & deviceContext );
+
+	int NumModels() const { return (int)m_models.size(); }
+
+private:
+	struct Key_t {
+		int type;
+		int tessellation;
+		float size[ 3 ];
+		const Shape * shape;	// only for the shapes built from their own points
+
+		bool operator == ( const Key_t & rhs ) const;
+	};
+	struct KeyHash_t {
+		size_t operator()( const Key_t & key ) const;
+	};
+
+	static Key_t MakeKey( const Shape * shape );
+
+	std::unordered_map< Key_t, Model *, KeyHash_t > m_models;
+};
+
 
 
 
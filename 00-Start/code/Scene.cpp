@@ -6,6 +6,10 @@
 #include "../Intersections.h"
 #include "../Contact.h"
 #include "../Broadphase.h"
+#include "SceneFile.h"
+#include <algorithm>
+#include <string.h>
+#include <type_traits>
 
 
 /*
@@ -22,10 +26,11 @@ Scene::~Scene
 ====================================================
 */
 Scene::~Scene() {
-	for ( int i = 0; i < bodies.size(); i++ ) {
-		delete bodies[ i ].shape;
-	}
 	bodies.clear();
+	previousPoses.clear();
+	shapes.Clear();
+	contactCache.Clear();
+	gjkCache.Clear();
 }
 
 /*
@@ -34,20 +39,78 @@ Scene::Reset
 ====================================================
 */
 void Scene::Reset() {
-	for ( int i = 0; i < bodies.size(); i++ ) {
-		delete bodies[ i ].shape;
-	}
 	bodies.clear();
+	previousPoses.clear();
+	shapes.Clear();
+	contactCache.Clear();
+	gjkCache.Clear();
 
 	Initialize();
 }
 
+/*
+====================================================
+BuildGround
+
+Terrain mesh shaped like the union of the nine large
+spheres the scene stood on before meshes existed
+====================================================
+*/
+static const ShapeMesh * BuildGround( ShapeRegistry & shapes ) {
+	const int numCells = 128;
+	const float size = 160.0f;
+	const float radius = 80.0f;
+
+	std::vector< Vec3 > verts;
+	verts.reserve( ( numCells + 1 ) * ( numCells + 1 ) );
+	for ( int i = 0; i <= numCells; ++i ) {
+		for ( int j = 0; j <= numCells; ++j ) {
+			const float x = ( (float)i / numCells - 0.5f ) * size;
+			const float y = ( (float)j / numCells - 0.5f ) * size;
+
+			// Highest of the sphere caps above this point
+			float z = -radius;
+			for ( int k = 0; k < 9; ++k ) {
+				const float dx = x - ( k / 3 - 1 ) * radius * 0.25f;
+				const float dy = y - ( k % 3 - 1 ) * radius * 0.25f;
+				const float distSqr = dx * dx + dy * dy;
+				if ( distSqr < radius * radius ) {
+					z = fmaxf( z, sqrtf( radius * radius - distSqr ) - radius );
+				}
+			}
+
+			verts.push_back( Vec3( x, y, z ) );
+		}
+	}
+
+	// Two triangles per cell, counter clockwise seen from above
+	std::vector< tri_t > tris;
+	tris.reserve( numCells * numCells * 2 );
+	for ( int i = 0; i < numCells; ++i ) {
+		for ( int j = 0; j < numCells; ++j ) {
+			const int v00 = i * ( numCells + 1 ) + j;
+			const int v10 = v00 + numCells + 1;
+			const int v01 = v00 + 1;
+			const int v11 = v10 + 1;
+
+			tris.push_back( { v00, v10, v11 } );
+			tris.push_back( { v00, v11, v01 } );
+		}
+	}
+
+	return shapes.GetMesh( verts.data(), (int)verts.size(), tris.data(), (int)tris.size() );
+}
+
 /*
 ====================================================
 Scene::Initialize
 ====================================================
 */
 void Scene::Initialize() {
+	if ( !sceneFile.empty() && LoadSceneFile( sceneFile.c_str(), *this ) ) {
+		return;
+	}
+
 	/* Previous test scene 
 	// -- BODIES --
 	// Ball
@@ -109,7 +172,7 @@ void Scene::Initialize() {
 			float y = (j - 1) * radius * 1.5f;
 			body.position = Vec3(x, y, 10);
 			body.orientation = Quat(0, 0, 0, 1);
-			body.shape = new ShapeSphere(radius);
+			body.shape = shapes.GetSphere(radius);
 			body.inverseMass = 1.0f;
 			body.elasticity = 0.5f;
 			body.friction = 0.5f;
@@ -118,23 +181,27 @@ void Scene::Initialize() {
 		}
 	}
 
-	for (int i = 0; i < 3; ++i)
-	{
-		for (int j = 0; j < 3; ++j)
-		{
-			float radius = 80.0f;
-			float x = (i - 1) * radius * 0.25f;
-			float y = (j - 1) * radius * 0.25f;
-			body.position = Vec3(x, y, -radius);
-			body.orientation = Quat(0, 0, 0, 1);
-			body.shape = new ShapeSphere(radius);
-			body.inverseMass = 0.0f;
-			body.elasticity = 0.99f;
-			body.friction = 0.5f;
-			bodies.push_back(body);
-		}
-	}
+	// -- GROUND --
+	body.position = Vec3(0, 0, 0);
+	body.orientation = Quat(0, 0, 0, 1);
+	body.shape = BuildGround(shapes);
+	body.inverseMass = 0.0f;
+	body.elasticity = 0.99f;
+	body.friction = 0.5f;
+	body.linearVelocity.Zero();
+	bodies.push_back(body);
+}
+
+/*
+====================================================
+IsSpherePair
 
+Spheres touch at a single point, one impulse at a time
+resolves them without the manifold solver
+====================================================
+*/
+static bool IsSpherePair( const Contact & contact ) {
+	return contact.a->shape->GetType() == Shape::ShapeType::SHAPE_SPHERE && contact.b->shape->GetType() == Shape::ShapeType::SHAPE_SPHERE;
 }
 
 /*
@@ -143,6 +210,14 @@ Scene::Update
 ====================================================
 */
 void Scene::Update( const float dt_sec ) {
+	// Keep the state this step starts from, drawing blends from it to the one it ends with
+	previousPoses.resize(bodies.size());
+	for (int i = 0; i < bodies.size(); i++)
+	{
+		previousPoses[i].position = bodies[i].position;
+		previousPoses[i].orientation = bodies[i].orientation;
+	}
+
 	// -- GRAVITY --
 	for (int i = 0; i < bodies.size(); i++) 
 	{
@@ -162,34 +237,55 @@ void Scene::Update( const float dt_sec ) {
 	BroadPhase(bodies.data(), bodies.size(), collisionPairs, dt_sec);
 
 	//v Collisions check (narrow phase) ==============================
-	int numContacts = 0;
-	const int maxContacts = bodies.size() * bodies.size();
-	Contact* contacts = (Contact*)_malloca(sizeof(Contact) * maxContacts);
-
+	// Ignore collisions for bodies with infinite mass
+	int numPairs = 0;
 	for (int i = 0; i < collisionPairs.size(); ++i)
 	{
 		const CollisionPair& pair = collisionPairs[i];
-		Body& bodyA = bodies[pair.a];
-		Body& bodyB = bodies[pair.b];
-
-		// Ignore collisions for bodies with infinite mass
-		if (bodyA.inverseMass == 0.0f && bodyB.inverseMass == 0.0f) continue;
+		if (bodies[pair.a].inverseMass == 0.0f && bodies[pair.b].inverseMass == 0.0f) continue;
 
-		Contact contact;
-		if (Intersections::Intersect(bodyA, bodyB, dt_sec, contact)) {
-			contacts[numContacts] = contact;
-			++numContacts;
-		}
+		collisionPairs[numPairs] = pair;
+		++numPairs;
 	}
 
-	// Sort times of impact
+	// Every pair is dispatched to the kernel registered for its shape types
+	const int maxContacts = numPairs * Intersections::MAX_CONTACTS_PER_PAIR;
+	std::vector<Contact> contactBuffer(maxContacts);
+	Contact* contacts = contactBuffer.data();
+	gjkCache.NextFrame();
+	NarrowphaseContext narrowphase;
+	narrowphase.scratch = &narrowphaseScratch;
+	narrowphase.gjkCache = &gjkCache;
+	narrowphase.meshQueryStats = &meshQueryStats;
+	const int numContacts = Intersections::IntersectPairs(narrowphase, bodies.data(), collisionPairs.data(), numPairs, dt_sec, contacts, maxContacts);
+
+	// Sort times of impact. Most contacts share a time of 0, a stable sort keeps those
+	// in pair order so the solver always sees them in the same order.
 	if (numContacts > 1) {
-		qsort(contacts, numContacts, sizeof(Contact), Contact::CompareContact);
+		std::stable_sort(contacts, contacts + numContacts, [](const Contact& lhs, const Contact& rhs) {
+			return Contact::CompareContact(&lhs, &rhs) < 0;
+		});
+	}
+
+	// Contacts that already touch sort first. Those of boxes and the other shapes that touch
+	// at several points are resolved together, sphere pairs stay with the contacts below.
+	int numResting = 0;
+	while (numResting < numContacts && contacts[numResting].timeOfImpact == 0.0f) {
+		++numResting;
+	}
+	const int numManifold = (int)(std::stable_partition(contacts, contacts + numResting, [](const Contact& contact) {
+		return !IsSpherePair(contact);
+	}) - contacts);
+	if (numManifold > 0) {
+		Contact::ResolveContacts(contacts, numManifold, &contactCache);
+	}
+	else {
+		contactCache.Clear();
 	}
 
 	// Contact resolve in order
 	float accumulatedTime = 0.0f;
-	for (int i = 0; i < numContacts; ++i)
+	for (int i = numManifold; i < numContacts; ++i)
 	{
 		Contact& contact = contacts[i];
 		const float dt = contact.timeOfImpact - accumulatedTime;
@@ -220,4 +316,164 @@ void Scene::Update( const float dt_sec ) {
 		}
 	}
 
-}
\ No newline at end of file
+}
+/*
+====================================================
+Scene::GetInterpolatedPose
+====================================================
+*/
+void Scene::GetInterpolatedPose( const int i, const float alpha, Vec3 & position, Quat & orientation ) const {
+	const Body & body = bodies[ i ];
+	if ( i >= previousPoses.size() ) {
+		// Added since the last step
+		position = body.position;
+		orientation = body.orientation;
+		return;
+	}
+
+	const BodyPose & previous = previousPoses[ i ];
+	position = previous.position + ( body.position - previous.position ) * alpha;
+
+	// Normalized lerp, through the shorter arc: q and -q are the same rotation
+	Quat to = body.orientation;
+	const float dot = previous.orientation.x * to.x + previous.orientation.y * to.y + previous.orientation.z * to.z + previous.orientation.w * to.w;
+	if ( dot < 0.0f ) {
+		to *= -1.0f;
+	}
+	orientation.x = previous.orientation.x + ( to.x - previous.orientation.x ) * alpha;
+	orientation.y = previous.orientation.y + ( to.y - previous.orientation.y ) * alpha;
+	orientation.z = previous.orientation.z + ( to.z - previous.orientation.z ) * alpha;
+	orientation.w = previous.orientation.w + ( to.w - previous.orientation.w ) * alpha;
+	orientation.Normalize();
+}
+
+/*
+====================================================
+HashFloats
+
+FNV-1a over 32 bit words rather than bytes, floats
+are taken bit for bit so even -0 and 0 differ
+====================================================
+*/
+static uint64_t HashFloats( uint64_t hash, const float * values, const int num ) {
+	for ( int i = 0; i < num; i++ ) {
+		uint32_t bits;
+		memcpy( &bits, &values[ i ], sizeof( bits ) );
+		hash = ( hash ^ bits ) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+/*
+====================================================
+Scene::HashState
+====================================================
+*/
+uint64_t Scene::HashState() const {
+	uint64_t hash = 14695981039346656037ULL;
+	for ( int i = 0; i < bodies.size(); i++ ) {
+		const Body & body = bodies[ i ];
+		const float state[ 13 ] = {
+			body.position.x, body.position.y, body.position.z,
+			body.orientation.x, body.orientation.y, body.orientation.z, body.orientation.w,
+			body.linearVelocity.x, body.linearVelocity.y, body.linearVelocity.z,
+			body.angularVelocity.x, body.angularVelocity.y, body.angularVelocity.z,
+		};
+		hash = HashFloats( hash, state, 13 );
+	}
+	return hash;
+}
+
+/*
+====================================================
+SnapshotLayout
+
+Offsets of every array of a snapshot, each aligned for
+its type so the arrays can be used where they sit
+====================================================
+*/
+// Everything a snapshot holds is copied in and out as bytes
+static_assert( std::is_trivially_copyable< Body >::value, "bodies are copied into snapshots as bytes" );
+static_assert( std::is_trivially_copyable< Scene::BodyPose >::value, "poses are copied into snapshots as bytes" );
+static_assert( std::is_trivially_copyable< ContactCache::SavedEntry >::value, "contact entries are copied into snapshots as bytes" );
+static_assert( std::is_trivially_copyable< GJKCache::SavedEntry >::value, "GJK entries are copied into snapshots as bytes" );
+
+struct SnapshotLayout {
+	size_t bodies;
+	size_t poses;
+	size_t contactEntries;
+	size_t gjkEntries;
+	size_t numBytes;
+};
+
+static size_t AlignUp( const size_t offset, const size_t alignment ) {
+	return ( offset + alignment - 1 ) / alignment * alignment;
+}
+
+static SnapshotLayout GetSnapshotLayout( const SceneSnapshot::Header & header ) {
+	SnapshotLayout layout;
+	layout.bodies = AlignUp( sizeof( SceneSnapshot::Header ), alignof( Body ) );
+	layout.poses = AlignUp( layout.bodies + header.numBodies * sizeof( Body ), alignof( Scene::BodyPose ) );
+	layout.contactEntries = AlignUp( layout.poses + header.numPoses * sizeof( Scene::BodyPose ), alignof( ContactCache::SavedEntry ) );
+	layout.gjkEntries = AlignUp( layout.contactEntries + header.numContactEntries * sizeof( ContactCache::SavedEntry ), alignof( GJKCache::SavedEntry ) );
+	layout.numBytes = layout.gjkEntries + header.numGJKEntries * sizeof( GJKCache::SavedEntry );
+	return layout;
+}
+
+/*
+====================================================
+Scene::SaveSnapshot
+====================================================
+*/
+void Scene::SaveSnapshot( SceneSnapshot & snapshot ) const {
+	SceneSnapshot::Header header;
+	header.shapeGeneration = shapes.Generation();
+	header.numBodies = (int)bodies.size();
+	header.numPoses = (int)previousPoses.size();
+	header.numContactEntries = contactCache.Size();
+	header.numGJKEntries = gjkCache.Size();
+	header.gjkFrame = gjkCache.GetFrame();
+
+	const SnapshotLayout layout = GetSnapshotLayout( header );
+	snapshot.data.resize( layout.numBytes );
+	uint8_t * data = snapshot.data.data();
+
+	// Bodies and poses are plain data, the caches translate their body pointers on the way
+	memcpy( data, &header, sizeof( header ) );
+	memcpy( data + layout.bodies, bodies.data(), header.numBodies * sizeof( Body ) );
+	memcpy( data + layout.poses, previousPoses.data(), header.numPoses * sizeof( BodyPose ) );
+	contactCache.Save( bodies.data(), (ContactCache::SavedEntry *)( data + layout.contactEntries ) );
+	gjkCache.Save( bodies.data(), (GJKCache::SavedEntry *)( data + layout.gjkEntries ) );
+}
+
+/*
+====================================================
+Scene::RestoreSnapshot
+====================================================
+*/
+bool Scene::RestoreSnapshot( const SceneSnapshot & snapshot ) {
+	const SceneSnapshot::Header * header = snapshot.GetHeader();
+	if ( NULL == header || header->shapeGeneration != shapes.Generation() ) {
+		return false;
+	}
+	if ( header->numBodies < 0 || header->numPoses < 0 || header->numContactEntries < 0 || header->numGJKEntries < 0 ) {
+		return false;
+	}
+
+	// A truncated snapshot would have the arrays run off its end
+	const SnapshotLayout layout = GetSnapshotLayout( *header );
+	if ( snapshot.NumBytes() < layout.numBytes ) {
+		return false;
+	}
+	const uint8_t * data = snapshot.data.data();
+
+	bodies.resize( header->numBodies );
+	memcpy( bodies.data(), data + layout.bodies, header->numBodies * sizeof( Body ) );
+	previousPoses.resize( header->numPoses );
+	memcpy( previousPoses.data(), data + layout.poses, header->numPoses * sizeof( BodyPose ) );
+
+	// After the bodies, the caches point into wherever they now live
+	contactCache.Restore( bodies.data(), (const ContactCache::SavedEntry *)( data + layout.contactEntries ), header->numContactEntries );
+	gjkCache.Restore( bodies.data(), (const GJKCache::SavedEntry *)( data + layout.gjkEntries ), header->numGJKEntries, header->gjkFrame );
+	return true;
+}
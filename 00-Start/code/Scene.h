@@ -2,9 +2,46 @@
 //  Scene.h
 //
 #pragma once
+#include <stdint.h>
+#include <string>
 #include <vector>
 
 #include "../Body.h"
+#include "../ShapeRegistry.h"
+#include "../Contact.h"
+#include "../GJK.h"
+#include "../Intersections.h"
+
+/*
+====================================================
+SceneSnapshot
+
+Everything Scene::Update carries from one step to the
+next, packed back to back in one buffer: a header, the
+bodies, their previous poses, then the contact and GJK
+caches with bodies as indices.  Shapes are referenced,
+not copied, so a snapshot only restores into the scene
+it was taken from, until that scene is reset.
+====================================================
+*/
+class SceneSnapshot {
+public:
+	struct Header {
+		int shapeGeneration;
+		int numBodies;
+		int numPoses;
+		int numContactEntries;
+		int numGJKEntries;
+		int gjkFrame;
+	};
+
+	// NULL when there isn't even a whole header
+	const Header * GetHeader() const { return ( data.size() < sizeof( Header ) ) ? NULL : (const Header *)data.data(); }
+	size_t NumBytes() const { return data.size(); }
+
+	// Kept between saves so taking a snapshot every step doesn't allocate
+	std::vector< uint8_t > data;
+};
 
 /*
 ====================================================
@@ -18,11 +55,52 @@ public:
 
 	void Reset();
 	void Initialize();
+
+	// Initialize loads the bodies from this scene file instead of building the default scene
+	void SetSceneFile( const char * fileName ) { sceneFile = fileName; }
 	void Update( const float dt_sec );	
 
+	// Pose of body i a fraction alpha of the way from where the last Update found it to where it left it,
+	// for drawing at another rate than physics steps
+	void GetInterpolatedPose( const int i, const float alpha, Vec3 & position, Quat & orientation ) const;
+
+	// 64 bit hash of the exact bits of every body's position, orientation and velocities.
+	// Two runs fed the same steps agree on it step for step until they diverge.
+	uint64_t HashState() const;
+
+	// Copy of the whole state Update works from, restoring it puts the scene back exactly,
+	// caches included, so the steps after it come out the same again.
+	// Restore fails on a snapshot taken before the scene was last reset.
+	void SaveSnapshot( SceneSnapshot & snapshot ) const;
+	bool RestoreSnapshot( const SceneSnapshot & snapshot );
+
 	std::vector<Body> bodies;
 
+	// Where every body was before the last Update
+	struct BodyPose {
+		Vec3 position;
+		Quat orientation;
+	};
+	std::vector<BodyPose> previousPoses;
+
+	// Owns every shape used by the bodies
+	ShapeRegistry shapes;
+
+	// Resting contact impulses of the last update
+	ContactCache contactCache;
+
+	// GJK simplex of every convex pair tested last update
+	GJKCache gjkCache;
+
+	// Lists the narrowphase works in during an update
+	NarrowphaseScratch narrowphaseScratch;
+
+	// BVH and heightfield pyramid work done by the mesh kernels, never reset by the scene
+	BVHQueryStats meshQueryStats;
+
 private:
 	const float GRAVITY_AMOUNT{ 10.0f };
+
+	std::string sceneFile;
 };
 
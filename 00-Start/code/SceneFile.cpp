@@ -0,0 +1,541 @@
+//
+//	SceneFile.cpp
+//
+#include "SceneFile.h"
+#include "Scene.h"
+#include "Fileio.h"
+#include "../Shape.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+/*
+====================================================
+IsLittleEndian
+====================================================
+*/
+static bool IsLittleEndian() {
+	const uint32_t one = 1;
+	unsigned char firstByte;
+	memcpy( &firstByte, &one, 1 );
+	return 1 == firstByte;
+}
+
+/*
+========================================================================================================
+
+Saving
+
+========================================================================================================
+*/
+
+/*
+====================================================
+AppendAligned
+Appends the bytes at the next aligned offset and returns that offset
+====================================================
+*/
+static uint64_t AppendAligned( std::vector< unsigned char > & buffer, const void * data, const size_t numBytes ) {
+	const uint64_t offset = ( buffer.size() + SCENE_FILE_ALIGNMENT - 1 ) / SCENE_FILE_ALIGNMENT * SCENE_FILE_ALIGNMENT;
+	buffer.resize( offset + numBytes, 0 );
+	if ( numBytes > 0 ) {
+		memcpy( buffer.data() + offset, data, numBytes );
+	}
+	return offset;
+}
+
+/*
+====================================================
+AddShape
+Puts the shape in the table after the shapes it is made of
+====================================================
+*/
+static uint32_t AddShape( const Shape * shape, std::vector< const Shape * > & table, std::unordered_map< const Shape *, uint32_t > & indices ) {
+	auto it = indices.find( shape );
+	if ( it != indices.end() ) {
+		return it->second;
+	}
+
+	if ( Shape::ShapeType::SHAPE_COMPOUND == shape->GetType() ) {
+		const ShapeCompound * compound = static_cast< const ShapeCompound * >( shape );
+		for ( int i = 0; i < compound->children.size(); i++ ) {
+			AddShape( compound->children[ i ].shape, table, indices );
+		}
+	}
+
+	const uint32_t index = (uint32_t)table.size();
+	table.push_back( shape );
+	indices[ shape ] = index;
+	return index;
+}
+
+/*
+====================================================
+WriteShapeData
+Fills in the record of the shape and appends the arrays it points to
+====================================================
+*/
+static void WriteShapeData( const Shape * shape, const std::unordered_map< const Shape *, uint32_t > & indices, SceneFileShape_t & record, std::vector< unsigned char > & buffer ) {
+	memset( &record, 0, sizeof( record ) );
+	record.type = (uint32_t)shape->GetType();
+
+	switch ( shape->GetType() ) {
+		case Shape::ShapeType::SHAPE_SPHERE: {
+			record.params[ 0 ] = static_cast< const ShapeSphere * >( shape )->radius;
+		} break;
+		case Shape::ShapeType::SHAPE_BOX: {
+			const Vec3 & halfExtents = static_cast< const ShapeBox * >( shape )->halfExtents;
+			record.params[ 0 ] = halfExtents.x;
+			record.params[ 1 ] = halfExtents.y;
+			record.params[ 2 ] = halfExtents.z;
+		} break;
+		case Shape::ShapeType::SHAPE_CAPSULE: {
+			const ShapeCapsule * capsule = static_cast< const ShapeCapsule * >( shape );
+			record.params[ 0 ] = capsule->radius;
+			record.params[ 1 ] = capsule->halfHeight;
+		} break;
+		case Shape::ShapeType::SHAPE_CONVEX: {
+			// The hull of the hull's vertices is the same hull
+			const ShapeConvex * convex = static_cast< const ShapeConvex * >( shape );
+			record.counts[ 0 ] = (uint32_t)convex->points.size();
+			record.data = AppendAligned( buffer, convex->points.data(), convex->points.size() * sizeof( Vec3 ) );
+		} break;
+		case Shape::ShapeType::SHAPE_MESH: {
+			const ShapeMesh * mesh = static_cast< const ShapeMesh * >( shape );
+			record.counts[ 0 ] = (uint32_t)mesh->vertices.size();
+			record.counts[ 1 ] = (uint32_t)mesh->triangles.size();
+			record.data = AppendAligned( buffer, mesh->vertices.data(), mesh->vertices.size() * sizeof( Vec3 ) );
+			AppendAligned( buffer, mesh->triangles.data(), mesh->triangles.size() * sizeof( tri_t ) );
+		} break;
+		case Shape::ShapeType::SHAPE_HEIGHTFIELD: {
+			// Heights as the grid has them, they quantize back to the same samples
+			const HeightfieldGrid & grid = static_cast< const ShapeHeightfield * >( shape )->grid;
+			std::vector< float > heights( grid.NumX() * grid.NumY() );
+			for ( int j = 0; j < grid.NumY(); j++ ) {
+				for ( int i = 0; i < grid.NumX(); i++ ) {
+					heights[ j * grid.NumX() + i ] = grid.GetPoint( i, j ).z;
+				}
+			}
+			record.counts[ 0 ] = (uint32_t)grid.NumX();
+			record.counts[ 1 ] = (uint32_t)grid.NumY();
+			record.params[ 0 ] = grid.GetSpacing();
+			record.data = AppendAligned( buffer, heights.data(), heights.size() * sizeof( float ) );
+		} break;
+		case Shape::ShapeType::SHAPE_COMPOUND: {
+			const ShapeCompound * compound = static_cast< const ShapeCompound * >( shape );
+			std::vector< SceneFileChild_t > children( compound->children.size() );
+			for ( int i = 0; i < children.size(); i++ ) {
+				const CompoundChild & child = compound->children[ i ];
+				children[ i ].shape = indices.find( child.shape )->second;
+				children[ i ].position[ 0 ] = child.position.x;
+				children[ i ].position[ 1 ] = child.position.y;
+				children[ i ].position[ 2 ] = child.position.z;
+				children[ i ].orientation[ 0 ] = child.orientation.x;
+				children[ i ].orientation[ 1 ] = child.orientation.y;
+				children[ i ].orientation[ 2 ] = child.orientation.z;
+				children[ i ].orientation[ 3 ] = child.orientation.w;
+				children[ i ].mass = child.mass;
+			}
+			record.counts[ 0 ] = (uint32_t)children.size();
+			record.data = AppendAligned( buffer, children.data(), children.size() * sizeof( SceneFileChild_t ) );
+		} break;
+		default: break;
+	}
+}
+
+/*
+====================================================
+SaveSceneFile
+====================================================
+*/
+bool SaveSceneFile( const char * fileName, const Scene & scene ) {
+	if ( !IsLittleEndian() ) {
+		printf( "ERROR: scene files are little endian only\n" );
+		return false;
+	}
+
+	const std::vector< Body > & bodies = scene.bodies;
+	const int numBodies = (int)bodies.size();
+
+	std::vector< const Shape * > table;
+	std::unordered_map< const Shape *, uint32_t > indices;
+	std::vector< uint32_t > shapeIndices( numBodies );
+	for ( int i = 0; i < numBodies; i++ ) {
+		shapeIndices[ i ] = AddShape( bodies[ i ].shape, table, indices );
+	}
+
+	SceneFileHeader_t header;
+	memset( &header, 0, sizeof( header ) );
+	header.magic = SCENE_FILE_MAGIC;
+	header.version = SCENE_FILE_VERSION;
+	header.numShapes = (uint32_t)table.size();
+	header.numBodies = (uint32_t)numBodies;
+
+	std::vector< unsigned char > buffer;
+	AppendAligned( buffer, &header, sizeof( header ) );
+
+	// The table goes first, its records are filled in as their data is appended
+	std::vector< SceneFileShape_t > records( table.size() );
+	header.shapes = AppendAligned( buffer, records.data(), records.size() * sizeof( SceneFileShape_t ) );
+	for ( int i = 0; i < table.size(); i++ ) {
+		WriteShapeData( table[ i ], indices, records[ i ], buffer );
+	}
+	if ( !records.empty() ) {
+		memcpy( buffer.data() + header.shapes, records.data(), records.size() * sizeof( SceneFileShape_t ) );
+	}
+
+	// Fields are gathered one at a time, each into its own array
+	std::vector< float > values( numBodies * 4 );
+	for ( int i = 0; i < numBodies; i++ ) {
+		memcpy( &values[ i * 3 ], &bodies[ i ].position, sizeof( float ) * 3 );
+	}
+	header.positions = AppendAligned( buffer, values.data(), numBodies * sizeof( float ) * 3 );
+	for ( int i = 0; i < numBodies; i++ ) {
+		const Quat & q = bodies[ i ].orientation;
+		values[ i * 4 + 0 ] = q.x;
+		values[ i * 4 + 1 ] = q.y;
+		values[ i * 4 + 2 ] = q.z;
+		values[ i * 4 + 3 ] = q.w;
+	}
+	header.orientations = AppendAligned( buffer, values.data(), numBodies * sizeof( float ) * 4 );
+	for ( int i = 0; i < numBodies; i++ ) {
+		memcpy( &values[ i * 3 ], &bodies[ i ].linearVelocity, sizeof( float ) * 3 );
+	}
+	header.linearVelocities = AppendAligned( buffer, values.data(), numBodies * sizeof( float ) * 3 );
+	for ( int i = 0; i < numBodies; i++ ) {
+		memcpy( &values[ i * 3 ], &bodies[ i ].angularVelocity, sizeof( float ) * 3 );
+	}
+	header.angularVelocities = AppendAligned( buffer, values.data(), numBodies * sizeof( float ) * 3 );
+	for ( int i = 0; i < numBodies; i++ ) {
+		values[ i ] = bodies[ i ].inverseMass;
+	}
+	header.inverseMasses = AppendAligned( buffer, values.data(), numBodies * sizeof( float ) );
+	for ( int i = 0; i < numBodies; i++ ) {
+		values[ i ] = bodies[ i ].elasticity;
+	}
+	header.elasticities = AppendAligned( buffer, values.data(), numBodies * sizeof( float ) );
+	for ( int i = 0; i < numBodies; i++ ) {
+		values[ i ] = bodies[ i ].friction;
+	}
+	header.frictions = AppendAligned( buffer, values.data(), numBodies * sizeof( float ) );
+	header.shapeIndices = AppendAligned( buffer, shapeIndices.data(), numBodies * sizeof( uint32_t ) );
+
+	memcpy( buffer.data(), &header, sizeof( header ) );
+	return SaveFileData( fileName, buffer.data(), (unsigned int)buffer.size() );
+}
+
+/*
+========================================================================================================
+
+Loading
+
+========================================================================================================
+*/
+
+/*
+====================================================
+IsArrayInFile
+====================================================
+*/
+static bool IsArrayInFile( const FileView & file, const uint64_t offset, const uint64_t count, const uint64_t elementSize ) {
+	if ( offset % SCENE_FILE_ALIGNMENT != 0 || offset > file.Size() ) {
+		return false;
+	}
+	return count <= ( file.Size() - offset ) / elementSize;
+}
+
+/*
+====================================================
+AreFinite
+No NaNs or infinities among the values
+====================================================
+*/
+static bool AreFinite( const float * values, const uint64_t count ) {
+	for ( uint64_t i = 0; i < count; i++ ) {
+		if ( values[ i ] * 0.0f != values[ i ] * 0.0f ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+====================================================
+ArePositive
+Finite and greater than zero, the sizes of shapes and masses
+====================================================
+*/
+static bool ArePositive( const float * values, const uint64_t count ) {
+	for ( uint64_t i = 0; i < count; i++ ) {
+		if ( !( values[ i ] > 0.0f ) || !AreFinite( values + i, 1 ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+====================================================
+IsVolume
+Whether the points span a volume, the convex hull starts
+from a tetrahedron of them and a flat set has none
+====================================================
+*/
+static bool IsVolume( const float * coords, const uint32_t num ) {
+	const float epsilon = 0.0001f;
+	const Vec3 origin( coords );
+
+	// A second point apart from the first, a third off their line, a fourth off their plane
+	uint32_t i = 1;
+	Vec3 edge;
+	for ( ; i < num; i++ ) {
+		edge = Vec3( coords + i * 3 ) - origin;
+		if ( edge.GetLengthSqr() > epsilon * epsilon ) {
+			break;
+		}
+	}
+	Vec3 normal;
+	for ( i++; i < num; i++ ) {
+		normal = edge.Cross( Vec3( coords + i * 3 ) - origin );
+		if ( normal.GetLengthSqr() > epsilon * epsilon * edge.GetLengthSqr() ) {
+			break;
+		}
+	}
+	if ( i >= num ) {
+		return false;
+	}
+	normal.Normalize();
+	for ( i++; i < num; i++ ) {
+		if ( fabsf( normal.Dot( Vec3( coords + i * 3 ) - origin ) ) > epsilon ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+====================================================
+IsShapeValid
+Whether the record and the data it points to fit in the file
+and make a shape with some size to it, shapes it is made of
+have to come before it in the table
+====================================================
+*/
+static bool IsShapeValid( const FileView & file, const SceneFileShape_t & record, const uint32_t index ) {
+	switch ( (Shape::ShapeType)record.type ) {
+		case Shape::ShapeType::SHAPE_SPHERE:
+			return ArePositive( record.params, 1 );
+		case Shape::ShapeType::SHAPE_BOX:
+			return ArePositive( record.params, 3 );
+		case Shape::ShapeType::SHAPE_CAPSULE:
+			return ArePositive( record.params, 2 );
+		case Shape::ShapeType::SHAPE_CONVEX: {
+			if ( record.counts[ 0 ] < 4 || !IsArrayInFile( file, record.data, record.counts[ 0 ], sizeof( float ) * 3 ) ) {
+				return false;
+			}
+			const float * coords = (const float *)( file.Data() + record.data );
+			return AreFinite( coords, (uint64_t)record.counts[ 0 ] * 3 ) && IsVolume( coords, record.counts[ 0 ] );
+		}
+		case Shape::ShapeType::SHAPE_MESH: {
+			if ( record.counts[ 0 ] < 3 || 0 == record.counts[ 1 ] || !IsArrayInFile( file, record.data, record.counts[ 0 ], sizeof( float ) * 3 ) ) {
+				return false;
+			}
+			if ( !AreFinite( (const float *)( file.Data() + record.data ), (uint64_t)record.counts[ 0 ] * 3 ) ) {
+				return false;
+			}
+			const uint64_t trianglesOffset = ( record.data + record.counts[ 0 ] * sizeof( float ) * 3 + SCENE_FILE_ALIGNMENT - 1 ) / SCENE_FILE_ALIGNMENT * SCENE_FILE_ALIGNMENT;
+			if ( !IsArrayInFile( file, trianglesOffset, record.counts[ 1 ], sizeof( tri_t ) ) ) {
+				return false;
+			}
+			const tri_t * tris = (const tri_t *)( file.Data() + trianglesOffset );
+			for ( uint32_t i = 0; i < record.counts[ 1 ]; i++ ) {
+				if ( tris[ i ].a < 0 || tris[ i ].b < 0 || tris[ i ].c < 0 ) {
+					return false;
+				}
+				if ( tris[ i ].a >= (int)record.counts[ 0 ] || tris[ i ].b >= (int)record.counts[ 0 ] || tris[ i ].c >= (int)record.counts[ 0 ] ) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case Shape::ShapeType::SHAPE_HEIGHTFIELD: {
+			const uint64_t numHeights = (uint64_t)record.counts[ 0 ] * record.counts[ 1 ];
+			if ( record.counts[ 0 ] < 2 || record.counts[ 1 ] < 2 || !ArePositive( record.params, 1 ) || !IsArrayInFile( file, record.data, numHeights, sizeof( float ) ) ) {
+				return false;
+			}
+			return AreFinite( (const float *)( file.Data() + record.data ), numHeights );
+		}
+		case Shape::ShapeType::SHAPE_COMPOUND: {
+			if ( 0 == record.counts[ 0 ] || !IsArrayInFile( file, record.data, record.counts[ 0 ], sizeof( SceneFileChild_t ) ) ) {
+				return false;
+			}
+			const SceneFileChild_t * children = (const SceneFileChild_t *)( file.Data() + record.data );
+			for ( uint32_t i = 0; i < record.counts[ 0 ]; i++ ) {
+				if ( children[ i ].shape >= index || !ArePositive( &children[ i ].mass, 1 ) ) {
+					return false;
+				}
+				if ( !AreFinite( children[ i ].position, 3 ) || !AreFinite( children[ i ].orientation, 4 ) ) {
+					return false;
+				}
+			}
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+/*
+====================================================
+BuildShape
+====================================================
+*/
+static const Shape * BuildShape( const FileView & file, const SceneFileShape_t & record, const std::vector< const Shape * > & built, ShapeRegistry & shapes ) {
+	switch ( (Shape::ShapeType)record.type ) {
+		case Shape::ShapeType::SHAPE_SPHERE:
+			return shapes.GetSphere( record.params[ 0 ] );
+		case Shape::ShapeType::SHAPE_BOX:
+			return shapes.GetBox( Vec3( record.params ) );
+		case Shape::ShapeType::SHAPE_CAPSULE:
+			return shapes.GetCapsule( record.params[ 0 ], record.params[ 1 ] );
+		case Shape::ShapeType::SHAPE_CONVEX: {
+			const float * coords = (const float *)( file.Data() + record.data );
+			std::vector< Vec3 > points( record.counts[ 0 ] );
+			for ( uint32_t i = 0; i < record.counts[ 0 ]; i++ ) {
+				points[ i ] = Vec3( coords + i * 3 );
+			}
+			return shapes.GetConvex( points.data(), (int)points.size() );
+		}
+		case Shape::ShapeType::SHAPE_MESH: {
+			const float * coords = (const float *)( file.Data() + record.data );
+			std::vector< Vec3 > verts( record.counts[ 0 ] );
+			for ( uint32_t i = 0; i < record.counts[ 0 ]; i++ ) {
+				verts[ i ] = Vec3( coords + i * 3 );
+			}
+			const uint64_t trianglesOffset = ( record.data + record.counts[ 0 ] * sizeof( float ) * 3 + SCENE_FILE_ALIGNMENT - 1 ) / SCENE_FILE_ALIGNMENT * SCENE_FILE_ALIGNMENT;
+			const tri_t * tris = (const tri_t *)( file.Data() + trianglesOffset );
+			return shapes.GetMesh( verts.data(), (int)verts.size(), tris, (int)record.counts[ 1 ] );
+		}
+		case Shape::ShapeType::SHAPE_HEIGHTFIELD: {
+			const float * heights = (const float *)( file.Data() + record.data );
+			return shapes.GetHeightfield( heights, (int)record.counts[ 0 ], (int)record.counts[ 1 ], record.params[ 0 ] );
+		}
+		case Shape::ShapeType::SHAPE_COMPOUND: {
+			const SceneFileChild_t * saved = (const SceneFileChild_t *)( file.Data() + record.data );
+			std::vector< CompoundChild > children( record.counts[ 0 ] );
+			for ( uint32_t i = 0; i < record.counts[ 0 ]; i++ ) {
+				children[ i ].shape = built[ saved[ i ].shape ];
+				children[ i ].position = Vec3( saved[ i ].position );
+				children[ i ].orientation = Quat( saved[ i ].orientation[ 0 ], saved[ i ].orientation[ 1 ], saved[ i ].orientation[ 2 ], saved[ i ].orientation[ 3 ] );
+				children[ i ].mass = saved[ i ].mass;
+			}
+			return shapes.GetCompound( children.data(), (int)children.size() );
+		}
+		default:
+			return NULL;
+	}
+}
+
+/*
+====================================================
+LoadSceneFile
+====================================================
+*/
+bool LoadSceneFile( const char * fileName, Scene & scene ) {
+	if ( !IsLittleEndian() ) {
+		printf( "ERROR: scene files are little endian only\n" );
+		return false;
+	}
+
+	// Every byte is looked at, so the whole file may as well start coming in now
+	FileView file;
+	if ( !file.Open( fileName, true ) ) {
+		printf( "ERROR: unable to open scene %s\n", fileName );
+		return false;
+	}
+
+	// Check everything before touching the scene
+	const SceneFileHeader_t * header = (const SceneFileHeader_t *)file.Data();
+	bool isValid = file.Size() >= sizeof( SceneFileHeader_t ) && SCENE_FILE_MAGIC == header->magic && SCENE_FILE_VERSION == header->version;
+	if ( isValid ) {
+		const uint32_t numBodies = header->numBodies;
+		isValid = IsArrayInFile( file, header->shapes, header->numShapes, sizeof( SceneFileShape_t ) )
+			&& IsArrayInFile( file, header->positions, numBodies, sizeof( float ) * 3 )
+			&& IsArrayInFile( file, header->orientations, numBodies, sizeof( float ) * 4 )
+			&& IsArrayInFile( file, header->linearVelocities, numBodies, sizeof( float ) * 3 )
+			&& IsArrayInFile( file, header->angularVelocities, numBodies, sizeof( float ) * 3 )
+			&& IsArrayInFile( file, header->inverseMasses, numBodies, sizeof( float ) )
+			&& IsArrayInFile( file, header->elasticities, numBodies, sizeof( float ) )
+			&& IsArrayInFile( file, header->frictions, numBodies, sizeof( float ) )
+			&& IsArrayInFile( file, header->shapeIndices, numBodies, sizeof( uint32_t ) );
+	}
+	if ( isValid ) {
+		const SceneFileShape_t * records = (const SceneFileShape_t *)( file.Data() + header->shapes );
+		for ( uint32_t i = 0; i < header->numShapes && isValid; i++ ) {
+			isValid = IsShapeValid( file, records[ i ], i );
+		}
+
+		// Static bodies have no inverse mass, nothing has a negative one or negative bounce or friction
+		const uint32_t numBodies = header->numBodies;
+		isValid = isValid
+			&& AreFinite( (const float *)( file.Data() + header->positions ), (uint64_t)numBodies * 3 )
+			&& AreFinite( (const float *)( file.Data() + header->orientations ), (uint64_t)numBodies * 4 )
+			&& AreFinite( (const float *)( file.Data() + header->linearVelocities ), (uint64_t)numBodies * 3 )
+			&& AreFinite( (const float *)( file.Data() + header->angularVelocities ), (uint64_t)numBodies * 3 );
+		const float * inverseMasses = (const float *)( file.Data() + header->inverseMasses );
+		const float * elasticities = (const float *)( file.Data() + header->elasticities );
+		const float * frictions = (const float *)( file.Data() + header->frictions );
+		const uint32_t * shapeIndices = (const uint32_t *)( file.Data() + header->shapeIndices );
+		for ( uint32_t i = 0; i < numBodies && isValid; i++ ) {
+			isValid = shapeIndices[ i ] < header->numShapes
+				&& inverseMasses[ i ] >= 0.0f && AreFinite( inverseMasses + i, 1 )
+				&& elasticities[ i ] >= 0.0f && AreFinite( elasticities + i, 1 )
+				&& frictions[ i ] >= 0.0f && AreFinite( frictions + i, 1 );
+		}
+	}
+	if ( !isValid ) {
+		printf( "ERROR: not a valid scene file %s\n", fileName );
+		return false;
+	}
+
+	// The old bodies go, and the shapes and caches that refer to them
+	scene.bodies.clear();
+	scene.previousPoses.clear();
+	scene.shapes.Clear();
+	scene.contactCache.Clear();
+	scene.gjkCache.Clear();
+
+	const SceneFileShape_t * records = (const SceneFileShape_t *)( file.Data() + header->shapes );
+	std::vector< const Shape * > shapes( header->numShapes );
+	for ( uint32_t i = 0; i < header->numShapes; i++ ) {
+		shapes[ i ] = BuildShape( file, records[ i ], shapes, scene.shapes );
+	}
+
+	// Bodies are stored one field after another, the fields are copied straight out of their arrays
+	const int numBodies = (int)header->numBodies;
+	const float * positions = (const float *)( file.Data() + header->positions );
+	const float * orientations = (const float *)( file.Data() + header->orientations );
+	const float * linearVelocities = (const float *)( file.Data() + header->linearVelocities );
+	const float * angularVelocities = (const float *)( file.Data() + header->angularVelocities );
+	const float * inverseMasses = (const float *)( file.Data() + header->inverseMasses );
+	const float * elasticities = (const float *)( file.Data() + header->elasticities );
+	const float * frictions = (const float *)( file.Data() + header->frictions );
+	const uint32_t * shapeIndices = (const uint32_t *)( file.Data() + header->shapeIndices );
+
+	scene.bodies.resize( numBodies );
+	for ( int i = 0; i < numBodies; i++ ) {
+		Body & body = scene.bodies[ i ];
+		body.position = Vec3( positions + i * 3 );
+		body.orientation = Quat( orientations[ i * 4 + 0 ], orientations[ i * 4 + 1 ], orientations[ i * 4 + 2 ], orientations[ i * 4 + 3 ] );
+		body.linearVelocity = Vec3( linearVelocities + i * 3 );
+		body.angularVelocity = Vec3( angularVelocities + i * 3 );
+		body.inverseMass = inverseMasses[ i ];
+		body.elasticity = elasticities[ i ];
+		body.friction = frictions[ i ];
+		body.shape = shapes[ shapeIndices[ i ] ];
+	}
+
+	return true;
+}
@@ -0,0 +1,68 @@
+//
+//	SceneFile.h
+//
+#pragma once
+#include <stdint.h>
+
+class Scene;
+
+/*
+====================================================
+Scene file
+
+Binary, little endian, versioned.  Every array starts
+on a SCENE_FILE_ALIGNMENT boundary from the start of
+the file, so once mapped it can be read in place:
+
+	SceneFileHeader_t
+	SceneFileShape_t[ numShapes ]	the shape table
+	shape data						points, triangles, heights and children the table points into
+	body arrays						one array per field, numBodies entries each
+
+Shapes only reference shapes before them in the table,
+so compounds come after their children.
+====================================================
+*/
+static const uint32_t SCENE_FILE_MAGIC = 0x4e435350;	// "PSCN"
+static const uint32_t SCENE_FILE_VERSION = 1;
+static const uint64_t SCENE_FILE_ALIGNMENT = 16;
+
+struct SceneFileHeader_t {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numShapes;
+	uint32_t numBodies;
+
+	// Byte offsets from the start of the file
+	uint64_t shapes;
+	uint64_t positions;			// float[ 3 ] per body
+	uint64_t orientations;		// float[ 4 ] per body, x y z w
+	uint64_t linearVelocities;	// float[ 3 ] per body
+	uint64_t angularVelocities;	// float[ 3 ] per body
+	uint64_t inverseMasses;		// float per body
+	uint64_t elasticities;		// float per body
+	uint64_t frictions;			// float per body
+	uint64_t shapeIndices;		// uint32_t per body, into the shape table
+};
+
+struct SceneFileShape_t {
+	uint32_t type;			// Shape::ShapeType
+	uint32_t counts[ 2 ];	// convex: points | mesh: vertices, triangles | heightfield: numX, numY | compound: children
+	float params[ 3 ];		// sphere: radius | box: half extents | capsule: radius, half height | heightfield: spacing
+	uint64_t data;			// offset of float[ 3 ] points, float[ 3 ] vertices then int32_t[ 3 ] triangles, float heights or SceneFileChild_t children
+};
+
+struct SceneFileChild_t {
+	uint32_t shape;			// into the shape table
+	float position[ 3 ];
+	float orientation[ 4 ];
+	float mass;
+};
+
+// Every shape the bodies use and every body, as they are now
+bool SaveSceneFile( const char * fileName, const Scene & scene );
+
+// Replaces the scene with the file: its bodies, and the shapes of the registry with the file's.
+// The contact and GJK caches are cleared, they refer to the bodies and shapes that went.
+// The scene is left untouched if the file can't be read or doesn't check out.
+bool LoadSceneFile( const char * fileName, Scene & scene );
@@ -0,0 +1,187 @@
+//
+//	Trajectory.cpp
+//
+#include "Trajectory.h"
+#include "Math/Vector.h"
+#include "Math/Quat.h"
+#include <string.h>
+
+// The three smallest components of a unit quaternion lie within +-1 / sqrt( 2 )
+static const float ORIENTATION_SCALE = 32767.0f * 1.41421356f;
+
+// Bits of the byte every body starts with
+static const uint8_t POSE_LARGEST_MASK = 0x03;
+static const uint8_t POSE_POSITION_CHANGED = 0x04;
+static const uint8_t POSE_ORIENTATION_CHANGED = 0x08;
+
+/*
+====================================================
+QuantizePose
+====================================================
+*/
+void QuantizePose( const Vec3 & position, const Quat & orientation, const float positionScale, QuantizedPose_t & pose ) {
+	for ( int i = 0; i < 3; i++ ) {
+		const float q = floorf( position[ i ] * positionScale + 0.5f );
+		pose.position[ i ] = (int32_t)fminf( fmaxf( q, -2147483520.0f ), 2147483520.0f );
+	}
+
+	const float components[ 4 ] = { orientation.x, orientation.y, orientation.z, orientation.w };
+	int largest = 0;
+	for ( int i = 1; i < 4; i++ ) {
+		if ( fabsf( components[ i ] ) > fabsf( components[ largest ] ) ) {
+			largest = i;
+		}
+	}
+
+	// q and -q are the same rotation, the one with a positive largest component is kept
+	const float sign = ( components[ largest ] < 0.0f ) ? -1.0f : 1.0f;
+	int j = 0;
+	for ( int i = 0; i < 4; i++ ) {
+		if ( i == largest ) {
+			continue;
+		}
+		const float q = floorf( components[ i ] * sign * ORIENTATION_SCALE + 0.5f );
+		pose.orientation[ j++ ] = (int16_t)fminf( fmaxf( q, -32767.0f ), 32767.0f );
+	}
+	pose.largest = (uint8_t)largest;
+}
+
+/*
+====================================================
+DequantizePose
+====================================================
+*/
+void DequantizePose( const QuantizedPose_t & pose, const float positionScale, Vec3 & position, Quat & orientation ) {
+	position = Vec3( (float)pose.position[ 0 ], (float)pose.position[ 1 ], (float)pose.position[ 2 ] ) * ( 1.0f / positionScale );
+
+	float components[ 4 ];
+	float sumSqr = 0.0f;
+	int j = 0;
+	for ( int i = 0; i < 4; i++ ) {
+		if ( i == pose.largest ) {
+			continue;
+		}
+		components[ i ] = (float)pose.orientation[ j++ ] / ORIENTATION_SCALE;
+		sumSqr += components[ i ] * components[ i ];
+	}
+	components[ pose.largest ] = sqrtf( fmaxf( 1.0f - sumSqr, 0.0f ) );
+
+	orientation = Quat( components[ 0 ], components[ 1 ], components[ 2 ], components[ 3 ] );
+	orientation.Normalize();
+}
+
+/*
+====================================================
+WriteVarint
+Zigzag, so small negative changes stay small, then 7 bits a byte
+====================================================
+*/
+static void WriteVarint( const int64_t value, std::vector< uint8_t > & out ) {
+	uint64_t bits = ( (uint64_t)value << 1 ) ^ (uint64_t)( value >> 63 );
+	while ( bits >= 0x80 ) {
+		out.push_back( (uint8_t)( bits | 0x80 ) );
+		bits >>= 7;
+	}
+	out.push_back( (uint8_t)bits );
+}
+
+/*
+====================================================
+ReadVarint
+====================================================
+*/
+static bool ReadVarint( const uint8_t *& data, const uint8_t * end, int64_t & value ) {
+	uint64_t bits = 0;
+	for ( int shift = 0; shift < 64; shift += 7 ) {
+		if ( data == end ) {
+			return false;
+		}
+		const uint8_t byte = *data++;
+		bits |= (uint64_t)( byte & 0x7f ) << shift;
+		if ( 0 == ( byte & 0x80 ) ) {
+			value = (int64_t)( bits >> 1 ) ^ -(int64_t)( bits & 1 );
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+====================================================
+EncodeFrame
+
+A byte per body: the index of the largest orientation
+component and which parts changed.  Only the changes
+of those parts follow, a body at rest costs one byte.
+====================================================
+*/
+void EncodeFrame( const QuantizedPose_t * previous, const QuantizedPose_t * poses, const int numBodies, std::vector< uint8_t > & out ) {
+	QuantizedPose_t zero = {};
+	for ( int i = 0; i < numBodies; i++ ) {
+		const QuantizedPose_t & from = ( NULL != previous ) ? previous[ i ] : zero;
+		const QuantizedPose_t & to = poses[ i ];
+
+		const bool isPositionChanged = from.position[ 0 ] != to.position[ 0 ] || from.position[ 1 ] != to.position[ 1 ] || from.position[ 2 ] != to.position[ 2 ];
+		const bool isOrientationChanged = from.orientation[ 0 ] != to.orientation[ 0 ] || from.orientation[ 1 ] != to.orientation[ 1 ] || from.orientation[ 2 ] != to.orientation[ 2 ];
+
+		uint8_t flags = to.largest & POSE_LARGEST_MASK;
+		if ( isPositionChanged ) {
+			flags |= POSE_POSITION_CHANGED;
+		}
+		if ( isOrientationChanged ) {
+			flags |= POSE_ORIENTATION_CHANGED;
+		}
+		out.push_back( flags );
+
+		if ( isPositionChanged ) {
+			for ( int k = 0; k < 3; k++ ) {
+				WriteVarint( (int64_t)to.position[ k ] - from.position[ k ], out );
+			}
+		}
+		if ( isOrientationChanged ) {
+			for ( int k = 0; k < 3; k++ ) {
+				WriteVarint( (int64_t)to.orientation[ k ] - from.orientation[ k ], out );
+			}
+		}
+	}
+}
+
+/*
+====================================================
+DecodeFrame
+====================================================
+*/
+bool DecodeFrame( const uint8_t * data, const size_t numBytes, const bool isKeyframe, QuantizedPose_t * poses, const int numBodies ) {
+	const uint8_t * end = data + numBytes;
+	for ( int i = 0; i < numBodies; i++ ) {
+		QuantizedPose_t & pose = poses[ i ];
+		if ( isKeyframe ) {
+			memset( &pose, 0, sizeof( pose ) );
+		}
+
+		if ( data == end ) {
+			return false;
+		}
+		const uint8_t flags = *data++;
+		pose.largest = flags & POSE_LARGEST_MASK;
+
+		int64_t delta;
+		if ( flags & POSE_POSITION_CHANGED ) {
+			for ( int k = 0; k < 3; k++ ) {
+				if ( !ReadVarint( data, end, delta ) ) {
+					return false;
+				}
+				pose.position[ k ] = (int32_t)( pose.position[ k ] + delta );
+			}
+		}
+		if ( flags & POSE_ORIENTATION_CHANGED ) {
+			for ( int k = 0; k < 3; k++ ) {
+				if ( !ReadVarint( data, end, delta ) ) {
+					return false;
+				}
+				pose.orientation[ k ] = (int16_t)( pose.orientation[ k ] + delta );
+			}
+		}
+	}
+	return true;
+}
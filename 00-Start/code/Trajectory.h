@@ -0,0 +1,82 @@
+//
+//	Trajectory.h
+//
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class Vec3;
+class Quat;
+
+/*
+====================================================
+Trajectory file
+
+Little endian.  The pose of every body, every step,
+one frame per step:
+
+	TrajectoryFileHeader_t
+	frames				TrajectoryFrameHeader_t then its encoded poses
+	keyframe index		TrajectoryKeyframe_t for every keyframe
+	TrajectoryFileFooter_t
+
+Positions are quantized to 1 / positionScale, orientations
+to their smallest three components.  A frame holds the
+change from the frame before it, keyframes the change
+from nothing, so decoding can start at any keyframe.
+A file cut short, with no index, can still be scanned
+frame by frame.
+====================================================
+*/
+static const uint32_t TRAJECTORY_FILE_MAGIC = 0x4a525450;	// "PTRJ"
+static const uint32_t TRAJECTORY_FILE_VERSION = 2;
+
+struct TrajectoryFileHeader_t {
+	uint32_t magic;
+	uint32_t version;
+	float positionScale;		// quantization steps per meter
+	uint32_t keyframeInterval;	// frames between two keyframes
+	float stepsPerSecond;		// physics rate of the recording, frame n is at n / stepsPerSecond seconds
+};
+
+struct TrajectoryFrameHeader_t {
+	uint32_t frame;
+	uint32_t numBodies;
+	uint32_t isKeyframe;
+	uint32_t numBytes;			// of the encoded poses that follow
+};
+
+struct TrajectoryKeyframe_t {
+	uint32_t frame;
+	uint32_t pad;
+	uint64_t offset;			// of its TrajectoryFrameHeader_t
+};
+
+struct TrajectoryFileFooter_t {
+	uint64_t index;				// offset of the first TrajectoryKeyframe_t
+	uint32_t numKeyframes;
+	uint32_t magic;
+};
+
+/*
+====================================================
+QuantizedPose_t
+====================================================
+*/
+struct QuantizedPose_t {
+	int32_t position[ 3 ];
+	// The three smallest components of the orientation, the largest one is rebuilt from them
+	int16_t orientation[ 3 ];
+	uint8_t largest;
+};
+
+void QuantizePose( const Vec3 & position, const Quat & orientation, const float positionScale, QuantizedPose_t & pose );
+void DequantizePose( const QuantizedPose_t & pose, const float positionScale, Vec3 & position, Quat & orientation );
+
+// Appends the change from previous to poses, previous may be NULL for a keyframe
+void EncodeFrame( const QuantizedPose_t * previous, const QuantizedPose_t * poses, const int numBodies, std::vector< uint8_t > & out );
+
+// Applies an encoded frame to poses, which holds the frame before it, or anything for a keyframe.
+// Returns false if the data runs out before every body is decoded.
+bool DecodeFrame( const uint8_t * data, const size_t numBytes, const bool isKeyframe, QuantizedPose_t * poses, const int numBodies );
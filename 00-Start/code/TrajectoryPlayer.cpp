@@ -0,0 +1,263 @@
+//
+//	TrajectoryPlayer.cpp
+//
+#include "TrajectoryPlayer.h"
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+/*
+====================================================
+TrajectoryPlayer::TrajectoryPlayer
+====================================================
+*/
+TrajectoryPlayer::TrajectoryPlayer() :
+m_framesEnd( 0 ),
+m_numFrames( 0 ),
+m_numBodies( 0 ),
+m_requestedFrame( -1 ),
+m_isStopping( false ),
+m_decodedFrame( -1 ),
+m_nextOffset( 0 ),
+m_publishedFrame( -1 ) {
+}
+
+/*
+====================================================
+TrajectoryPlayer::~TrajectoryPlayer
+====================================================
+*/
+TrajectoryPlayer::~TrajectoryPlayer() {
+	Close();
+}
+
+/*
+====================================================
+TrajectoryPlayer::Open
+====================================================
+*/
+bool TrajectoryPlayer::Open( const char * fileName ) {
+	Close();
+
+	if ( !m_file.Open( fileName ) ) {
+		printf( "ERROR: unable to open trajectory %s\n", fileName );
+		return false;
+	}
+
+	if ( m_file.Size() < sizeof( TrajectoryFileHeader_t ) ) {
+		printf( "ERROR: not a trajectory file %s\n", fileName );
+		m_file.Close();
+		return false;
+	}
+	memcpy( &m_header, m_file.Data(), sizeof( m_header ) );
+	if ( TRAJECTORY_FILE_MAGIC != m_header.magic || TRAJECTORY_FILE_VERSION != m_header.version || m_header.positionScale <= 0.0f || m_header.stepsPerSecond <= 0.0f ) {
+		printf( "ERROR: not a trajectory file %s\n", fileName );
+		m_file.Close();
+		return false;
+	}
+
+	if ( !BuildIndex() ) {
+		printf( "ERROR: no frames in trajectory %s\n", fileName );
+		m_file.Close();
+		return false;
+	}
+
+	m_requestedFrame = 0;
+	m_isStopping = false;
+	m_decodedFrame = -1;
+	m_publishedFrame = -1;
+	m_thread = std::thread( &TrajectoryPlayer::DecoderThread, this );
+	return true;
+}
+
+/*
+====================================================
+TrajectoryPlayer::Close
+====================================================
+*/
+void TrajectoryPlayer::Close() {
+	if ( !IsOpen() ) {
+		return;
+	}
+
+	m_isStopping = true;
+	m_thread.join();
+
+	m_file.Close();
+	m_keyframes.clear();
+	m_numFrames = 0;
+	m_numBodies = 0;
+}
+
+/*
+====================================================
+TrajectoryPlayer::ReadFrameHeader
+====================================================
+*/
+bool TrajectoryPlayer::ReadFrameHeader( const uint64_t offset, TrajectoryFrameHeader_t & header ) const {
+	if ( offset > m_framesEnd || m_framesEnd - offset < sizeof( header ) ) {
+		return false;
+	}
+	memcpy( &header, m_file.Data() + offset, sizeof( header ) );
+	return header.numBytes <= m_framesEnd - offset - sizeof( header );
+}
+
+/*
+====================================================
+TrajectoryPlayer::BuildIndex
+
+The index at the end of the file when the recording
+was stopped cleanly, otherwise a walk over every frame
+====================================================
+*/
+bool TrajectoryPlayer::BuildIndex() {
+	m_keyframes.clear();
+	m_numFrames = 0;
+	m_numBodies = 0;
+
+	uint64_t firstFrame = sizeof( TrajectoryFileHeader_t );
+	uint64_t scanFrom = firstFrame;
+	m_framesEnd = m_file.Size();
+
+	TrajectoryFileFooter_t footer;
+	memset( &footer, 0, sizeof( footer ) );
+	if ( m_file.Size() >= firstFrame + sizeof( footer ) ) {
+		memcpy( &footer, m_file.Data() + m_file.Size() - sizeof( footer ), sizeof( footer ) );
+	}
+	const uint64_t indexBytes = (uint64_t)footer.numKeyframes * sizeof( TrajectoryKeyframe_t );
+	const bool hasIndex = TRAJECTORY_FILE_MAGIC == footer.magic && footer.index >= firstFrame && footer.index <= m_file.Size() - sizeof( footer ) && indexBytes == m_file.Size() - sizeof( footer ) - footer.index;
+	if ( hasIndex ) {
+		m_framesEnd = footer.index;
+	}
+	if ( hasIndex && footer.numKeyframes > 0 ) {
+		m_keyframes.resize( footer.numKeyframes );
+		memcpy( m_keyframes.data(), m_file.Data() + footer.index, indexBytes );
+
+		// Only the frames after the last keyframe are left to count
+		scanFrom = m_keyframes.back().offset;
+		m_numFrames = m_keyframes.back().frame;
+	}
+
+	TrajectoryFrameHeader_t header;
+	uint64_t offset = scanFrom;
+	while ( ReadFrameHeader( offset, header ) ) {
+		if ( header.isKeyframe && ( m_keyframes.empty() || header.frame > m_keyframes.back().frame ) ) {
+			TrajectoryKeyframe_t keyframe;
+			keyframe.frame = header.frame;
+			keyframe.pad = 0;
+			keyframe.offset = offset;
+			m_keyframes.push_back( keyframe );
+		}
+		m_numFrames = header.frame + 1;
+		offset += sizeof( header ) + header.numBytes;
+	}
+
+	// A recording cut short mid frame ends at the last whole one
+	m_framesEnd = offset;
+	if ( m_keyframes.empty() || m_numFrames <= 0 ) {
+		return false;
+	}
+
+	// Every frame holds the same bodies, the first keyframe says how many
+	if ( !ReadFrameHeader( m_keyframes[ 0 ].offset, header ) ) {
+		return false;
+	}
+	m_numBodies = (int)header.numBodies;
+	return true;
+}
+
+/*
+====================================================
+TrajectoryPlayer::Seek
+====================================================
+*/
+void TrajectoryPlayer::Seek( const int frame ) {
+	m_requestedFrame = std::max( 0, std::min( frame, m_numFrames - 1 ) );
+}
+
+/*
+====================================================
+TrajectoryPlayer::GetPoses
+====================================================
+*/
+int TrajectoryPlayer::GetPoses( std::vector< Vec3 > & positions, std::vector< Quat > & orientations ) {
+	std::lock_guard< std::mutex > guard( m_lock );
+	if ( m_publishedFrame >= 0 ) {
+		positions = m_positions;
+		orientations = m_orientations;
+	}
+	return m_publishedFrame;
+}
+
+/*
+====================================================
+TrajectoryPlayer::DecodeTo
+====================================================
+*/
+bool TrajectoryPlayer::DecodeTo( const int frame ) {
+	// Last keyframe at or before the frame
+	const TrajectoryKeyframe_t * keyframe = &m_keyframes[ 0 ];
+	for ( int i = 1; i < m_keyframes.size() && m_keyframes[ i ].frame <= (uint32_t)frame; i++ ) {
+		keyframe = &m_keyframes[ i ];
+	}
+
+	// Going on from the current frame beats starting over, unless there's a keyframe in between
+	if ( m_decodedFrame < 0 || frame < m_decodedFrame || (int)keyframe->frame > m_decodedFrame ) {
+		m_nextOffset = keyframe->offset;
+		m_decodedFrame = -1;
+	}
+
+	TrajectoryFrameHeader_t header;
+	while ( m_decodedFrame < frame && ReadFrameHeader( m_nextOffset, header ) ) {
+		if ( m_decodedFrame < 0 && !header.isKeyframe ) {
+			return false;
+		}
+
+		m_poses.resize( header.numBodies );
+		const uint8_t * data = m_file.Data() + m_nextOffset + sizeof( header );
+		if ( !DecodeFrame( data, header.numBytes, 0 != header.isKeyframe, m_poses.data(), (int)header.numBodies ) ) {
+			m_decodedFrame = -1;
+			return false;
+		}
+
+		m_decodedFrame = header.frame;
+		m_nextOffset += sizeof( header ) + header.numBytes;
+	}
+	return m_decodedFrame == frame;
+}
+
+/*
+====================================================
+TrajectoryPlayer::DecoderThread
+====================================================
+*/
+void TrajectoryPlayer::DecoderThread() {
+	int failedFrame = -1;
+	while ( !m_isStopping ) {
+		const int frame = m_requestedFrame;
+		if ( frame < 0 || frame == m_decodedFrame || frame == failedFrame ) {
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+			continue;
+		}
+
+		if ( !DecodeTo( frame ) ) {
+			printf( "ERROR: unable to decode trajectory frame %i\n", frame );
+			failedFrame = frame;
+			continue;
+		}
+		failedFrame = -1;
+
+		// Dequantized outside the lock, the draw only waits for the swap
+		const int numBodies = (int)m_poses.size();
+		m_decodedPositions.resize( numBodies );
+		m_decodedOrientations.resize( numBodies );
+		for ( int i = 0; i < numBodies; i++ ) {
+			DequantizePose( m_poses[ i ], m_header.positionScale, m_decodedPositions[ i ], m_decodedOrientations[ i ] );
+		}
+
+		std::lock_guard< std::mutex > guard( m_lock );
+		m_positions.swap( m_decodedPositions );
+		m_orientations.swap( m_decodedOrientations );
+		m_publishedFrame = m_decodedFrame;
+	}
+}
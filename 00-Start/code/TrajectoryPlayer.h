@@ -0,0 +1,81 @@
+//
+//	TrajectoryPlayer.h
+//
+#pragma once
+#include "Trajectory.h"
+#include "Fileio.h"
+#include "Math/Vector.h"
+#include "Math/Quat.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+====================================================
+TrajectoryPlayer
+
+Plays back a trajectory file written by the recorder.
+The file is mapped, not read, so only the frames that
+are looked at are ever loaded.  A background thread
+decodes whichever frame was last asked for: forward
+from the frame it is on when that is closest, from
+the keyframe before it otherwise, so any frame is at
+most a keyframe interval of deltas away.
+====================================================
+*/
+class TrajectoryPlayer {
+public:
+	TrajectoryPlayer();
+	~TrajectoryPlayer();
+
+	bool Open( const char * fileName );
+	void Close();
+	bool IsOpen() const { return m_file.IsOpen(); }
+
+	int NumFrames() const { return m_numFrames; }
+	// Bodies in each frame, a replay only fits a scene with as many
+	int NumBodies() const { return m_numBodies; }
+	// Physics rate the file was recorded at, the rate to seek by
+	float StepsPerSecond() const { return m_header.stepsPerSecond; }
+
+	// Frame to decode next, clamped to the recording
+	void Seek( const int frame );
+
+	// Poses of the last frame decoded, and which one that is, -1 while there is none yet
+	int GetPoses( std::vector< Vec3 > & positions, std::vector< Quat > & orientations );
+
+private:
+	TrajectoryPlayer( const TrajectoryPlayer & ) = delete;
+	TrajectoryPlayer & operator = ( const TrajectoryPlayer & ) = delete;
+
+	bool BuildIndex();
+	bool ReadFrameHeader( const uint64_t offset, TrajectoryFrameHeader_t & header ) const;
+	bool DecodeTo( const int frame );
+	void DecoderThread();
+
+	FileView m_file;
+	TrajectoryFileHeader_t m_header;
+	// Where the frames end, the keyframe index follows
+	uint64_t m_framesEnd;
+	std::vector< TrajectoryKeyframe_t > m_keyframes;
+	int m_numFrames;
+	int m_numBodies;
+
+	std::thread m_thread;
+	std::atomic< int > m_requestedFrame;
+	std::atomic< bool > m_isStopping;
+
+	// Only touched by the decoder thread
+	int m_decodedFrame;
+	uint64_t m_nextOffset;
+	std::vector< QuantizedPose_t > m_poses;
+	std::vector< Vec3 > m_decodedPositions;
+	std::vector< Quat > m_decodedOrientations;
+
+	// Handed over under the lock
+	std::mutex m_lock;
+	int m_publishedFrame;
+	std::vector< Vec3 > m_positions;
+	std::vector< Quat > m_orientations;
+};
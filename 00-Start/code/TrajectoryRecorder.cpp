@@ -0,0 +1,212 @@
+//
+//	TrajectoryRecorder.cpp
+//
+#include "TrajectoryRecorder.h"
+#include "Fileio.h"
+#include "../Body.h"
+#include <chrono>
+
+/*
+====================================================
+FileOffset
+ftell is limited to 2GB where long is 32 bits
+====================================================
+*/
+static uint64_t FileOffset( FILE * file ) {
+#if defined( _WIN32 )
+	return (uint64_t)_ftelli64( file );
+#else
+	return (uint64_t)ftello( file );
+#endif
+}
+
+/*
+====================================================
+TrajectoryRecorder::TrajectoryRecorder
+====================================================
+*/
+TrajectoryRecorder::TrajectoryRecorder() :
+m_numWritten( 0 ),
+m_numRead( 0 ),
+m_isStopping( false ),
+m_file( NULL ),
+m_numStalls( 0 ),
+m_frame( 0 ) {
+}
+
+/*
+====================================================
+TrajectoryRecorder::~TrajectoryRecorder
+====================================================
+*/
+TrajectoryRecorder::~TrajectoryRecorder() {
+	Stop();
+}
+
+/*
+====================================================
+TrajectoryRecorder::Start
+====================================================
+*/
+bool TrajectoryRecorder::Start( const char * fileNameLocal, const float stepsPerSecond ) {
+	Stop();
+
+	char fileName[ 2048 ];
+	RelativePathToFullPath( fileNameLocal, fileName );
+
+	m_file = fopen( fileName, "wb" );
+	if ( NULL == m_file ) {
+		printf( "ERROR: open file for write failed: %s\n", fileName );
+		return false;
+	}
+
+	TrajectoryFileHeader_t header;
+	header.magic = TRAJECTORY_FILE_MAGIC;
+	header.version = TRAJECTORY_FILE_VERSION;
+	header.positionScale = (float)POSITION_SCALE;
+	header.keyframeInterval = KEYFRAME_INTERVAL;
+	header.stepsPerSecond = stepsPerSecond;
+	fwrite( &header, sizeof( header ), 1, m_file );
+
+	m_numWritten = 0;
+	m_numRead = 0;
+	m_isStopping = false;
+	m_numStalls = 0;
+	m_frame = 0;
+	m_previous.clear();
+	m_keyframes.clear();
+
+	m_thread = std::thread( &TrajectoryRecorder::WriterThread, this );
+	return true;
+}
+
+/*
+====================================================
+TrajectoryRecorder::Stop
+====================================================
+*/
+void TrajectoryRecorder::Stop() {
+	if ( NULL == m_file ) {
+		return;
+	}
+
+	m_isStopping = true;
+	m_thread.join();
+
+	TrajectoryFileFooter_t footer;
+	footer.index = FileOffset( m_file );
+	footer.numKeyframes = (uint32_t)m_keyframes.size();
+	footer.magic = TRAJECTORY_FILE_MAGIC;
+	if ( !m_keyframes.empty() ) {
+		fwrite( m_keyframes.data(), sizeof( TrajectoryKeyframe_t ), m_keyframes.size(), m_file );
+	}
+	fwrite( &footer, sizeof( footer ), 1, m_file );
+
+	fclose( m_file );
+	m_file = NULL;
+}
+
+/*
+====================================================
+TrajectoryRecorder::RecordFrame
+====================================================
+*/
+void TrajectoryRecorder::RecordFrame( const Body * bodies, const int numBodies ) {
+	if ( NULL == m_file ) {
+		return;
+	}
+
+	const uint32_t numWritten = m_numWritten.load( std::memory_order_relaxed );
+	if ( numWritten - m_numRead.load( std::memory_order_acquire ) >= NUM_SLOTS ) {
+		m_numStalls++;
+		while ( numWritten - m_numRead.load( std::memory_order_acquire ) >= NUM_SLOTS ) {
+			std::this_thread::yield();
+		}
+	}
+
+	// Just a copy, everything else happens on the writer thread
+	Slot_t & slot = m_slots[ numWritten % NUM_SLOTS ];
+	slot.poses.resize( numBodies * FLOATS_PER_POSE );
+	slot.numBodies = numBodies;
+	float * pose = slot.poses.data();
+	for ( int i = 0; i < numBodies; i++ ) {
+		const Body & body = bodies[ i ];
+		pose[ 0 ] = body.position.x;
+		pose[ 1 ] = body.position.y;
+		pose[ 2 ] = body.position.z;
+		pose[ 3 ] = body.orientation.x;
+		pose[ 4 ] = body.orientation.y;
+		pose[ 5 ] = body.orientation.z;
+		pose[ 6 ] = body.orientation.w;
+		pose += FLOATS_PER_POSE;
+	}
+
+	m_numWritten.store( numWritten + 1, std::memory_order_release );
+}
+
+/*
+====================================================
+TrajectoryRecorder::WriterThread
+====================================================
+*/
+void TrajectoryRecorder::WriterThread() {
+	while ( true ) {
+		const uint32_t numRead = m_numRead.load( std::memory_order_relaxed );
+		if ( numRead == m_numWritten.load( std::memory_order_acquire ) ) {
+			// Only stop once the ring is drained
+			if ( m_isStopping ) {
+				break;
+			}
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+			continue;
+		}
+
+		const Slot_t & slot = m_slots[ numRead % NUM_SLOTS ];
+		WriteFrame( slot.poses.data(), slot.numBodies );
+
+		m_numRead.store( numRead + 1, std::memory_order_release );
+	}
+
+	fflush( m_file );
+}
+
+/*
+====================================================
+TrajectoryRecorder::WriteFrame
+====================================================
+*/
+void TrajectoryRecorder::WriteFrame( const float * poses, const int numBodies ) {
+	m_current.resize( numBodies );
+	for ( int i = 0; i < numBodies; i++ ) {
+		const float * pose = poses + i * FLOATS_PER_POSE;
+		QuantizePose( Vec3( pose ), Quat( pose[ 3 ], pose[ 4 ], pose[ 5 ], pose[ 6 ] ), (float)POSITION_SCALE, m_current[ i ] );
+	}
+
+	// A change in the number of bodies has nothing to take the change from
+	const bool isKeyframe = ( 0 == m_frame % KEYFRAME_INTERVAL ) || ( m_previous.size() != m_current.size() );
+
+	m_encoded.clear();
+	EncodeFrame( isKeyframe ? NULL : m_previous.data(), m_current.data(), numBodies, m_encoded );
+
+	TrajectoryFrameHeader_t header;
+	header.frame = m_frame;
+	header.numBodies = (uint32_t)numBodies;
+	header.isKeyframe = isKeyframe ? 1 : 0;
+	header.numBytes = (uint32_t)m_encoded.size();
+
+	if ( isKeyframe ) {
+		TrajectoryKeyframe_t keyframe;
+		keyframe.frame = m_frame;
+		keyframe.pad = 0;
+		keyframe.offset = FileOffset( m_file );
+		m_keyframes.push_back( keyframe );
+	}
+
+	fwrite( &header, sizeof( header ), 1, m_file );
+	if ( !m_encoded.empty() ) {
+		fwrite( m_encoded.data(), 1, m_encoded.size(), m_file );
+	}
+
+	m_previous.swap( m_current );
+	m_frame++;
+}
@@ -0,0 +1,79 @@
+//
+//	TrajectoryRecorder.h
+//
+#pragma once
+#include "Trajectory.h"
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+class Body;
+
+/*
+====================================================
+TrajectoryRecorder
+
+Writes the pose of every body, every step, to a
+trajectory file (see Trajectory.h).  The stepping
+thread only copies the poses into a ring of frame
+slots, a background thread quantizes, encodes and
+writes them.  There is one producer and one consumer,
+so the ring needs no lock: each side only moves its
+own index.  With the ring full the stepping thread
+waits for a slot rather than dropping a frame.
+====================================================
+*/
+class TrajectoryRecorder {
+public:
+	TrajectoryRecorder();
+	~TrajectoryRecorder();
+
+	// stepsPerSecond is the physics rate RecordFrame will be called at
+	bool Start( const char * fileName, const float stepsPerSecond );
+	// Writes out the frames still in the ring, then the keyframe index
+	void Stop();
+	bool IsRecording() const { return NULL != m_file; }
+
+	// Called after every step
+	void RecordFrame( const Body * bodies, const int numBodies );
+
+	// Times RecordFrame had to wait for the writer
+	int NumStalls() const { return m_numStalls; }
+
+private:
+	TrajectoryRecorder( const TrajectoryRecorder & ) = delete;
+	TrajectoryRecorder & operator = ( const TrajectoryRecorder & ) = delete;
+
+	void WriterThread();
+	void WriteFrame( const float * poses, const int numBodies );
+
+	static const int NUM_SLOTS = 8;
+	static const int FLOATS_PER_POSE = 7;
+
+	// Quantization steps per meter, a millimeter
+	static const int POSITION_SCALE = 1024;
+	static const int KEYFRAME_INTERVAL = 60;
+
+	struct Slot_t {
+		std::vector< float > poses;	// position then orientation x y z w, for every body
+		int numBodies;
+	};
+	Slot_t m_slots[ NUM_SLOTS ];
+
+	// Count up forever, slot i is m_slots[ i % NUM_SLOTS ]
+	std::atomic< uint32_t > m_numWritten;	// by RecordFrame
+	std::atomic< uint32_t > m_numRead;		// by the writer thread
+	std::atomic< bool > m_isStopping;
+
+	std::thread m_thread;
+	FILE * m_file;
+	int m_numStalls;
+
+	// Only touched by the writer thread
+	uint32_t m_frame;
+	std::vector< QuantizedPose_t > m_previous;
+	std::vector< QuantizedPose_t > m_current;
+	std::vector< uint8_t > m_encoded;
+	std::vector< TrajectoryKeyframe_t > m_keyframes;
+};
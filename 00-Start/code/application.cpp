@@ -11,11 +11,14 @@
 
 #include "application.h"
 #include "Fileio.h"
+#include "AssetArchive.h"
 #include <assert.h>
 
 #include "Renderer/OffscreenRenderer.h"
 
 #include "Scene.h"
+#include "TrajectoryRecorder.h"
+#include "TrajectoryPlayer.h"
 
 Application * application = NULL;
 
@@ -70,20 +73,43 @@ void Application::Initialize() {
 	//FillDiamond();
 
 	InitializeGLFW();
+
+	// Without an archive everything is loaded from the loose files
+	g_assetArchive.Open( ASSET_ARCHIVE_FILE );
 	InitializeVulkan();
 
 	scene = new Scene;
+	if ( NULL != m_sceneFile ) {
+		scene->SetSceneFile( m_sceneFile );
+	}
 	scene->Initialize();
-	scene->Reset();
 
+	if ( NULL != m_replayFile ) {
+		m_player = new TrajectoryPlayer;
+		if ( !m_player->Open( m_replayFile ) ) {
+			delete m_player;
+			m_player = NULL;
+		} else if ( m_player->NumBodies() != (int)scene->bodies.size() ) {
+			printf( "ERROR: trajectory %s has %i bodies, the scene has %i\n", m_replayFile, m_player->NumBodies(), (int)scene->bodies.size() );
+			delete m_player;
+			m_player = NULL;
+		}
+	}
+
+	if ( NULL != m_recordFile && NULL == m_player ) {
+		m_recorder = new TrajectoryRecorder;
+		if ( !m_recorder->Start( m_recordFile, m_physicsRate ) ) {
+			delete m_recorder;
+			m_recorder = NULL;
+		}
+	}
+
+	// Bodies of the same shape share its vertex and index buffers
 	m_models.reserve( scene->bodies.size() );
 	for ( int i = 0; i < scene->bodies.size(); i++ ) {
-		Model * model = new Model();
-		model->BuildFromShape( scene->bodies[ i ].shape );
-		model->MakeVBO( &deviceContext );
-
-		m_models.push_back( model );
+		m_models.push_back( m_meshCache.GetModel( &deviceContext, scene->bodies[ i ].shape ) );
 	}
+	printf( "Models: %i for %i bodies\n", m_meshCache.NumModels(), (int)scene->bodies.size() );
 
 	m_mousePosition = Vec2( 0, 0 );
 	m_cameraPositionTheta = acosf( -1.0f ) / 2.0f;
@@ -285,16 +311,22 @@ void Application::Cleanup() {
 	m_copyPipeline.Cleanup( &deviceContext );
 	m_modelFullScreen.Cleanup( deviceContext );
 
+	g_assetArchive.Close();
+
+	// Finishes writing the frames still queued
+	delete m_recorder;
+	m_recorder = NULL;
+
+	delete m_player;
+	m_player = NULL;
+
 	// Delete the screen so that it can clean itself up
 	delete scene;
 	scene = NULL;
 
 	// Delete models
-	for ( int i = 0; i < m_models.size(); i++ ) {
-		m_models[ i ]->Cleanup( deviceContext );
-		delete m_models[ i ];
-	}
 	m_models.clear();
+	m_meshCache.Cleanup( deviceContext );
 
 	// Delete Uniform Buffer Memory
 	m_uniformBuffer.Cleanup( &deviceContext );
@@ -430,6 +462,17 @@ Application::Keyboard
 void Application::Keyboard( int key, int scancode, int action, int modifiers ) {
 	if ( GLFW_KEY_R == key && GLFW_RELEASE == action ) {
 		scene->Reset();
+		m_physicsAccumulator = 0.0f;
+		m_physicsStep = 0;
+		m_replayFrame = 0;
+		m_replayAccumulator = 0.0f;
+	}
+
+	// Scrubbing through a replay, a second at a time, ten with shift
+	if ( NULL != m_player && ( GLFW_KEY_LEFT == key || GLFW_KEY_RIGHT == key ) && ( GLFW_PRESS == action || GLFW_REPEAT == action ) ) {
+		const float seconds = ( modifiers & GLFW_MOD_SHIFT ) ? 10.0f : 1.0f;
+		const int frames = (int)( seconds * m_player->StepsPerSecond() + 0.5f );
+		m_replayFrame += ( GLFW_KEY_LEFT == key ) ? -frames : frames;
 	}
 	if ( GLFW_KEY_T == key && GLFW_RELEASE == action ) {
 		m_isPaused = !m_isPaused;
@@ -465,19 +508,16 @@ void Application::MainLoop() {
 		// Get User Input
 		glfwPollEvents();
 
-		// If the time is greater than 33ms (30fps)
-		// then force the time difference to smaller
-		// to prevent super large simulation steps.
-		if ( dt_us > 33000.0f ) {
-			dt_us = 33000.0f;
-		}
+		const float step_sec = 1.0f / m_physicsRate;
 
 		bool runPhysics = true;
 		if ( m_isPaused ) {
 			dt_us = 0.0f;
 			runPhysics = false;
 			if ( m_stepFrame ) {
-				dt_us = 16667.0f;
+				// Exactly one physics step
+				dt_us = step_sec * 1000000.0f;
+				m_physicsAccumulator = 0.0f;
 				m_stepFrame = false;
 				runPhysics = true;
 			}
@@ -486,12 +526,52 @@ void Application::MainLoop() {
 		}
 		float dt_sec = dt_us * 0.001f * 0.001f;
 
+		// A replay moves through the recording instead of stepping the scene, at the rate it was recorded at
+		if ( NULL != m_player ) {
+			const float replayRate = m_player->StepsPerSecond();
+			const int lastFrame = m_player->NumFrames() - 1;
+			if ( m_isPaused ) {
+				// A paused step is exactly one recorded frame
+				m_replayFrame += runPhysics ? 1 : 0;
+				m_replayAccumulator = 0.0f;
+			} else {
+				m_replayAccumulator += dt_sec;
+				const int frames = (int)( m_replayAccumulator * replayRate );
+				m_replayFrame += frames;
+				m_replayAccumulator -= (float)frames / replayRate;
+			}
+			m_replayFrame = ( m_replayFrame < 0 ) ? 0 : ( ( m_replayFrame > lastFrame ) ? lastFrame : m_replayFrame );
+			m_player->Seek( m_replayFrame );
+			printf( "replay: %.2f / %.2f s", (float)m_replayFrame / replayRate, (float)lastFrame / replayRate );
+			runPhysics = false;
+		}
+
 		// Run Update
 		if ( runPhysics ) {
 			int startTime = GetTimeMicroseconds();
-			for ( int i = 0; i < 2; i++ ) {
-				scene->Update( dt_sec * 0.5f );
+
+			// As many fixed steps as the frame time covers, the remainder carries over to the next frame.
+			// Deterministic runs leave the wall clock out of it and take one step per frame.
+			m_physicsAccumulator += dt_sec;
+			if ( m_isDeterministic ) {
+				m_physicsAccumulator = step_sec;
 			}
+			int numSteps = 0;
+			while ( m_physicsAccumulator >= step_sec && numSteps < MAX_PHYSICS_STEPS_PER_FRAME ) {
+				scene->Update( step_sec );
+				m_physicsAccumulator -= step_sec;
+				numSteps++;
+				m_physicsStep++;
+				m_drawLatestStep = m_isPaused || m_isDeterministic;
+
+				if ( NULL != m_recorder ) {
+					m_recorder->RecordFrame( scene->bodies.data(), (int)scene->bodies.size() );
+				}
+			}
+			if ( m_physicsAccumulator >= step_sec ) {
+				m_physicsAccumulator = fmodf( m_physicsAccumulator, step_sec );
+			}
+
 			int endTime = GetTimeMicroseconds();
 
 			dt_us = (float)endTime - (float)startTime;
@@ -503,6 +583,10 @@ void Application::MainLoop() {
 			numSamples++;
 
 			printf( "frame dt_ms: %.2f %.2f %.2f", avgTime * 0.001f, maxTime * 0.001f, dt_us * 0.001f );
+
+			if ( m_isDeterministic ) {
+				printf( "    step: %d hash: %016llx", m_physicsStep, (unsigned long long)scene->HashState() );
+			}
 		}
 
 		// Draw the Scene
@@ -614,16 +698,31 @@ void Application::UpdateUniforms() {
 		}
 
 		//
-		//	Update the uniform buffer with the body positions/orientations
+		//	Update the uniform buffer with the body positions/orientations,
+		//	blended between the last two physics steps by how far this frame is past the last one,
+		//	or as the last step left them when it was a paused or deterministic one
 		//
+		const float alpha = m_drawLatestStep ? 1.0f : m_physicsAccumulator * m_physicsRate;
+		// Initialize refused recordings of other scenes, so a decoded frame poses every body
+		bool isReplayed = false;
+		if ( NULL != m_player && m_player->GetPoses( m_replayPositions, m_replayOrientations ) >= 0 ) {
+			isReplayed = ( m_replayPositions.size() == scene->bodies.size() );
+		}
 		for ( int i = 0; i < scene->bodies.size(); i++ ) {
-			Body & body = scene->bodies[ i ];
+			Vec3 position;
+			Quat orientation;
+			if ( isReplayed ) {
+				position = m_replayPositions[ i ];
+				orientation = m_replayOrientations[ i ];
+			} else {
+				scene->GetInterpolatedPose( i, alpha, position, orientation );
+			}
 
-			Vec3 fwd = body.orientation.RotatePoint( Vec3( 1, 0, 0 ) );
-			Vec3 up = body.orientation.RotatePoint( Vec3( 0, 0, 1 ) );
+			Vec3 fwd = orientation.RotatePoint( Vec3( 1, 0, 0 ) );
+			Vec3 up = orientation.RotatePoint( Vec3( 0, 0, 1 ) );
 
 			Mat4 matOrient;
-			matOrient.Orient( body.position, fwd, up );
+			matOrient.Orient( position, fwd, up );
 			matOrient = matOrient.Transpose();
 
 			// Update the uniform buffer with the orientation of this body
@@ -633,8 +732,8 @@ void Application::UpdateUniforms() {
 			renderModel.model = m_models[ i ];
 			renderModel.uboByteOffset = uboByteOffset;
 			renderModel.uboByteSize = sizeof( matOrient );
-			renderModel.pos = body.position;
-			renderModel.orient = body.orientation;
+			renderModel.pos = position;
+			renderModel.orient = orientation;
 			m_renderModels.push_back( renderModel );
 
 			uboByteOffset += deviceContext.GetAligendUniformByteOffset( sizeof( matOrient ) );
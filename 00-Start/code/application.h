@@ -26,12 +26,28 @@ Application
 */
 class Application {
 public:
-	Application() : m_isPaused( true ), m_stepFrame( false ) {}
+	Application() : m_isPaused( true ), m_stepFrame( false ), m_physicsRate( 60.0f ), m_physicsAccumulator( 0.0f ), m_drawLatestStep( false ), m_isDeterministic( false ), m_physicsStep( 0 ), m_sceneFile( NULL ), m_recordFile( NULL ), m_recorder( NULL ), m_replayFile( NULL ), m_player( NULL ), m_replayFrame( 0 ), m_replayAccumulator( 0.0f ) {}
 	~Application();
 
 	void Initialize();
 	void MainLoop();
 
+	// Physics steps per second, independent of the frame rate
+	void SetPhysicsRate( const float stepsPerSecond ) { m_physicsRate = stepsPerSecond; }
+
+	// Exactly one physics step per frame, whatever the frame time, with the state hash printed after each
+	void SetDeterministic( const bool isDeterministic ) { m_isDeterministic = isDeterministic; }
+
+	// Scene file to load instead of the built-in scene, see SceneFile.h. Set before Initialize.
+	void SetSceneFile( const char * fileName ) { m_sceneFile = fileName; }
+
+	// Trajectory file to record every step's body poses to, see Trajectory.h. Set before Initialize.
+	void SetRecordFile( const char * fileName ) { m_recordFile = fileName; }
+
+	// Trajectory file to play back instead of simulating, the scene only provides the bodies' shapes.
+	// Set before Initialize.
+	void SetReplayFile( const char * fileName ) { m_replayFile = fileName; }
+
 private:
 	std::vector< const char * > GetGLFWRequiredExtensions() const;
 
@@ -66,7 +82,8 @@ private:
 	//	Model
 	//
 	Model m_modelFullScreen;
-	std::vector< Model * > m_models;	// models for the bodies
+	MeshCache m_meshCache;				// one model per distinct shape
+	std::vector< Model * > m_models;	// the model of each body, from the cache
 
 	//
 	//	Pipeline for copying the offscreen framebuffer to the swapchain
@@ -84,6 +101,36 @@ private:
 	bool m_isPaused;
 	bool m_stepFrame;
 
+	// Physics runs in fixed steps of 1 / m_physicsRate seconds. Frame time piles up in the
+	// accumulator until it covers a step, what is left over says how far drawing is between two steps.
+	float m_physicsRate;
+	float m_physicsAccumulator;
+
+	// Steps forced regardless of frame time, paused and deterministic ones, leave nothing in the
+	// accumulator to go by, so the step taken is drawn as it is until time drives the steps again
+	bool m_drawLatestStep;
+
+	// A frame this far behind drops the time it can't catch up on, rather than falling further behind
+	static const int MAX_PHYSICS_STEPS_PER_FRAME = 4;
+
+	// Steps since the last reset, deterministic runs are compared step by step
+	bool m_isDeterministic;
+	int m_physicsStep;
+
+	const char * m_sceneFile;
+
+	const char * m_recordFile;
+	class TrajectoryRecorder * m_recorder;
+
+	// Replay shows recorded frame m_replayFrame, playing moves on a frame per step of the rate it was
+	// recorded at, with the time short of the next frame kept in the accumulator
+	const char * m_replayFile;
+	class TrajectoryPlayer * m_player;
+	int m_replayFrame;
+	float m_replayAccumulator;
+	std::vector< Vec3 > m_replayPositions;
+	std::vector< Quat > m_replayOrientations;
+
 	std::vector< RenderModel > m_renderModels;
 
 	static const int WINDOW_WIDTH = 1200;
@@ -2,6 +2,10 @@
 //  main.cpp
 //
 #include "application.h"
+#include "AssetArchive.h"
+#include "Scene.h"
+#include "SceneFile.h"
+#include <string.h>
 
 /*
 ====================================================
@@ -9,7 +13,51 @@ main
 ====================================================
 */
 int main( int argc, char * argv[] ) {
+	// --pack-assets, packs the asset directories into the archive loaded at startup, then exits
+	// --save-scene <file>, writes the built-in scene to a scene file for --scene, then exits
+	for ( int i = 1; i < argc; i++ ) {
+		if ( 0 == strcmp( argv[ i ], "--pack-assets" ) ) {
+			const char * directories[] = { "data/shaders/spirv" };
+			return PackAssetArchive( ASSET_ARCHIVE_FILE, directories, sizeof( directories ) / sizeof( directories[ 0 ] ) ) ? 0 : 1;
+		}
+		if ( 0 == strcmp( argv[ i ], "--save-scene" ) && i + 1 < argc ) {
+			Scene * scene = new Scene;
+			scene->Initialize();
+			const bool isSaved = SaveSceneFile( argv[ i + 1 ], *scene );
+			delete scene;
+			return isSaved ? 0 : 1;
+		}
+	}
+
 	application = new Application;
+
+	// --physics-rate <steps per second>, 60 by default
+	// --deterministic, one step per frame and the state hash of every step
+	// --scene <file>, a binary scene file instead of the built-in scene
+	// --record <file>, every step's body poses to a trajectory file
+	// --replay <file>, play a trajectory file back instead of simulating
+	// --loose-assets, loose asset files written after the archive are loaded instead, for working on shaders
+	for ( int i = 1; i < argc; i++ ) {
+		if ( 0 == strcmp( argv[ i ], "--physics-rate" ) && i + 1 < argc && atof( argv[ i + 1 ] ) > 0.0 ) {
+			application->SetPhysicsRate( (float)atof( argv[ i + 1 ] ) );
+		}
+		if ( 0 == strcmp( argv[ i ], "--deterministic" ) ) {
+			application->SetDeterministic( true );
+		}
+		if ( 0 == strcmp( argv[ i ], "--scene" ) && i + 1 < argc ) {
+			application->SetSceneFile( argv[ i + 1 ] );
+		}
+		if ( 0 == strcmp( argv[ i ], "--record" ) && i + 1 < argc ) {
+			application->SetRecordFile( argv[ i + 1 ] );
+		}
+		if ( 0 == strcmp( argv[ i ], "--replay" ) && i + 1 < argc ) {
+			application->SetReplayFile( argv[ i + 1 ] );
+		}
+		if ( 0 == strcmp( argv[ i ], "--loose-assets" ) ) {
+			g_assetArchive.SetCheckLooseFiles( true );
+		}
+	}
+
 	application->Initialize();
 
 	application->MainLoop();